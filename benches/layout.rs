@@ -0,0 +1,71 @@
+use agora_rust::{cpp_alloc_count, LayoutBench, LayoutMode};
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+
+const MODES: [LayoutMode; 3] = [
+    LayoutMode::Default,
+    LayoutMode::BestFit,
+    LayoutMode::VerticalPresentation,
+];
+
+// 17 is the most regions a mixed layout supports; beyond it every mode
+// still has to place the tiles it can.
+const PARTICIPANTS: [u32; 12] = [1, 2, 3, 4, 5, 6, 8, 9, 12, 16, 17, 24];
+
+const ALLOC_SAMPLES: u64 = 1000;
+
+// Criterion reports time per op; allocations are sampled separately and
+// only when built with `--features alloc-counters`.
+fn report_allocs<F: Fn()>(name: &str, mode: LayoutMode, participants: u32, op: F) {
+    let before = match cpp_alloc_count() {
+        Some(count) => count,
+        None => return,
+    };
+    for _ in 0..ALLOC_SAMPLES {
+        op();
+    }
+    let allocs = cpp_alloc_count().unwrap_or(before) - before;
+    println!(
+        "{}/{:?}/{}: {:.2} allocs/op",
+        name,
+        mode,
+        participants,
+        allocs as f64 / ALLOC_SAMPLES as f64
+    );
+}
+
+fn set_video_mix_layout(c: &mut Criterion) {
+    let mut group = c.benchmark_group("set_video_mix_layout");
+    for &mode in MODES.iter() {
+        for &participants in PARTICIPANTS.iter() {
+            let bench = LayoutBench::new(mode, participants);
+            group.bench_with_input(
+                BenchmarkId::new(format!("{:?}", mode), participants),
+                &participants,
+                |b, _| b.iter(|| bench.push()),
+            );
+            report_allocs("set_video_mix_layout", mode, participants, || {
+                bench.push();
+            });
+        }
+    }
+    group.finish();
+}
+
+fn join_leave(c: &mut Criterion) {
+    let mut group = c.benchmark_group("join_leave");
+    for &mode in MODES.iter() {
+        for &participants in PARTICIPANTS.iter() {
+            let bench = LayoutBench::new(mode, participants);
+            group.bench_with_input(
+                BenchmarkId::new(format!("{:?}", mode), participants),
+                &participants,
+                |b, _| b.iter(|| bench.churn()),
+            );
+            report_allocs("join_leave", mode, participants, || bench.churn());
+        }
+    }
+    group.finish();
+}
+
+criterion_group!(benches, set_video_mix_layout, join_leave);
+criterion_main!(benches);
@@ -0,0 +1,34 @@
+use agora_rust::{MembershipBench, MembershipSet};
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+
+const SETS: [MembershipSet; 4] = [
+    MembershipSet::FlatUids,
+    MembershipSet::HashedUids,
+    MembershipSet::FlatAccounts,
+    MembershipSet::TreeAccounts,
+];
+
+// a small whitelist, a large meeting, and a webinar
+const ENTRIES: [usize; 3] = [10, 1_000, 100_000];
+
+// every probe() checks this many uids or accounts
+const PROBES: u64 = 256;
+
+fn membership(c: &mut Criterion) {
+    let mut group = c.benchmark_group("subscription_membership");
+    group.throughput(Throughput::Elements(PROBES));
+    for &set in SETS.iter() {
+        for &entries in ENTRIES.iter() {
+            let bench = MembershipBench::new(set, entries);
+            group.bench_with_input(
+                BenchmarkId::new(format!("{:?}", set), entries),
+                &entries,
+                |b, _| b.iter(|| bench.probe()),
+            );
+        }
+    }
+    group.finish();
+}
+
+criterion_group!(benches, membership);
+criterion_main!(benches);
@@ -21,8 +21,36 @@ fn main() {
     rm.arg("-rf").arg("./Agora_Recording_SDK_for_Linux_FULL");
     rm.status().expect("failed to clean up");
 
-    cpp_build::Config::new()
+    let mut config = cpp_build::Config::new();
+    if env::var_os("CARGO_FEATURE_ALLOC_COUNTERS").is_some() {
+        config.define("AGORA_ALLOC_COUNTERS", None);
+    }
+    config
         .file("src/cpp/agorasdk/AgoraSdk.cpp")
+        .file("src/cpp/agorasdk/LayoutCache.cpp")
+        .file("src/cpp/agorasdk/LayoutSolver.cpp")
+        .file("src/cpp/agorasdk/SlotAssignment.cpp")
+        .file("src/cpp/agorasdk/LayoutScheduler.cpp")
+        .file("src/cpp/agorasdk/TimerQueue.cpp")
+        .file("src/cpp/agorasdk/PeerRoster.cpp")
+        .file("src/cpp/agorasdk/UserDirectory.cpp")
+        .file("src/cpp/agorasdk/SubscriptionSet.cpp")
+        .file("src/cpp/agorasdk/FlatSet.cpp")
+        .file("src/cpp/agorasdk/SubscribeList.cpp")
+        .file("src/cpp/agorasdk/FramePool.cpp")
+        .file("src/cpp/agorasdk/FrameView.cpp")
+        .file("src/cpp/agorasdk/FrameQueue.cpp")
+        .file("src/cpp/agorasdk/MediaAccounting.cpp")
+        .file("src/cpp/agorasdk/MediaRetention.cpp")
+        .file("src/cpp/agorasdk/StubRecordingEngine.cpp")
+        .file("src/cpp/agorasdk/FakeRecordingEngine.cpp")
+        .file("src/cpp/agorasdk/RecorderManager.cpp")
+        .file("src/cpp/agorasdk/EventExecutor.cpp")
+        .file("src/cpp/agorasdk/StatsBatch.cpp")
+        .file("src/cpp/agorasdk/ActiveSpeaker.cpp")
+        .file("src/cpp/agorasdk/TalkAnalytics.cpp")
+        .file("src/cpp/agorasdk/MembershipBench.cpp")
+        .file("src/cpp/agorasdk/AllocCounters.cpp")
         .include("src/cpp/include")
         .include("src/cpp")
         .build("src/lib.rs");
@@ -0,0 +1,112 @@
+#include "ActiveSpeaker.h"
+
+namespace agora {
+
+//levels are kept as 8.8 fixed point and smoothed by 1/4 per indication
+static const uint32_t kLevelShift = 8;
+static const uint32_t kSmoothShift = 2;
+
+ActiveSpeakerTracker::ActiveSpeakerTracker() :
+  m_speaker(0)
+  , m_speakerSince(0)
+  , m_challenger(0)
+  , m_challengerSince(0)
+  , m_switches(0)
+{
+}
+
+ActiveSpeakerTracker::Level* ActiveSpeakerTracker::find(agora::linuxsdk::uid_t uid) {
+  for (size_t i = 0; i < m_levels.size(); i++) {
+    if (m_levels[i].m_uid == uid)
+      return &m_levels[i];
+  }
+  return NULL;
+}
+
+uint32_t ActiveSpeakerTracker::level(agora::linuxsdk::uid_t uid) {
+  Level *entry = find(uid);
+  return entry ? entry->m_level : 0;
+}
+
+bool ActiveSpeakerTracker::addVolumes(const agora::linuxsdk::AudioVolumeInfo *speakers, unsigned int speakerNum, uint64_t nowMs) {
+  if (!speakers)
+    speakerNum = 0;
+
+  //everyone not in the indication is treated as silent and decays
+  for (size_t i = 0; i < m_levels.size(); i++)
+    m_levels[i].m_level -= m_levels[i].m_level >> kSmoothShift;
+  for (unsigned int i = 0; i < speakerNum; i++) {
+    if (speakers[i].uid == 0)
+      continue;
+    Level *entry = find(speakers[i].uid);
+    if (!entry) {
+      Level added = { speakers[i].uid, 0 };
+      m_levels.push_back(added);
+      entry = &m_levels.back();
+    }
+    entry->m_level += (speakers[i].volume << kLevelShift) >> kSmoothShift;
+  }
+
+  const Level *loudest = NULL;
+  for (size_t i = 0; i < m_levels.size(); i++) {
+    if (!loudest || m_levels[i].m_level > loudest->m_level)
+      loudest = &m_levels[i];
+  }
+  if (!loudest || loudest->m_level == 0)
+    return false;
+  return propose(loudest->m_uid, true, nowMs);
+}
+
+bool ActiveSpeakerTracker::addActiveSpeaker(agora::linuxsdk::uid_t uid, uint64_t nowMs) {
+  if (uid == 0)
+    return false;
+  return propose(uid, false, nowMs);
+}
+
+bool ActiveSpeakerTracker::propose(agora::linuxsdk::uid_t uid, bool checkMargin, uint64_t nowMs) {
+  if (uid == m_speaker) {
+    m_challenger = 0;
+    return false;
+  }
+  if (uid != m_challenger) {
+    m_challenger = uid;
+    m_challengerSince = nowMs;
+  }
+
+  if (m_speaker != 0) {
+    if (nowMs - m_speakerSince < m_tuning.m_dwellMs || nowMs - m_challengerSince < m_tuning.m_holdMs)
+      return false;
+    if (checkMargin && level(uid) < level(m_speaker) + (m_tuning.m_margin << kLevelShift))
+      return false;
+  }
+
+  m_speaker = uid;
+  m_speakerSince = nowMs;
+  m_challenger = 0;
+  m_switches++;
+  return true;
+}
+
+bool ActiveSpeakerTracker::remove(agora::linuxsdk::uid_t uid) {
+  for (size_t i = 0; i < m_levels.size(); i++) {
+    if (m_levels[i].m_uid == uid) {
+      m_levels[i] = m_levels.back();
+      m_levels.pop_back();
+      break;
+    }
+  }
+  if (uid == m_challenger)
+    m_challenger = 0;
+  if (uid != m_speaker)
+    return false;
+  m_speaker = 0;
+  return true;
+}
+
+void ActiveSpeakerTracker::clear() {
+  m_levels.clear();
+  m_speaker = 0;
+  m_challenger = 0;
+}
+
+}
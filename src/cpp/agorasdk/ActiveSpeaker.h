@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "IAgoraLinuxSdkCommon.h"
+
+namespace agora {
+
+struct ActiveSpeakerTuning {
+    //shortest time a speaker keeps the large tile once given it
+    uint32_t m_dwellMs;
+    //how long a challenger has to stay loudest before it takes over
+    uint32_t m_holdMs;
+    //smoothed volume (0-255) a challenger needs above the current speaker
+    uint32_t m_margin;
+    ActiveSpeakerTuning():
+        m_dwellMs(3000),
+        m_holdMs(1000),
+        m_margin(16)
+    {};
+};
+
+//Picks the dominant speaker from volume indications and the SDK's own active
+//speaker callbacks. Volumes are smoothed per uid, and the speaker only changes
+//once the current one has held the tile for m_dwellMs and a challenger has led
+//for m_holdMs by at least m_margin, so short interjections and crosstalk don't
+//flip the layout. Each update returns true only when the speaker changed.
+//Not thread safe; AgoraSdk calls it under its layout mutex.
+class ActiveSpeakerTracker {
+    public:
+        ActiveSpeakerTracker();
+
+        void setTuning(const ActiveSpeakerTuning &tuning) { m_tuning = tuning; }
+        const ActiveSpeakerTuning& tuning() const { return m_tuning; }
+
+        bool addVolumes(const agora::linuxsdk::AudioVolumeInfo *speakers, unsigned int speakerNum, uint64_t nowMs);
+        //The SDK already applies its own threshold, so the margin is skipped.
+        bool addActiveSpeaker(agora::linuxsdk::uid_t uid, uint64_t nowMs);
+        //A departing speaker gives up the tile straight away.
+        bool remove(agora::linuxsdk::uid_t uid);
+        void clear();
+
+        //0 until someone has spoken.
+        agora::linuxsdk::uid_t speaker() const { return m_speaker; }
+        uint64_t switches() const { return m_switches; }
+
+    private:
+        struct Level {
+            agora::linuxsdk::uid_t m_uid;
+            uint32_t m_level;
+        };
+
+        Level* find(agora::linuxsdk::uid_t uid);
+        uint32_t level(agora::linuxsdk::uid_t uid);
+        bool propose(agora::linuxsdk::uid_t uid, bool checkMargin, uint64_t nowMs);
+
+        ActiveSpeakerTuning m_tuning;
+        //a handful of entries per channel, so a flat vector beats a map
+        std::vector<Level> m_levels;
+        agora::linuxsdk::uid_t m_speaker;
+        uint64_t m_speakerSince;
+        agora::linuxsdk::uid_t m_challenger;
+        uint64_t m_challengerSince;
+        uint64_t m_switches;
+};
+
+}
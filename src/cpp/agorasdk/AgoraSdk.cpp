@@ -6,6 +6,9 @@
 #include <vector> 
 #include <algorithm> 
 #include <stdlib.h>
+#include <string.h>
+#include <functional>
+#include <chrono>
 #include "../include/IAgoraLinuxSdkCommon.h"
 #include "../include/IAgoraRecordingEngine.h"
 #include "AgoraSdk.h"
@@ -14,32 +17,42 @@
 #include "base/opt_parser.h" 
 #include "base/time_util.h"
 namespace agora {
-void SplitString(const std::string& s, std::set<std::string>& v, const std::string& c)
-{
-  std::string::size_type pos1, pos2;
-  pos2 = s.find(c);
-  pos1 = 0;
-  while(std::string::npos != pos2)
-  {
-    v.insert(s.substr(pos1, pos2-pos1));
- 
-    pos1 = pos2 + c.size();
-    pos2 = s.find(c, pos1);
-  }
-  if(pos1 != s.length())
-    v.insert(s.substr(pos1));
+
+static void reportMalformed(const char *name, const char *list, const ListParseReport &report) {
+  if (report.m_malformed == 0)
+    return;
+  printf("%s: ignored %zu malformed entries, first \"%.*s\"\n", name, report.m_malformed,
+      static_cast<int>(report.m_firstMalformed.m_length), list + report.m_firstMalformed.m_offset);
+}
+
+//subscription changes closer together than this reach the engine as one update
+static const uint32_t kSubscribeDebounceMs = 50;
+//how often volume indications publish the talk stats snapshot
+static const uint32_t kTalkSnapshotMs = 1000;
+
+static uint64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 AgoraSdk::AgoraSdk() :
-    m_level(agora::linuxsdk::AGORA_LOG_LEVEL_INFO)
+    m_handler(nullptr)
+    , m_joined(false)
+    , m_level(agora::linuxsdk::AGORA_LOG_LEVEL_INFO)
     , m_mediaKeepTime(0)
     , m_lastAudioKeepTime(0)
     , m_lastVideoKeepTime(0)
-    , m_subscribedVideoUids()
-    , m_subscribedAudioUids()
-    , m_handler(nullptr)
+    , m_subscribeUpdates(0)
     , m_keepLastFrame(false)
-    
+    , m_talkSnapshotInterval(kTalkSnapshotMs)
+    , m_talkPublishedMs(0)
+    , m_stableSlots(false)
+    , m_layoutApplied(0)
+    , m_layoutSuppressed(0)
+    , m_framePool(FramePool::shared())
+    , m_eventExecutor(EventExecutor::shared())
+    , m_frameQueue(NULL)
+    , m_useFakeEngine(false)
 {
   m_engine = NULL;
   m_stopped = false;
@@ -54,12 +67,32 @@ AgoraSdk::AgoraSdk() :
     m_mediaKeepTime = time >= 0 ? time : 0;
     printf("get media keep time from env with value : %d\n", m_mediaKeepTime);
   }
+  m_mediaRetention.setKeepTime(m_mediaKeepTime);
+  env = getenv("AGORA_FAKE_USERS");
+  if (env) {
+    int users = (int)strtol(env, NULL, 0);
+    m_fakeEngineConfig.m_users = users >= 0 ? users : 0;
+    m_useFakeEngine = true;
+    printf("use fake recording engine with %u users from env\n", m_fakeEngineConfig.m_users);
+  }
+  m_layoutScheduler.setCallback(std::bind(&AgoraSdk::setVideoMixLayout, this));
+  m_subscribeScheduler.setCallback(std::bind(&AgoraSdk::flushSubscriptions, this));
+  m_subscribeScheduler.setWindow(kSubscribeDebounceMs);
+  memset(&m_talkChannel, 0, sizeof(m_talkChannel));
+  m_talkSnapshot.reserve(TalkAnalytics::kMaxUids);
 }
 
 AgoraSdk::~AgoraSdk() {
+  m_layoutScheduler.stop();
+  m_subscribeScheduler.stop();
   if (m_engine) {
     m_engine->release();
   }
+  FrameQueue *queue = m_frameQueue.exchange(NULL);
+  if (queue) {
+    queue->close();
+    queue->release();
+  }
 }
 
 bool AgoraSdk::stopped() const {
@@ -67,16 +100,60 @@ bool AgoraSdk::stopped() const {
 }
 
 bool AgoraSdk::release() {
+  m_layoutScheduler.stop();
+  m_subscribeScheduler.stop();
   if (m_engine) {
     m_engine->release();
     m_engine = NULL;
   }
+  {
+    std::lock_guard<std::mutex> lock(m_appliedMutex);
+    m_appliedLayout.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_directoryMutex);
+    m_directory.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_talkMutex);
+    m_talk.clear();
+    m_talkSnapshot.clear();
+    memset(&m_talkChannel, 0, sizeof(m_talkChannel));
+    m_talkPublishedMs = 0;
+  }
+  m_joined = false;
 
   return true;
 }
 
-uint32_t stringToUint(const std::string& str) {
-  return static_cast<uint32_t>(strtol(str.c_str(), NULL, 10));
+//The engine joins with the config's list; returns whether changes made before
+//the join are still waiting to be sent on top of it.
+bool AgoraSdk::addConfigSubscriptions(const char *name, const char *uids, SubscriptionSet &set) {
+  bool queued = !set.flushed();
+  if (uids) {
+    ListParseReport report;
+    std::vector<agora::linuxsdk::uid_t> parsed;
+    parseUidList(uids, strlen(uids), parsed, report);
+    reportMalformed(name, uids, report);
+    set.add(parsed.data(), parsed.size());
+  }
+  if (!queued)
+    set.markFlushed(set.version());
+  return queued;
+}
+
+bool AgoraSdk::attachEngine(agora::recording::IRecordingEngine *engine) {
+  if (m_engine || !engine)
+    return false;
+  m_engine = engine;
+  m_engine->setLogLevel(m_level);
+  return true;
+}
+
+agora::recording::IRecordingEngine* AgoraSdk::createEngine(const string &appid) {
+  if (m_useFakeEngine)
+    return new FakeRecordingEngine(m_handler, m_fakeEngineConfig);
+  return agora::recording::IRecordingEngine::createAgoraRecordingEngine(appid.c_str(), m_handler);
 }
 
 bool AgoraSdk::createChannel(const string &appid, const string &channelKey, const string &name,
@@ -86,32 +163,35 @@ bool AgoraSdk::createChannel(const string &appid, const string &channelKey, cons
   if (m_engine)
     return false;
 
-  if ((m_engine = agora::recording::IRecordingEngine::createAgoraRecordingEngine(appid.c_str(), this->m_handler)) == NULL)
+  if ((m_engine = createEngine(appid)) == NULL)
       return false;
 
   m_engine->setLogLevel(m_level);
+  //stopped by the last leaveChannel or release
+  m_layoutScheduler.start();
+  m_subscribeScheduler.start();
 
-  int ret = m_engine->joinChannel(channelKey.c_str(), name.c_str(), uid, config);
-  if(linuxsdk::ERR_OK != ret)
-      return false;
+  //callbacks may start before joinChannel returns, so the subscriptions
+  //and config they read are set up first
+  bool queued = false;
   if (!config.autoSubscribe) {
-      if (config.subscribeVideoUids) {
-        std::set<std::string> struids;
-        SplitString(config.subscribeVideoUids, struids, ",");
-        auto it = m_subscribedVideoUids.begin();
-        std::transform(struids.begin(), struids.end(), std::inserter(m_subscribedVideoUids, it), stringToUint);
-      }
-      if (config.subscribeAudioUids) {
-        std::set<std::string> struids;
-        SplitString(config.subscribeAudioUids, struids, ",");
-        auto it = m_subscribedAudioUids.begin();
-        std::transform(struids.begin(), struids.end(), std::inserter(m_subscribedAudioUids, it), stringToUint);
-      }
+      queued = addConfigSubscriptions("subscribeVideoUids", config.subscribeVideoUids, m_videoSubscriptions);
+      queued = addConfigSubscriptions("subscribeAudioUids", config.subscribeAudioUids, m_audioSubscriptions) || queued;
     }
 
   //m_engine->setUserBackground(30000, "test.jpg");
 
   m_config = config;
+  setTalkInterval();
+  refreshPeerVisibility();
+
+  int ret = m_engine->joinChannel(channelKey.c_str(), name.c_str(), uid, config);
+  if(linuxsdk::ERR_OK != ret)
+      return false;
+  m_joined = true;
+  //changes made before the join go out on top of the config's lists
+  if (queued)
+    m_subscribeScheduler.schedule();
   return true;
 }
 
@@ -120,34 +200,45 @@ bool AgoraSdk::createChannelWithUserAccount(const string &appid, const string &c
   if (m_engine)
     return false;
 
-  if ((m_engine = agora::recording::IRecordingEngine::createAgoraRecordingEngine(appid.c_str(), this->m_handler)) == NULL)
+  if ((m_engine = createEngine(appid)) == NULL)
       return false;
 
   m_engine->setLogLevel(m_level);
-
-  if(linuxsdk::ERR_OK != m_engine->joinChannelWithUserAccount(channelKey.c_str(), name.c_str(), userAccount.c_str(), config))
-      return false;
+  //stopped by the last leaveChannel or release
+  m_layoutScheduler.start();
+  m_subscribeScheduler.start();
 
   //m_engine->setUserBackground(30000, "test.jpg");
   if (!config.autoSubscribe) {
       if (config.subscribeVideoUids) {
-        SplitString(config.subscribeVideoUids, m_subscribeVideoUserAccount, ",");
+        reportMalformed("subscribeVideoUids", config.subscribeVideoUids,
+            m_subscribeVideoUserAccount.assign(config.subscribeVideoUids));
       }
       if (config.subscribeAudioUids) {
-        SplitString(config.subscribeAudioUids, m_subscribeAudioUserAccount, ",");
+        reportMalformed("subscribeAudioUids", config.subscribeAudioUids,
+            m_subscribeAudioUserAccount.assign(config.subscribeAudioUids));
       }
     }
 
   m_config = config;
   m_userAccount = userAccount;
+  setTalkInterval();
+  refreshPeerVisibility();
+
+  if(linuxsdk::ERR_OK != m_engine->joinChannelWithUserAccount(channelKey.c_str(), name.c_str(), userAccount.c_str(), config))
+      return false;
+  m_joined = true;
   return true;
 }
 
 
 bool AgoraSdk::leaveChannel() {
+  m_layoutScheduler.stop();
+  m_subscribeScheduler.stop();
   if (m_engine) {
     m_engine->leaveChannel();
     m_stopped = true;
+    m_joined = false;
   }
 
   return true;
@@ -157,6 +248,7 @@ bool AgoraSdk::stoppedOnError() {
   if (m_engine) {
     m_engine->stoppedOnError();
     m_stopped = true;
+    m_joined = false;
   }
 
   return true;
@@ -176,6 +268,22 @@ int AgoraSdk::stopService() {
   return 1;
 }
 
+//Tile size class of a layout: two layouts with the same smallest tile only
+//differ in where the tiles sit
+static double smallestTileArea(const LayoutTemplate &layoutTemplate) {
+  double smallest = 0;
+  for (size_t i = 0; i < layoutTemplate.m_regions.size(); i++) {
+    double area = layoutTemplate.m_regions[i].width * layoutTemplate.m_regions[i].height;
+    if (i == 0 || area < smallest)
+      smallest = area;
+  }
+  return smallest;
+}
+
+static bool isEmptyRegion(const agora::linuxsdk::VideoMixingLayout::Region &region) {
+  return region.uid == 0;
+}
+
 //Customize the layout of video under video mixing model
 int AgoraSdk::setVideoMixLayout()
 {
@@ -183,36 +291,52 @@ int AgoraSdk::setVideoMixLayout()
     //size_t max_peers = pConfig->channelProfile == linuxsdk::CHANNEL_PROFILE_COMMUNICATION ? 7:17;
     if(!m_mixRes.m_videoMix) return 0;
 
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
+
     LAYOUT_MODE_TYPE layout_mode = m_layoutMode;
     uint32_t maxResolutionUid = 0;
     if (m_userAccount.length() > 0) {
-      maxResolutionUid = getUidByUserAccount(m_maxVertPreLayoutUserAccount.c_str());
+      std::lock_guard<std::mutex> directoryLock(m_directoryMutex);
+      maxResolutionUid = m_directory.uid(m_maxVertPreLayoutUserAccount.c_str(), m_maxVertPreLayoutUserAccount.length());
     } else {
       maxResolutionUid = m_maxVertPreLayoutUid;
     }
+    //Same geometry as vertical presentation, so it shares its templates; the
+    //configured uid keeps the tile until someone speaks
+    if (layout_mode == ACTIVESPEAKER_LAYOUT) {
+      layout_mode = VERTICALPRESENTATION_LAYOUT;
+      if (m_activeSpeaker.speaker() != 0)
+        maxResolutionUid = m_activeSpeaker.speaker();
+    }
 
-    std::vector<agora::linuxsdk::uid_t> subscribedUids;
-    if (m_userAccount.length() > 0) {
-      for (std::vector<agora::linuxsdk::uid_t>::iterator it = m_peers.begin(); it != m_peers.end(); ++it) {
-        if (m_config.autoSubscribe || (m_subscribedVideoUids.find(*it) != m_subscribedVideoUids.end())) {
-          if (m_layoutMode == VERTICALPRESENTATION_LAYOUT) {
-            char userAccount[256] = {0};
-            uint32_t len = getUserAccountByUid(*it, userAccount, 256);
-            if(len != 0 || 0 != maxResolutionUid) {
-              subscribedUids.push_back(*it);
-            }
-          } else {
-            subscribedUids.push_back(*it);
-          }
-        }
+    //The roster keeps the subscribed peers in join order; only the user account
+    //check for vertical presentation and active speaker still needs a per-peer
+    //pass, and it is answered from the directory rather than the engine
+    const std::vector<agora::linuxsdk::uid_t>* visibleUids = &m_peers.visible();
+    if (m_userAccount.length() > 0 && layout_mode == VERTICALPRESENTATION_LAYOUT && 0 == maxResolutionUid) {
+      std::lock_guard<std::mutex> directoryLock(m_directoryMutex);
+      m_layoutUids.clear();
+      for (std::vector<agora::linuxsdk::uid_t>::const_iterator it = visibleUids->begin(); it != visibleUids->end(); ++it) {
+        if (m_directory.contains(*it))
+          m_layoutUids.push_back(*it);
       }
-    } else {
-      for (std::vector<agora::linuxsdk::uid_t>::iterator it = m_peers.begin(); it != m_peers.end(); ++it) {
-        if (m_config.autoSubscribe || (m_subscribedVideoUids.find(*it) != m_subscribedVideoUids.end())) {
-          subscribedUids.push_back(*it);
-        }
+      visibleUids = &m_layoutUids;
+    }
+    //In stable slot mode the layout is laid out over the slots, holes included,
+    //and the holes are left out of the regions sent to the engine
+    if (m_stableSlots) {
+      const std::vector<agora::linuxsdk::uid_t>& slots = m_slots.assign(*visibleUids);
+      if (m_slots.holes() > 0 && !visibleUids->empty()) {
+        const LayoutTemplate& sparse = getLayoutTemplate(layout_mode, maxResolutionUid, slots);
+        const LayoutTemplate& dense = getLayoutTemplate(layout_mode, maxResolutionUid, *visibleUids);
+        if (smallestTileArea(sparse) != smallestTileArea(dense))
+          m_slots.compact();
+      } else if (visibleUids->empty()) {
+        m_slots.clear();
       }
+      visibleUids = &m_slots.slots();
     }
+    const std::vector<agora::linuxsdk::uid_t>& subscribedUids = *visibleUids;
     //CM_LOG_DIR(m_logdir.c_str(), INFO, "setVideoMixLayout: user size: %d, keepLastFrame : %d, subscribed size : %d, permitted max_peers:%d, layout mode:%d, maxResolutionUid:%ld", m_peers.size(), m_keepLastFrame, subscribedUids.size(), max_peers, layout_mode, maxResolutionUid);
 
     agora::linuxsdk::VideoMixingLayout layout;
@@ -226,17 +350,16 @@ int AgoraSdk::setVideoMixLayout()
     if (!subscribedUids.empty()) {
 
         //CM_LOG_DIR(m_logdir.c_str(), INFO, "setVideoMixLayout: peers not empty");
-        agora::linuxsdk::VideoMixingLayout::Region * regionList = new agora::linuxsdk::VideoMixingLayout::Region[subscribedUids.size()];
-        if(layout_mode == BESTFIT_LAYOUT) {
-            adjustBestFitVideoLayout(regionList, subscribedUids);
-        }else if(layout_mode == VERTICALPRESENTATION_LAYOUT) {
-
-            adjustVerticalPresentationLayout(maxResolutionUid, regionList, subscribedUids);
-        }else {
-            adjustDefaultVideoLayout(regionList, subscribedUids);
+        //Geometry only depends on the layout key, so it is generated once and the uids are copied in
+        const LayoutTemplate& layoutTemplate = getLayoutTemplate(layout_mode, maxResolutionUid, subscribedUids);
+        m_layoutRegions.resize(subscribedUids.size());
+        layoutTemplate.apply(subscribedUids, &m_layoutRegions[0]);
+        if (m_stableSlots && m_slots.holes() > 0) {
+          m_layoutRegions.erase(std::remove_if(m_layoutRegions.begin(), m_layoutRegions.end(), isEmptyRegion),
+              m_layoutRegions.end());
+          layout.regionCount = static_cast<uint32_t>(m_layoutRegions.size());
         }
-        layout.regions = regionList;
-
+        layout.regions = &m_layoutRegions[0];
     }
     else {
         layout.regions = NULL;
@@ -271,11 +394,318 @@ int AgoraSdk::setVideoMixLayout()
     layout.wm_configs = config;
 
     */
-    int res = setVideoMixingLayout(layout);
-    if(layout.regions)
-        delete []layout.regions;
+    return pushVideoMixingLayout(layout, true);
+}
+
+const LayoutTemplate& AgoraSdk::getLayoutTemplate(LAYOUT_MODE_TYPE layoutMode, unsigned int maxResolutionUid,
+    const std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
+    LayoutKey key;
+    key.m_mode = layoutMode;
+    key.m_count = static_cast<uint32_t>(subscribedUids.size());
+    if (layoutMode == VERTICALPRESENTATION_LAYOUT && maxResolutionUid != 0) {
+        std::vector<agora::linuxsdk::uid_t>::const_iterator it = std::find(subscribedUids.begin(), subscribedUids.end(), maxResolutionUid);
+        key.m_maxSlot = it != subscribedUids.end() ? static_cast<int>(it - subscribedUids.begin()) : -1;
+    } else if (layoutMode != BESTFIT_LAYOUT) {
+        key.m_canvasWidth = m_mixRes.m_width;
+        key.m_canvasHeight = m_mixRes.m_height;
+    }
+
+    const LayoutTemplate* cached = m_layoutCache.find(key);
+    if (cached)
+        return *cached;
+
+    LayoutTemplate& layoutTemplate = m_layoutCache.insert(key);
+    //Tiles keep the canvas' shape, so the solved geometry only depends on the count
+    if(layoutMode == BESTFIT_LAYOUT) {
+        solveBestFitLayout(key.m_count, layoutTemplate);
+        return layoutTemplate;
+    }else if(layoutMode == VERTICALPRESENTATION_LAYOUT) {
+        solvePresentationLayout(key.m_count, key.m_maxSlot, layoutTemplate);
+        return layoutTemplate;
+    }
+
+    //Run the layout once with placeholder uids (slot index + 1) and record which slot fills each region
+    std::vector<agora::linuxsdk::uid_t> placeholders(key.m_count);
+    for (size_t i=0; i<placeholders.size(); i++) {
+        placeholders[i] = static_cast<agora::linuxsdk::uid_t>(i + 1);
+    }
 
-    return res;
+    layoutTemplate.m_regions.assign(key.m_count, agora::linuxsdk::VideoMixingLayout::Region());
+    agora::linuxsdk::VideoMixingLayout::Region * regionList = &layoutTemplate.m_regions[0];
+    adjustDefaultVideoLayout(regionList, placeholders);
+
+    layoutTemplate.m_source.resize(key.m_count);
+    for (size_t i=0; i<layoutTemplate.m_regions.size(); i++) {
+        layoutTemplate.m_source[i] = static_cast<int>(regionList[i].uid) - 1;
+        regionList[i].uid = 0;
+    }
+    return layoutTemplate;
+}
+
+void AgoraSdk::scheduleVideoMixLayout()
+{
+    if(!m_mixRes.m_videoMix) return;
+    m_layoutScheduler.schedule();
+}
+
+void AgoraSdk::addPeer(agora::linuxsdk::uid_t uid)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_layoutMutex);
+        if (!m_peers.add(uid, isVideoSubscribed(uid)))
+            return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_talkMutex);
+        m_talk.join(uid, steadyMs());
+    }
+    scheduleVideoMixLayout();
+}
+
+size_t AgoraSdk::getPeerCount()
+{
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
+    return m_peers.size();
+}
+
+void AgoraSdk::removePeer(agora::linuxsdk::uid_t uid)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_layoutMutex);
+        if (!m_peers.remove(uid))
+            return;
+        m_activeSpeaker.remove(uid);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_talkMutex);
+        m_talk.leave(uid, steadyMs());
+    }
+    scheduleVideoMixLayout();
+}
+
+void AgoraSdk::activeSpeaker(agora::linuxsdk::uid_t uid)
+{
+    uint64_t now = steadyMs();
+    {
+        std::lock_guard<std::mutex> lock(m_layoutMutex);
+        if (m_layoutMode != ACTIVESPEAKER_LAYOUT || !m_peers.contains(uid))
+            return;
+        if (!m_activeSpeaker.addActiveSpeaker(uid, now))
+            return;
+    }
+    scheduleVideoMixLayout();
+}
+
+void AgoraSdk::audioVolumeIndication(const agora::linuxsdk::AudioVolumeInfo *speakers, unsigned int speakerNum)
+{
+    uint64_t now = steadyMs();
+    {
+        std::lock_guard<std::mutex> lock(m_talkMutex);
+        m_talk.addVolumes(speakers, speakerNum, now);
+        if (m_talkPublishedMs == 0 || now - m_talkPublishedMs >= m_talkSnapshotInterval) {
+            //reserved for kMaxUids up front, so this never allocates
+            m_talkSnapshot.resize(m_talk.size());
+            m_talk.snapshot(m_talkSnapshot.data(), m_talkSnapshot.size(), m_talkChannel, now);
+            m_talkPublishedMs = now;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_layoutMutex);
+        if (m_layoutMode != ACTIVESPEAKER_LAYOUT)
+            return;
+        if (!m_activeSpeaker.addVolumes(speakers, speakerNum, now))
+            return;
+    }
+    scheduleVideoMixLayout();
+}
+
+void AgoraSdk::setTalkInterval()
+{
+    std::lock_guard<std::mutex> lock(m_talkMutex);
+    m_talk.setInterval(m_config.audioIndicationInterval > 0 ? m_config.audioIndicationInterval : 0);
+}
+
+void AgoraSdk::setTalkThreshold(uint32_t volume)
+{
+    std::lock_guard<std::mutex> lock(m_talkMutex);
+    m_talk.setThreshold(volume);
+}
+
+void AgoraSdk::setTalkSnapshotInterval(uint32_t intervalMs)
+{
+    std::lock_guard<std::mutex> lock(m_talkMutex);
+    m_talkSnapshotInterval = intervalMs;
+}
+
+size_t AgoraSdk::getTalkStats(TalkUserStats *entries, size_t max, TalkChannelStats &channel)
+{
+    std::lock_guard<std::mutex> lock(m_talkMutex);
+    channel = m_talkChannel;
+    size_t count = m_talkSnapshot.size() < max ? m_talkSnapshot.size() : max;
+    if (count > 0)
+        memcpy(entries, m_talkSnapshot.data(), count * sizeof(TalkUserStats));
+    return m_talkSnapshot.size();
+}
+
+void AgoraSdk::setActiveSpeakerTuning(const ActiveSpeakerTuning &tuning)
+{
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
+    m_activeSpeaker.setTuning(tuning);
+}
+
+agora::linuxsdk::uid_t AgoraSdk::getActiveSpeaker()
+{
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
+    return m_activeSpeaker.speaker();
+}
+
+uint64_t AgoraSdk::getActiveSpeakerSwitches()
+{
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
+    return m_activeSpeaker.switches();
+}
+
+void AgoraSdk::setStableLayoutSlots(bool stable)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_layoutMutex);
+        if (m_stableSlots == stable)
+            return;
+        m_stableSlots = stable;
+        m_slots.clear();
+    }
+    scheduleVideoMixLayout();
+}
+
+uint64_t AgoraSdk::getLayoutCompactionCount()
+{
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
+    return m_slots.compactions();
+}
+
+size_t AgoraSdk::getLayoutTemplateCount()
+{
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
+    return m_layoutCache.size();
+}
+
+bool AgoraSdk::isVideoSubscribed(agora::linuxsdk::uid_t uid) const
+{
+    return m_config.autoSubscribe || SubscriptionSet::Reader(m_videoSubscriptions)->contains(uid);
+}
+
+void AgoraSdk::refreshPeerVisibility()
+{
+    std::lock_guard<std::mutex> lock(m_layoutMutex);
+    m_peers.members(m_peerUids);
+    m_peerVisible.resize(m_peerUids.size());
+    if (m_config.autoSubscribe) {
+        std::fill(m_peerVisible.begin(), m_peerVisible.end(), 1);
+    } else {
+        SubscriptionSet::Reader subscribed(m_videoSubscriptions);
+        subscribed->m_uids.containsBatch(m_peerUids.data(), m_peerUids.size(), m_peerVisible.data());
+    }
+    for (size_t i = 0; i < m_peerUids.size(); i++)
+        m_peers.setVisible(m_peerUids[i], m_peerVisible[i] != 0);
+}
+
+int AgoraSdk::changeSubscriptions(SubscriptionSet &set, bool video, bool subscribe, const uint32_t *uids, uint32_t num)
+{
+    if (!uids && num > 0)
+        return -1;
+    size_t changed = subscribe ? set.add(uids, num) : set.remove(uids, num);
+    if (changed == 0)
+        return 0;
+    if (video && !m_config.autoSubscribe) {
+        bool relayout = false;
+        {
+            std::lock_guard<std::mutex> lock(m_layoutMutex);
+            for (uint32_t i = 0; i < num; i++)
+                relayout = m_peers.setVisible(uids[i], subscribe) || relayout;
+        }
+        if (relayout)
+            scheduleVideoMixLayout();
+    }
+    m_subscribeScheduler.schedule();
+    return 0;
+}
+
+int AgoraSdk::flushSubscriptions()
+{
+    if (!m_engine || !m_joined)
+        return -1;
+    int ret = 0;
+    std::vector<agora::linuxsdk::uid_t> uids;
+    uint64_t version = 0;
+    if (m_videoSubscriptions.pending(uids, version)) {
+        int videoRet = m_engine->updateSubscribeVideoUids(uids.data(), static_cast<uint32_t>(uids.size()));
+        m_subscribeUpdates++;
+        if (videoRet == linuxsdk::ERR_OK)
+            m_videoSubscriptions.markFlushed(version);
+        else
+            ret = videoRet;
+    }
+    if (m_audioSubscriptions.pending(uids, version)) {
+        int audioRet = m_engine->updateSubscribeAudioUids(uids.data(), static_cast<uint32_t>(uids.size()));
+        m_subscribeUpdates++;
+        if (audioRet == linuxsdk::ERR_OK)
+            m_audioSubscriptions.markFlushed(version);
+        else
+            ret = audioRet;
+    }
+    return ret;
+}
+
+size_t AgoraSdk::getSubscribedUids(bool video, uint32_t *uids, size_t max, uint64_t *version) const
+{
+    SubscriptionSet::Reader subscribed(video ? m_videoSubscriptions : m_audioSubscriptions);
+    if (version)
+        *version = subscribed->m_version;
+    const std::vector<agora::linuxsdk::uid_t> &subscribedUids = subscribed->m_uids.uids();
+    size_t count = std::min(max, subscribedUids.size());
+    std::copy(subscribedUids.begin(), subscribedUids.begin() + count, uids);
+    return subscribedUids.size();
+}
+
+void AgoraSdk::setLayoutDebounceTime(uint32_t window_ms)
+{
+    m_layoutScheduler.setWindow(window_ms);
+}
+
+bool AgoraSdk::attachFrameQueue(FrameQueue *queue)
+{
+    //frame callbacks read the pointer without locking, so it is set only once
+    FrameQueue *expected = NULL;
+    if (!queue || !m_frameQueue.compare_exchange_strong(expected, queue))
+        return false;
+    queue->retain();
+    return true;
+}
+
+void AgoraSdk::videoFrameReceived(unsigned int uid, const VideoFrameView &view) const
+{
+    m_mediaAccounting.addVideoFrame(uid, view.frame_ms, videoFramePayloadSize(view));
+    if (m_mediaRetention.retainVideo(uid, view))
+        m_lastVideoKeepTime = view.frame_ms;
+    if (FrameQueue *queue = getFrameQueue())
+        queue->pushVideo(uid, view);
+}
+
+void AgoraSdk::audioFrameReceived(unsigned int uid, const AudioFrameView &view) const
+{
+    m_mediaAccounting.addAudioFrame(uid, view.frame_ms, view.buf_size, view.channels);
+    if (m_mediaRetention.retainAudio(uid, view))
+        m_lastAudioKeepTime = view.frame_ms;
+    if (FrameQueue *queue = getFrameQueue())
+        queue->pushAudio(uid, view);
+}
+
+FrameBuffer* AgoraSdk::dumpRecentMedia(unsigned int uid, uint32_t window_ms, std::vector<RetainedFrame> &frames) const
+{
+    //measure the window back from the newest retained frame of any uid
+    uint64_t newest = std::max(m_lastAudioKeepTime.load(), m_lastVideoKeepTime.load());
+    uint64_t since = newest > window_ms ? newest - window_ms : 0;
+    return m_mediaRetention.dump(uid, since, frames, m_framePool);
 }
 
 void AgoraSdk::setLogLevel(agora::linuxsdk::agora_log_level level)
@@ -289,12 +719,37 @@ void AgoraSdk::setKeepLastFrame(bool keep) {
 
 int AgoraSdk::setVideoMixingLayout(const agora::linuxsdk::VideoMixingLayout &layout)
 {
+   return pushVideoMixingLayout(layout, false);
+}
+
+int AgoraSdk::pushVideoMixingLayout(const agora::linuxsdk::VideoMixingLayout &layout, bool skipUnchanged)
+{
+   std::lock_guard<std::mutex> lock(m_appliedMutex);
+   if(skipUnchanged && m_appliedLayout.diff(layout) == 0) {
+      m_layoutSuppressed++;
+      return agora::linuxsdk::ERR_OK;
+   }
    int result = -agora::linuxsdk::ERR_INTERNAL_FAILED;
    if(m_engine)
       result = m_engine->setVideoMixingLayout(layout);
+   //after a failure the engine's layout is unknown, so the next one goes through
+   if(result == agora::linuxsdk::ERR_OK)
+      m_appliedLayout.assign(layout);
+   else
+      m_appliedLayout.clear();
+   if(skipUnchanged && result == agora::linuxsdk::ERR_OK)
+      m_layoutApplied++;
    return result;
 }
 
+size_t AgoraSdk::getAppliedRegions(agora::linuxsdk::VideoMixingLayout::Region *regions, size_t max)
+{
+   std::lock_guard<std::mutex> lock(m_appliedMutex);
+   const std::vector<agora::linuxsdk::VideoMixingLayout::Region>& applied = m_appliedLayout.regions();
+   std::copy(applied.begin(), applied.begin() + std::min(max, applied.size()), regions);
+   return applied.size();
+}
+
 int AgoraSdk::setUserBackground(agora::linuxsdk::uid_t uid, const char* image_path)
 {
     int result = -agora::linuxsdk::ERR_INTERNAL_FAILED;
@@ -314,34 +769,87 @@ int AgoraSdk::updateWatermarkConfigs(uint32_t wm_num, linuxsdk::WatermarkConfig*
   return -1;
 }
 
+//Full replacements still go to the engine straight away, and now also
+//replace the local sets the layout filters on
 int AgoraSdk::updateSubscribeVideoUids(uint32_t *uids, uint32_t num) {
    if(m_engine) {
-     return m_engine->updateSubscribeVideoUids(uids, num);
+     int ret = m_engine->updateSubscribeVideoUids(uids, num);
+     if (ret == linuxsdk::ERR_OK && m_videoSubscriptions.assign(uids, num) > 0) {
+       m_videoSubscriptions.markFlushed(m_videoSubscriptions.version());
+       refreshPeerVisibility();
+       scheduleVideoMixLayout();
+     }
+     return ret;
    }
    return -1;
 }
 
 int AgoraSdk::updateSubscribeAudioUids(uint32_t *uids, uint32_t num) {
   if (m_engine) {
-    return m_engine->updateSubscribeAudioUids(uids, num);
+    int ret = m_engine->updateSubscribeAudioUids(uids, num);
+    if (ret == linuxsdk::ERR_OK && m_audioSubscriptions.assign(uids, num) > 0)
+      m_audioSubscriptions.markFlushed(m_audioSubscriptions.version());
+    return ret;
   }
   return -1;
 }
 
+void AgoraSdk::userInfoUpdated(agora::linuxsdk::uid_t uid, const char *userAccount) {
+  if (!userAccount)
+    return;
+  bool changed = false;
+  {
+    std::lock_guard<std::mutex> lock(m_directoryMutex);
+    changed = m_directory.update(uid, userAccount, strlen(userAccount));
+  }
+  //the large tile and the peers shown in the presentation modes depend on accounts
+  if (changed && m_userAccount.length() > 0
+      && (m_layoutMode == VERTICALPRESENTATION_LAYOUT || m_layoutMode == ACTIVESPEAKER_LAYOUT))
+    scheduleVideoMixLayout();
+}
+
 uint32_t AgoraSdk::getUidByUserAccount(const char *userAccount) {
+  if (!userAccount)
+    return 0;
+  size_t length = strlen(userAccount);
+  {
+    std::lock_guard<std::mutex> lock(m_directoryMutex);
+    uint32_t uid = m_directory.uid(userAccount, length);
+    if (uid != 0)
+      return uid;
+  }
   if (m_engine) {
     agora::linuxsdk::UserInfo info;
     m_engine->getUserInfoByUserAccount(userAccount, &info);
+    if (info.uid != 0) {
+      std::lock_guard<std::mutex> lock(m_directoryMutex);
+      m_directory.update(info.uid, userAccount, length);
+    }
     return info.uid;
   }
   return 0;
 }
 
 uint32_t AgoraSdk::getUserAccountByUid(uint32_t uid, char* userAccountBuf, uint32_t buf_len) {
+  {
+    std::lock_guard<std::mutex> lock(m_directoryMutex);
+    size_t length = 0;
+    const char *account = m_directory.account(uid, &length);
+    if (account) {
+      uint32_t len = static_cast<uint32_t>(length);
+      if (len <= buf_len)
+        memcpy(userAccountBuf, account, len);
+      return len;
+    }
+  }
   if (m_engine) {
     agora::linuxsdk::UserInfo info;
     m_engine->getUserInfoByUid(uid, &info);
     uint32_t len = (uint32_t)strlen(info.userAccount);
+    if (len > 0) {
+      std::lock_guard<std::mutex> lock(m_directoryMutex);
+      m_directory.update(uid, info.userAccount, len);
+    }
     if (len > buf_len) {
       return len;
     } else {
@@ -352,6 +860,31 @@ uint32_t AgoraSdk::getUserAccountByUid(uint32_t uid, char* userAccountBuf, uint3
   return 0;
 }
 
+size_t AgoraSdk::getUidsByUserAccounts(const char * const *accounts, const uint32_t *lengths, size_t count, uint32_t *uids) {
+  std::lock_guard<std::mutex> lock(m_directoryMutex);
+  size_t found = 0;
+  for (size_t i = 0; i < count; i++) {
+    uids[i] = m_directory.uid(accounts[i], lengths[i]);
+    if (uids[i] != 0)
+      found++;
+  }
+  return found;
+}
+
+size_t AgoraSdk::getUserAccountsByUids(const uint32_t *uids, size_t count, char *buf, size_t buf_len, uint32_t *lengths) {
+  std::lock_guard<std::mutex> lock(m_directoryMutex);
+  size_t total = 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t length = 0;
+    const char *account = m_directory.account(uids[i], &length);
+    lengths[i] = account ? static_cast<uint32_t>(length) : 0;
+    if (account && total + length <= buf_len)
+      memcpy(buf + total, account, length);
+    total += lengths[i];
+  }
+  return total;
+}
+
 uint32_t AgoraSdk::now_s() const {
 	struct timeval now = { 0, 0 };
 	gettimeofday(&now, NULL);
@@ -360,6 +893,7 @@ uint32_t AgoraSdk::now_s() const {
 
 void AgoraSdk::setMediaKeepTime(uint32_t time_ms) {
 	m_mediaKeepTime = time_ms;
+	m_mediaRetention.setKeepTime(time_ms);
 }
 
 void AgoraSdk::adjustDefaultVideoLayout(agora::linuxsdk::VideoMixingLayout::Region * regionList,
@@ -398,273 +932,5 @@ void AgoraSdk::adjustDefaultVideoLayout(agora::linuxsdk::VideoMixingLayout::Regi
         regionList[i].renderMode = 0;
     }
 }
-
-void AgoraSdk::setMaxResolutionUid(int number, unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList, double weight_ratio) {
-    regionList[number].uid = maxResolutionUid;
-    regionList[number].x = 0.f;
-    regionList[number].y = 0.f;
-    regionList[number].width = 1.f * weight_ratio;
-    regionList[number].height = 1.f;
-    regionList[number].alpha = 1.f;
-    regionList[number].renderMode = 1;
-}
-void AgoraSdk::changeToVideo7Layout(unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList, std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
-    //CM_LOG_DIR(m_logdir.c_str(), INFO,"changeToVideo7Layout");
-    adjustVideo7Layout(maxResolutionUid, regionList, subscribedUids);
-}
-void AgoraSdk::changeToVideo9Layout(unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList, std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
-    //CM_LOG_DIR(m_logdir.c_str(), INFO,"changeToVideo9Layout");
-    adjustVideo9Layout(maxResolutionUid, regionList, subscribedUids);
-}
-void AgoraSdk::changeToVideo17Layout(unsigned int maxResolutionUid,
-    agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
-    //CM_LOG_DIR(m_logdir.c_str(), INFO,"changeToVideo17Layout");
-    adjustVideo17Layout(maxResolutionUid, regionList, subscribedUids);
-}
-
-void AgoraSdk::adjustVideo5Layout(unsigned int maxResolutionUid,
-    agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
-    bool flag = false;
-    //CM_LOG_DIR(m_logdir.c_str(), INFO, "adjustVideo5Layou tegion 0 uid: %u, x: %f, y: %f, width: %f, height: %f, alpha: %f", regionList[0].uid, regionList[0].x, regionList[0].y, regionList[0].width, regionList[0].height, regionList[0].alpha);
-
-    //float canvasWidth = static_cast<float>(m_mixRes.m_width);
-    //float canvasHeight = static_cast<float>(m_mixRes.m_height);
-
-    //float viewWidth = 0.235f;
-    //float viewHEdge = 0.012f;
-    int number = 0;
-
-    size_t i=0;
-    for (; i<subscribedUids.size(); i++) {
-        if(maxResolutionUid == subscribedUids[i]){
-            //CM_LOG_DIR(m_logdir.c_str(), INFO, "adjustVideo5Layout equal with configured user uid:%u", maxResolutionUid);
-            flag = true;
-            setMaxResolutionUid(number,  maxResolutionUid, regionList,0.8);
-            number++;
-            continue;
-        }
-        regionList[number].uid = subscribedUids[i];
-        //float xIndex = ;
-        float yIndex = flag?static_cast<float>(number-1 % 4):static_cast<float>(number % 4);
-        regionList[number].x = 1.f * 0.8;
-        regionList[number].y = (0.25) * yIndex;
-        regionList[number].width = 1.f*(1-0.8);
-        regionList[number].height = 1.f * (0.25);
-        regionList[number].alpha = 1;//static_cast<double>(number);
-        regionList[number].renderMode = 0;
-        number++;
-        if(i == 4 && !flag){
-            changeToVideo7Layout(maxResolutionUid, regionList, subscribedUids);
-        }
-    }
-
-}
-void AgoraSdk::adjustVideo7Layout(unsigned int maxResolutionUid,
-    agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t> &subscribedUids) {
-    bool flag = false;
-    //CM_LOG_DIR(m_logdir.c_str(), INFO, "adjustVideo7Layou tegion 0 uid: %u, x: %f, y: %f, width: %f, height: %f, alpha: %f", regionList[0].uid, regionList[0].x, regionList[0].y, regionList[0].width, regionList[0].height, regionList[0].alpha);
-
-    //float canvasWidth = static_cast<float>(m_mixRes.m_width);
-    //float canvasHeight = static_cast<float>(m_mixRes.m_height);
-
-    //float viewWidth = 0.235f;
-    //float viewHEdge = 0.012f;
-    int number = 0;
-
-    size_t i=0;
-    for (; i<subscribedUids.size(); i++) {
-        if(maxResolutionUid == subscribedUids[i]){
-            //CM_LOG_DIR(m_logdir.c_str(), INFO, "adjustVideo7Layout equal with configured user uid:%u", maxResolutionUid);
-            flag = true;
-            setMaxResolutionUid(number,  maxResolutionUid, regionList,6.f/7);
-            number++;
-            continue;
-        }
-        regionList[number].uid = subscribedUids[i];
-        float yIndex = flag?static_cast<float>(number-1 % 6):static_cast<float>(number % 6);
-        regionList[number].x = 6.f/7;
-        regionList[number].y = (1.f/6) * yIndex;
-        regionList[number].width = (1.f/7);
-        regionList[number].height = (1.f/6);
-        regionList[number].alpha = 1;//static_cast<double>(number);
-        regionList[number].renderMode = 0;
-        number++;
-        if(i == 6 && !flag){
-            changeToVideo9Layout(maxResolutionUid, regionList, subscribedUids);
-        }
-    }
-
-}
-void AgoraSdk::adjustVideo9Layout(unsigned int maxResolutionUid,
-    agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
-    bool flag = false;
-    //CM_LOG_DIR(m_logdir.c_str(), INFO, "adjustVideo9Layou tegion 0 uid: %u, x: %f, y: %f, width: %f, height: %f, alpha: %f", regionList[0].uid, regionList[0].x, regionList[0].y, regionList[0].width, regionList[0].height, regionList[0].alpha);
-
-    //float canvasWidth = static_cast<float>(m_mixRes.m_width);
-    //float canvasHeight = static_cast<float>(m_mixRes.m_height);
-
-    //float viewWidth = 0.235f;
-    //float viewHEdge = 0.012f;
-    int number = 0;
-
-    size_t i=0;
-    for (; i<subscribedUids.size(); i++) {
-        if(maxResolutionUid == subscribedUids[i]){
-            //CM_LOG_DIR(m_logdir.c_str(), INFO, "adjustVideo9Layout equal with configured user uid:%u", maxResolutionUid);
-            flag = true;
-            setMaxResolutionUid(number,  maxResolutionUid, regionList,9.f/5);
-            number++;
-            continue;
-        }
-        regionList[number].uid = subscribedUids[i];
-        float yIndex = flag?static_cast<float>(number-1 % 8):static_cast<float>(number % 8);
-        regionList[number].x = 8.f/9;
-        regionList[number].y = (1.f/8) * yIndex;
-        regionList[number].width = 1.f/9 ;
-        regionList[number].height = 1.f/8;
-        regionList[number].alpha = 1;//static_cast<double>(number);
-        regionList[number].renderMode = 0;
-        number++;
-        if(i == 8 && !flag){
-            changeToVideo17Layout(maxResolutionUid, regionList, subscribedUids);
-        }
-    }
-}
-
-void AgoraSdk::adjustVideo17Layout(unsigned int maxResolutionUid,
-    agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
-    bool flag = false;
-    //float canvasWidth = static_cast<float>(m_mixRes.m_width);
-    //float canvasHeight = static_cast<float>(m_mixRes.m_height);
-
-    //float viewWidth = 0.235f;
-    //float viewHEdge = 0.012f;
-    int number = 0;
-    //CM_LOG_DIR(m_logdir.c_str(), INFO, "adjustVideo17Layoutenter subscribedUids size is:%d, maxResolutionUid:%ld",subscribedUids.size(), maxResolutionUid);
-    for (size_t i=0; i<subscribedUids.size(); i++) {
-        if(maxResolutionUid == subscribedUids[i]){
-            //CM_LOG_DIR(m_logdir.c_str(), INFO, "adjustVideo17Layoutenter equal with maxResolutionUid:%ld", maxResolutionUid);
-            flag = true;
-            setMaxResolutionUid(number,  maxResolutionUid, regionList,0.8);
-            number++;
-            continue;
-        }
-        if(!flag && i == 16) {
-            //CM_LOG_DIR(m_logdir.c_str(), INFO, "Not the configured uid, and small regions is sixteen, so ignore this user:%d",subscribedUids[i]);
-            break;
-        }
-        regionList[number].uid = subscribedUids[i];
-        //float xIndex = 0.833f;
-        float yIndex = flag?static_cast<float>((number-1) % 8):static_cast<float>(number % 8);
-        regionList[number].x = ((flag && i>8) || (!flag && i >=8)) ? (9.f/10):(8.f/10);
-        regionList[number].y = (1.f/8) * yIndex;
-        regionList[number].width =  1.f/10 ;
-        regionList[number].height = 1.f/8;
-        regionList[number].alpha = 1; //static_cast<double>(number);
-        regionList[number].renderMode = 0;
-        number++;
-    }
-}
-
-void AgoraSdk::adjustVerticalPresentationLayout(unsigned int maxResolutionUid,
-    agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
-    //CM_LOG_DIR(m_logdir.c_str(), INFO, "begin adjust vertical presentation layout,peers size:%d, maxResolutionUid:%ld",subscribedUids.size(), maxResolutionUid);
-    if(subscribedUids.size() <= 5) {
-        adjustVideo5Layout(maxResolutionUid, regionList, subscribedUids);
-    }else if(subscribedUids.size() <= 7) {
-        adjustVideo7Layout(maxResolutionUid, regionList, subscribedUids);
-    }else if(subscribedUids.size() <= 9) {
-        adjustVideo9Layout(maxResolutionUid, regionList, subscribedUids);
-    }else {
-        adjustVideo17Layout(maxResolutionUid, regionList, subscribedUids);
-    }
-}
-
-void AgoraSdk::adjustBestFitLayout_2(agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
-    //float canvasWidth = static_cast<float>(m_mixRes.m_width);
-    //float canvasHeight = static_cast<float>(m_mixRes.m_height);
-    //float viewWidth = 0.235f;
-    //float viewHEdge = 0.012f;
-    size_t peersCount = subscribedUids.size();
-    for (size_t i=0; i < peersCount; i++) {
-        regionList[i].uid = subscribedUids[i];
-        regionList[i].x = ((i+1)%2)?0:0.5;
-        regionList[i].y =  0.f;
-        regionList[i].width = 0.5f;
-        regionList[i].height = 1.f;
-        regionList[i].alpha = static_cast<double>(i+1);
-        regionList[i].renderMode = 0;
-    }
-}
-void AgoraSdk::adjustBestFitLayout_Square(agora::linuxsdk::VideoMixingLayout::Region * regionList, int nSquare, std::vector<agora::linuxsdk::uid_t> &subscribedUids) {
-    //float canvasWidth = static_cast<float>(m_mixRes.m_width);
-    //float canvasHeight = static_cast<float>(m_mixRes.m_height);
-    float viewWidth = static_cast<float>(1.f * 1.0/nSquare);
-    float viewHEdge = static_cast<float>(1.f * 1.0/nSquare);
-    size_t peersCount = subscribedUids.size();
-    for (size_t i=0; i < peersCount; i++) {
-        float xIndex =static_cast<float>(i%nSquare);
-        float yIndex = static_cast<float>(i/nSquare);
-        regionList[i].uid = subscribedUids[i];
-        regionList[i].x = 1.f * 1.0/nSquare * xIndex;
-        regionList[i].y = 1.f * 1.0/nSquare * yIndex;
-        regionList[i].width = viewWidth;
-        regionList[i].height = viewHEdge;
-        regionList[i].alpha = static_cast<double>(i+1);
-        regionList[i].renderMode = 0;
-    }
-}
-void AgoraSdk::adjustBestFitLayout_17(agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
-    //float canvasWidth = static_cast<float>(m_mixRes.m_width);
-    //float canvasHeight = static_cast<float>(m_mixRes.m_height);
-    int n = 5;
-    float viewWidth = static_cast<float>(1.f * 1.0/n);
-    float viewHEdge = static_cast<float>(1.f * 1.0/n);
-    //float totalWidth = static_cast<float>(1.f - viewWidth);
-    size_t peersCount = subscribedUids.size();
-    for (size_t i=0; i < peersCount; i++) {
-        float xIndex = static_cast<float>(i%(n-1));
-        float yIndex = static_cast<float>(i/(n-1));
-        regionList[i].uid = subscribedUids[i];
-        regionList[i].width = viewWidth;
-        regionList[i].height = viewHEdge;
-        regionList[i].alpha = static_cast<double>(i+1);
-        regionList[i].renderMode = 0;
-        if(i == 16) {
-            regionList[i].x = (1-viewWidth)*(1.f/2) * 1.f;
-            //CM_LOG_DIR(m_logdir.c_str(), INFO, "special layout for 17 x is:",regionList[i].x);
-        }else {
-            regionList[i].x = 0.5f * viewWidth +  viewWidth * xIndex;
-        }
-        regionList[i].y =  (1.0/n) * yIndex;
-    }
-}
-
-void AgoraSdk::adjustBestFitVideoLayout(agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids) {
-    if(subscribedUids.size() == 1) {
-        adjustBestFitLayout_Square(regionList,1, subscribedUids);
-    }else if(subscribedUids.size() == 2) {
-        adjustBestFitLayout_2(regionList, subscribedUids);
-    }else if( 2 < subscribedUids.size() && subscribedUids.size() <=4) {
-        adjustBestFitLayout_Square(regionList,2, subscribedUids);
-    }else if(5<=subscribedUids.size() && subscribedUids.size() <=9) {
-        adjustBestFitLayout_Square(regionList,3, subscribedUids);
-    }else if(10<=subscribedUids.size() && subscribedUids.size() <=16) {
-        adjustBestFitLayout_Square(regionList,4, subscribedUids);
-    }else if(subscribedUids.size() ==17) {
-        adjustBestFitLayout_17(regionList, subscribedUids);
-    }else {
-        //CM_LOG_DIR(m_logdir.c_str(), INFO, "adjustBestFitVideoLayout is more than 17 users");
-    }
-}
 }
 
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <csignal>
 #include <cstdint>
 #include <iostream>
@@ -9,12 +11,30 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <set>
+#include <mutex>
 
 #include "IAgoraLinuxSdkCommon.h"
 #include "IAgoraRecordingEngine.h"
 
 //#include "base/atomic.h"
 #include "base/opt_parser.h" 
+#include "LayoutCache.h"
+#include "LayoutSolver.h"
+#include "SlotAssignment.h"
+#include "LayoutScheduler.h"
+#include "PeerRoster.h"
+#include "UserDirectory.h"
+#include "SubscriptionSet.h"
+#include "SubscribeList.h"
+#include "FramePool.h"
+#include "FrameQueue.h"
+#include "MediaAccounting.h"
+#include "MediaRetention.h"
+#include "FakeRecordingEngine.h"
+#include "EventExecutor.h"
+#include "StatsBatch.h"
+#include "ActiveSpeaker.h"
+#include "TalkAnalytics.h"
 
 namespace agora {
 
@@ -31,6 +51,8 @@ enum LAYOUT_MODE_TYPE {
     DEFAULT_LAYOUT = 0,
     BESTFIT_LAYOUT = 1,
     VERTICALPRESENTATION_LAYOUT = 2,
+    //vertical presentation with the dominant speaker in the large tile
+    ACTIVESPEAKER_LAYOUT = 3,
 };
 
 
@@ -45,15 +67,6 @@ struct MixModeSettings {
     {};
 };
 
-struct AudioFrameInfo {
-    unsigned int m_channels;
-    unsigned int m_index;
-    AudioFrameInfo():
-        m_channels(0),
-        m_index(1)
-    {};
-};
-
 class AgoraSdk {
     public:
         AgoraSdk();
@@ -69,11 +82,79 @@ class AgoraSdk {
         virtual bool createChannelWithUserAccount(const string &appid, const string &channelKey, const string &name,  const std::string& userAccount,
                 agora::recording::RecordingConfig &config);
 
+        //Use engine instead of creating one in createChannel; it is released
+        //like a created engine. Fails if an engine is already in place.
+        virtual bool attachEngine(agora::recording::IRecordingEngine *engine);
+        //Have createChannel build a FakeRecordingEngine instead of
+        //connecting to AgoraCoreService.
+        void useFakeEngine(const FakeEngineConfig &config) {
+            m_useFakeEngine = true;
+            m_fakeEngineConfig = config;
+        }
         virtual int setVideoMixLayout();
+        virtual void scheduleVideoMixLayout();
+        virtual void addPeer(agora::linuxsdk::uid_t uid);
+        virtual void removePeer(agora::linuxsdk::uid_t uid);
+        void setLayoutDebounceTime(uint32_t window_ms);
+        uint64_t getLayoutPushCount() const { return m_layoutScheduler.pushed(); }
+        uint64_t getLayoutCoalescedCount() const { return m_layoutScheduler.coalesced(); }
+        //Recomputed layouts sent to the engine, and those skipped because they
+        //matched the layout it already has.
+        uint64_t getLayoutAppliedCount() const { return m_layoutApplied.load(); }
+        uint64_t getLayoutSuppressedCount() const { return m_layoutSuppressed.load(); }
+        //Copies up to max regions of the layout the engine last accepted;
+        //returns how many it has.
+        size_t getAppliedRegions(agora::linuxsdk::VideoMixingLayout::Region *regions, size_t max);
+        //Debounce layout pushes and subscription updates on shared timer
+        //threads instead of threads per recorder. Set before the channel is created.
+        void setTimerQueue(TimerQueue *timers) {
+            m_layoutScheduler.setTimerQueue(timers);
+            m_subscribeScheduler.setTimerQueue(timers);
+        }
+        size_t getPeerCount();
+        //Speaker input for ACTIVESPEAKER_LAYOUT; the layout is only pushed
+        //when the dominant speaker changes.
+        virtual void activeSpeaker(agora::linuxsdk::uid_t uid);
+        virtual void audioVolumeIndication(const agora::linuxsdk::AudioVolumeInfo *speakers, unsigned int speakerNum);
+        void setActiveSpeakerTuning(const ActiveSpeakerTuning &tuning);
+        agora::linuxsdk::uid_t getActiveSpeaker();
+        uint64_t getActiveSpeakerSwitches();
+        //Keep each peer in its tile when others leave; the holes are filled
+        //by joiners and only closed up when the tile size would change.
+        void setStableLayoutSlots(bool stable);
+        uint64_t getLayoutCompactionCount();
+        size_t getLayoutTemplateCount();
+        //Speaking time analytics. The indications publish a snapshot every
+        //intervalMs (0 on every indication), and getTalkStats copies the last
+        //one; it returns how many uids it holds, which may be more than max.
+        void setTalkThreshold(uint32_t volume);
+        void setTalkSnapshotInterval(uint32_t intervalMs);
+        size_t getTalkStats(TalkUserStats *entries, size_t max, TalkChannelStats &channel);
+        FramePool* getFramePool() const { return m_framePool; }
+        void setFramePool(FramePool *pool) { m_framePool = pool ? pool : FramePool::shared(); }
+        //Workers the handler hands its listener callbacks to.
+        EventExecutor* getEventExecutor() const { return m_eventExecutor; }
+        void setEventExecutor(EventExecutor *executor) { m_eventExecutor = executor ? executor : EventExecutor::shared(); }
+        //Volume and stats callbacks reach the listener in batches of up to
+        //capacity samples per kind, at most intervalMs apart while they keep
+        //coming.
+        void setStatsBatching(size_t capacity, uint32_t intervalMs) { m_statsBatcher.configure(capacity, intervalMs); }
+        StatsBatcher* getStatsBatcher() { return &m_statsBatcher; }
+        bool attachFrameQueue(FrameQueue *queue);
+        FrameQueue* getFrameQueue() const { return m_frameQueue.load(std::memory_order_acquire); }
+        void videoFrameReceived(unsigned int uid, const VideoFrameView &view) const;
+        void audioFrameReceived(unsigned int uid, const AudioFrameView &view) const;
+        size_t getMediaStatsCount() const { return m_mediaAccounting.size(); }
+        size_t getMediaStats(MediaAccountingEntry *entries, size_t max) const { return m_mediaAccounting.snapshot(entries, max); }
+        FrameBuffer* dumpRecentMedia(unsigned int uid, uint32_t window_ms, std::vector<RetainedFrame> &frames) const;
+        std::vector<uint32_t> getRetainedUids() const { return m_mediaRetention.uids(); }
+        uint64_t getRetainedBytes() const { return m_mediaRetention.reservedBytes(); }
         virtual bool leaveChannel();
         virtual bool stoppedOnError();
         virtual bool release();
         virtual bool stopped() const;
+        //In a channel: joined and not yet left, stopped or released.
+        bool joined() const { return m_joined.load(); }
         virtual void updateMixModeSetting(int width, int height, bool isVideoMix) {
             m_mixRes.m_width = width;
             m_mixRes.m_height = height;
@@ -97,47 +178,50 @@ class AgoraSdk {
 				void setMediaKeepTime(uint32_t time_ms);
         virtual int updateSubscribeVideoUids(uint32_t *uids, uint32_t num);
         virtual int updateSubscribeAudioUids(uint32_t *uids, uint32_t num);
+        //Deltas on the subscribed uids. The local sets change at once; the
+        //engine gets the whole list once changes stop for a moment.
+        int addSubscribeVideoUids(const uint32_t *uids, uint32_t num) { return changeSubscriptions(m_videoSubscriptions, true, true, uids, num); }
+        int removeSubscribeVideoUids(const uint32_t *uids, uint32_t num) { return changeSubscriptions(m_videoSubscriptions, true, false, uids, num); }
+        int addSubscribeAudioUids(const uint32_t *uids, uint32_t num) { return changeSubscriptions(m_audioSubscriptions, false, true, uids, num); }
+        int removeSubscribeAudioUids(const uint32_t *uids, uint32_t num) { return changeSubscriptions(m_audioSubscriptions, false, false, uids, num); }
+        void setSubscribeDebounceTime(uint32_t window_ms) { m_subscribeScheduler.setWindow(window_ms); }
+        //Copies up to max uids of the current snapshot; returns how many it holds.
+        size_t getSubscribedUids(bool video, uint32_t *uids, size_t max, uint64_t *version) const;
+        uint64_t getSubscribeUpdateCount() const { return m_subscribeUpdates.load(); }
         virtual uint32_t getUidByUserAccount(const char *userAccount);
         virtual uint32_t getUserAccountByUid(uint32_t uid, char* userAccountBuf, uint32_t buf_len);
+        //Feeds the uid <-> account directory; the handler calls it from
+        //onLocalUserRegistered and onUserInfoUpdated.
+        virtual void userInfoUpdated(agora::linuxsdk::uid_t uid, const char *userAccount);
+        //Directory lookups only, without falling back to the engine. Unknown
+        //accounts get uid 0 and the number found is returned. Accounts are
+        //packed into buf back to back with lengths[i] bytes each (0 when
+        //unknown); the bytes needed are returned and nothing past buf_len is
+        //written.
+        size_t getUidsByUserAccounts(const char * const *accounts, const uint32_t *lengths, size_t count, uint32_t *uids);
+        size_t getUserAccountsByUids(const uint32_t *uids, size_t count, char *buf, size_t buf_len, uint32_t *lengths);
         void setKeepLastFrame(bool keep);
         int updateWatermarkConfigs(uint32_t wm_num, linuxsdk::WatermarkConfig* config);
     
     private:
         void adjustDefaultVideoLayout(agora::linuxsdk::VideoMixingLayout::Region * regionList,
 std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-        void adjustBestFitVideoLayout(agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-        void adjustVerticalPresentationLayout(unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-
-        void adjustVideo5Layout(unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-        void adjustVideo7Layout(unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-        void adjustVideo9Layout(unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-        void adjustVideo17Layout(unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-
-        void changeToVideo7Layout(unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-        void changeToVideo9Layout(unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-        void changeToVideo17Layout(unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-
-        void adjustBestFitLayout_2(agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-        void adjustBestFitLayout_Square(agora::linuxsdk::VideoMixingLayout::Region * regionList, int nSquare,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-        void adjustBestFitLayout_17(agora::linuxsdk::VideoMixingLayout::Region * regionList,
-    std::vector<agora::linuxsdk::uid_t>& subscribedUids);
-        void setMaxResolutionUid(int number, unsigned int maxResolutionUid, agora::linuxsdk::VideoMixingLayout::Region * regionList, double weight_ratio);
+        int pushVideoMixingLayout(const agora::linuxsdk::VideoMixingLayout &layout, bool skipUnchanged);
+        bool isVideoSubscribed(agora::linuxsdk::uid_t uid) const;
+        bool addConfigSubscriptions(const char *name, const char *uids, SubscriptionSet &set);
+        int changeSubscriptions(SubscriptionSet &set, bool video, bool subscribe, const uint32_t *uids, uint32_t num);
+        int flushSubscriptions();
+        void refreshPeerVisibility();
+        void setTalkInterval();
+        const LayoutTemplate& getLayoutTemplate(LAYOUT_MODE_TYPE layoutMode, unsigned int maxResolutionUid,
+    const std::vector<agora::linuxsdk::uid_t>& subscribedUids);
 	uint32_t now_s() const;
+        agora::recording::IRecordingEngine* createEngine(const string &appid);
     
         agora::recording::IRecordingEngineEventHandler * m_handler;
         bool m_stopped;
-        std::vector<agora::linuxsdk::uid_t> m_peers;
+        std::atomic<bool> m_joined;
+        PeerRoster m_peers;
         std::string m_logdir;
         std::string m_storage_dir;
         MixModeSettings m_mixRes;
@@ -150,15 +234,50 @@ std::vector<agora::linuxsdk::uid_t>& subscribedUids);
         bool m_receivingAudio;
         bool m_receivingVideo;
         uint32_t m_mediaKeepTime;
-        mutable uint32_t m_lastAudioKeepTime;
-        mutable uint32_t m_lastVideoKeepTime;
-        mutable std::unordered_map<unsigned int, AudioFrameInfo> m_audioFrameMap;
-        std::unordered_set<uint32_t> m_subscribedVideoUids;
-        std::unordered_set<uint32_t> m_subscribedAudioUids;
-        std::set<std::string> m_subscribeVideoUserAccount;
-        std::set<std::string> m_subscribeAudioUserAccount;
+        mutable std::atomic<uint64_t> m_lastAudioKeepTime;
+        mutable std::atomic<uint64_t> m_lastVideoKeepTime;
+        mutable MediaAccounting m_mediaAccounting;
+        mutable MediaRetention m_mediaRetention;
+        SubscriptionSet m_videoSubscriptions;
+        SubscriptionSet m_audioSubscriptions;
+        LayoutScheduler m_subscribeScheduler;
+        std::atomic<uint64_t> m_subscribeUpdates;
+        AccountList m_subscribeVideoUserAccount;
+        AccountList m_subscribeAudioUserAccount;
         bool m_keepLastFrame;
         std::string m_userAccount;
+        //lock after m_layoutMutex when both are needed
+        std::mutex m_directoryMutex;
+        UserDirectory m_directory;
+        std::mutex m_layoutMutex;
+        LayoutScheduler m_layoutScheduler;
+        LayoutCache m_layoutCache;
+        ActiveSpeakerTracker m_activeSpeaker;
+        //never held together with m_layoutMutex
+        std::mutex m_talkMutex;
+        TalkAnalytics m_talk;
+        uint32_t m_talkSnapshotInterval;
+        uint64_t m_talkPublishedMs;
+        std::vector<TalkUserStats> m_talkSnapshot;
+        TalkChannelStats m_talkChannel;
+        bool m_stableSlots;
+        SlotAssignment m_slots;
+        std::vector<agora::linuxsdk::uid_t> m_layoutUids;
+        //scratch for refreshPeerVisibility
+        std::vector<agora::linuxsdk::uid_t> m_peerUids;
+        std::vector<uint8_t> m_peerVisible;
+        std::vector<agora::linuxsdk::VideoMixingLayout::Region> m_layoutRegions;
+        //guards m_appliedLayout; layouts can also be set directly, without m_layoutMutex
+        std::mutex m_appliedMutex;
+        AppliedLayout m_appliedLayout;
+        std::atomic<uint64_t> m_layoutApplied;
+        std::atomic<uint64_t> m_layoutSuppressed;
+        FramePool *m_framePool;
+        EventExecutor *m_eventExecutor;
+        StatsBatcher m_statsBatcher;
+        std::atomic<FrameQueue*> m_frameQueue;
+        bool m_useFakeEngine;
+        FakeEngineConfig m_fakeEngineConfig;
 };
 
 
@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+#include "AllocCounters.h"
+
+#ifdef AGORA_ALLOC_COUNTERS
+
+static std::atomic<uint64_t> s_allocCount(0);
+static std::atomic<uint64_t> s_allocBytes(0);
+
+static void* countedAlloc(size_t size) {
+  s_allocCount.fetch_add(1, std::memory_order_relaxed);
+  s_allocBytes.fetch_add(size, std::memory_order_relaxed);
+  void *ptr = malloc(size ? size : 1);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new(size_t size) {
+  return countedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+  return countedAlloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return countedAlloc(size);
+  } catch (...) {
+    return NULL;
+  }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return countedAlloc(size);
+  } catch (...) {
+    return NULL;
+  }
+}
+
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  free(ptr);
+}
+
+namespace agora {
+
+bool allocCountersEnabled() {
+  return true;
+}
+
+uint64_t allocCount() {
+  return s_allocCount.load(std::memory_order_relaxed);
+}
+
+uint64_t allocBytes() {
+  return s_allocBytes.load(std::memory_order_relaxed);
+}
+
+}
+
+#else
+
+namespace agora {
+
+bool allocCountersEnabled() {
+  return false;
+}
+
+uint64_t allocCount() {
+  return 0;
+}
+
+uint64_t allocBytes() {
+  return 0;
+}
+
+}
+
+#endif
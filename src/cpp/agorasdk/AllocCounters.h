@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+namespace agora {
+
+//Global operator new counters, compiled in only with AGORA_ALLOC_COUNTERS
+//(the alloc-counters cargo feature). Without it they always read 0.
+bool allocCountersEnabled();
+uint64_t allocCount();
+uint64_t allocBytes();
+
+}
@@ -0,0 +1,214 @@
+#include "EventExecutor.h"
+#include "FramePool.h"
+#include "StatsBatch.h"
+
+namespace agora {
+
+//the sink whose event this thread is delivering, if any
+static thread_local const EventSink *t_delivering = NULL;
+
+EventSink::EventSink() :
+  m_pending(0)
+{
+}
+
+EventSink::~EventSink() {
+}
+
+void EventSink::waitIdle() {
+  if (t_delivering == this)
+    return;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [this] { return m_pending.load() == 0; });
+}
+
+void EventSink::dispatch(HandlerEvent &event, std::atomic<uint64_t> &delivered) {
+  const EventSink *outer = t_delivering;
+  t_delivering = this;
+  deliver(event);
+  t_delivering = outer;
+  if (event.m_buffer) {
+    event.m_buffer->release();
+    event.m_buffer = NULL;
+  }
+  if (event.m_type == HANDLER_EVENT_STATS_BATCH && event.m_batch)
+    event.m_batch->release();
+  delivered++;
+  //under the lock, or a waiter could see zero and free the sink before the notify
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (--m_pending == 0)
+    m_idle.notify_all();
+}
+
+static void raise(std::atomic<uint64_t> &mark, uint64_t value) {
+  uint64_t current = mark.load(std::memory_order_relaxed);
+  while (value > current && !mark.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+EventExecutor::EventExecutor(size_t workers) :
+  m_readyLanes(0)
+  , m_stopping(false)
+  , m_posted(0)
+  , m_delivered(0)
+  , m_highWater(0)
+  , m_steals(0)
+{
+  if (workers == 0)
+    workers = 1;
+  for (size_t i = 0; i < kLanes; i++) {
+    m_lanes[i].m_scheduled = false;
+    m_lanes[i].m_home = i % workers;
+  }
+  for (size_t i = 0; i < workers; i++)
+    m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+  for (size_t i = 0; i < workers; i++)
+    m_workers[i]->m_thread = std::thread(&EventExecutor::run, this, i);
+}
+
+EventExecutor::~EventExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_cond.notify_all();
+  for (size_t i = 0; i < m_workers.size(); i++)
+    m_workers[i]->m_thread.join();
+}
+
+EventExecutor* EventExecutor::shared() {
+  //never destroyed, handlers may still post during static destruction
+  static EventExecutor *executor = new EventExecutor();
+  return executor;
+}
+
+bool EventExecutor::ownsThread() const {
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    if (m_workers[i]->m_thread.get_id() == std::this_thread::get_id())
+      return true;
+  }
+  return false;
+}
+
+void EventExecutor::post(EventSink *sink, const HandlerEvent &event) {
+  //hash the sink so all of its events share a lane
+  uintptr_t key = reinterpret_cast<uintptr_t>(sink);
+  key ^= key >> 17;
+  key *= 0x9e3779b1u;
+  Lane *lane = &m_lanes[(key >> 8) % kLanes];
+
+  sink->m_pending++;
+  uint64_t posted = ++m_posted;
+  raise(m_highWater, posted - m_delivered.load(std::memory_order_relaxed));
+
+  Item item;
+  item.m_sink = sink;
+  item.m_event = event;
+  bool wake;
+  {
+    std::lock_guard<std::mutex> lock(lane->m_mutex);
+    lane->m_items.push_back(item);
+    wake = !lane->m_scheduled;
+    lane->m_scheduled = true;
+  }
+  //a lane is queued on at most one worker while it has events
+  if (wake)
+    schedule(lane, lane->m_home);
+}
+
+void EventExecutor::schedule(Lane *lane, size_t worker) {
+  {
+    std::lock_guard<std::mutex> lock(m_workers[worker]->m_mutex);
+    m_workers[worker]->m_ready.push_back(lane);
+  }
+  {
+    //counted under m_mutex so a worker going to sleep cannot miss it
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_readyLanes++;
+  }
+  m_cond.notify_one();
+}
+
+EventExecutor::Lane* EventExecutor::take(size_t self) {
+  {
+    Worker &own = *m_workers[self];
+    std::lock_guard<std::mutex> lock(own.m_mutex);
+    if (!own.m_ready.empty()) {
+      Lane *lane = own.m_ready.front();
+      own.m_ready.pop_front();
+      return lane;
+    }
+  }
+  for (size_t i = 1; i < m_workers.size(); i++) {
+    Worker &victim = *m_workers[(self + i) % m_workers.size()];
+    std::lock_guard<std::mutex> lock(victim.m_mutex);
+    if (!victim.m_ready.empty()) {
+      Lane *lane = victim.m_ready.back();
+      victim.m_ready.pop_back();
+      m_steals++;
+      return lane;
+    }
+  }
+  return NULL;
+}
+
+void EventExecutor::drain(Lane *lane, size_t self) {
+  Item batch[kBatch];
+  size_t count = 0;
+  {
+    std::lock_guard<std::mutex> lock(lane->m_mutex);
+    while (count < kBatch && !lane->m_items.empty()) {
+      batch[count++] = lane->m_items.front();
+      lane->m_items.pop_front();
+    }
+  }
+
+  for (size_t i = 0; i < count; i++)
+    batch[i].m_sink->dispatch(batch[i].m_event, m_delivered);
+
+  bool more;
+  {
+    std::lock_guard<std::mutex> lock(lane->m_mutex);
+    more = !lane->m_items.empty();
+    lane->m_scheduled = more;
+  }
+  //back of our own queue, behind lanes that have been waiting
+  if (more)
+    schedule(lane, self);
+}
+
+void EventExecutor::run(size_t self) {
+  for (;;) {
+    Lane *lane = take(self);
+    if (lane) {
+      m_readyLanes--;
+      drain(lane, self);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_readyLanes.load() > 0)
+      continue;
+    if (m_stopping)
+      return;
+    m_cond.wait(lock);
+  }
+}
+
+size_t EventExecutor::depth() const {
+  uint64_t delivered = m_delivered.load();
+  uint64_t posted = m_posted.load();
+  return posted > delivered ? posted - delivered : 0;
+}
+
+EventExecutorStats EventExecutor::stats() const {
+  EventExecutorStats stats;
+  stats.m_workers = m_workers.size();
+  stats.m_delivered = m_delivered.load();
+  stats.m_posted = m_posted.load();
+  stats.m_depth = stats.m_posted > stats.m_delivered ? stats.m_posted - stats.m_delivered : 0;
+  stats.m_highWater = m_highWater.load();
+  stats.m_steals = m_steals.load();
+  return stats;
+}
+
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FrameView.h"
+
+namespace agora {
+
+class StatsBatch;
+
+enum HANDLER_EVENT_TYPE {
+    HANDLER_EVENT_ERROR = 0,
+    HANDLER_EVENT_JOIN_CHANNEL_SUCCESS = 1,
+    HANDLER_EVENT_USER_JOINED = 2,
+    HANDLER_EVENT_USER_OFFLINE = 3,
+    HANDLER_EVENT_AUDIO_FRAME = 4,
+    HANDLER_EVENT_VIDEO_FRAME = 5,
+    HANDLER_EVENT_STATS_BATCH = 6,
+    HANDLER_EVENT_WARNING = 7,
+    HANDLER_EVENT_LEAVE_CHANNEL = 8,
+    HANDLER_EVENT_REMOTE_VIDEO_STREAM_STATE = 9,
+    HANDLER_EVENT_REMOTE_AUDIO_STREAM_STATE = 10,
+    HANDLER_EVENT_ACTIVE_SPEAKER = 11,
+    HANDLER_EVENT_FIRST_REMOTE_VIDEO_DECODED = 12,
+    HANDLER_EVENT_FIRST_REMOTE_AUDIO_FRAME = 13,
+    HANDLER_EVENT_RECEIVING_STREAM_STATUS = 14,
+    HANDLER_EVENT_CONNECTION_LOST = 15,
+    HANDLER_EVENT_CONNECTION_INTERRUPTED = 16,
+    HANDLER_EVENT_REJOIN_CHANNEL_SUCCESS = 17,
+    HANDLER_EVENT_CONNECTION_STATE_CHANGED = 18,
+    HANDLER_EVENT_LOCAL_USER_REGISTERED = 19,
+    HANDLER_EVENT_USER_INFO_UPDATED = 20,
+};
+
+//Longest channel name the SDK accepts.
+const size_t kMaxChannelNameLength = 64;
+
+//A handler callback copied out of the SDK thread, one fixed-size POD for
+//every kind so queueing never allocates. Frame payloads live in m_buffer
+//and stats in m_batch; both are released once the event has been
+//delivered. Everything but frames and stats batches is mirrored by
+//RawHandlerEvent in handler.rs.
+struct HandlerEvent {
+    HANDLER_EVENT_TYPE m_type;
+    uint32_t m_uid;
+    FrameBuffer *m_buffer;
+    union {
+        //errors and warnings
+        struct {
+            int32_t m_code;
+            int32_t m_statCode;
+        } m_error;
+        struct {
+            int32_t m_code;
+        } m_leave;
+        struct {
+            int32_t m_reason;
+        } m_offline;
+        //remote stream and connection state changes
+        struct {
+            int32_t m_state;
+            int32_t m_reason;
+        } m_state;
+        struct {
+            int32_t m_width;
+            int32_t m_height;
+            int32_t m_elapsed;
+        } m_firstFrame;
+        struct {
+            int32_t m_audio;
+            int32_t m_video;
+        } m_receiving;
+        char m_channel[kMaxChannelNameLength + 1];
+        char m_account[agora::linuxsdk::MAX_USER_ACCOUNT_LENGTH];
+        AudioFrameView m_audio;
+        VideoFrameView m_video;
+        StatsBatch *m_batch;
+    };
+};
+
+class EventSink {
+    public:
+        EventSink();
+        virtual ~EventSink();
+
+        //Blocks until everything posted for this sink has been delivered.
+        //Returns straight away when called from one of its own deliveries.
+        void waitIdle();
+        size_t pending() const { return m_pending.load(); }
+
+    protected:
+        virtual void deliver(const HandlerEvent &event) = 0;
+
+    private:
+        friend class EventExecutor;
+        void dispatch(HandlerEvent &event, std::atomic<uint64_t> &delivered);
+
+        std::atomic<size_t> m_pending;
+        std::mutex m_mutex;
+        std::condition_variable m_idle;
+};
+
+struct EventExecutorStats {
+    uint64_t m_workers;
+    uint64_t m_posted;
+    uint64_t m_delivered;
+    uint64_t m_depth;
+    uint64_t m_highWater;
+    uint64_t m_steals;
+    EventExecutorStats():
+        m_workers(0),
+        m_posted(0),
+        m_delivered(0),
+        m_depth(0),
+        m_highWater(0),
+        m_steals(0)
+    {};
+};
+
+//Delivers handler events on a fixed set of workers instead of the SDK's
+//callback thread. Every sink is a strand: its events run one after another
+//in posting order, so a listener sees each uid's events in order and never
+//from two threads at once. Strands with work are queued on a worker and idle
+//workers steal them, so one busy recorder does not hold up the others.
+class EventExecutor {
+    public:
+        explicit EventExecutor(size_t workers = 2);
+        //Delivers whatever is still queued, then joins the workers.
+        ~EventExecutor();
+
+        static EventExecutor* shared();
+
+        //Takes ownership of event.m_buffer.
+        void post(EventSink *sink, const HandlerEvent &event);
+
+        size_t workers() const { return m_workers.size(); }
+        //True when called from one of the executor's workers.
+        bool ownsThread() const;
+        //Events posted but not yet delivered.
+        size_t depth() const;
+        EventExecutorStats stats() const;
+
+    private:
+        struct Item {
+            EventSink *m_sink;
+            HandlerEvent m_event;
+        };
+        struct Lane {
+            std::mutex m_mutex;
+            std::deque<Item> m_items;
+            bool m_scheduled;
+            size_t m_home;
+        };
+        struct Worker {
+            std::mutex m_mutex;
+            std::deque<Lane*> m_ready;
+            std::thread m_thread;
+        };
+
+        void schedule(Lane *lane, size_t worker);
+        Lane* take(size_t self);
+        void drain(Lane *lane, size_t self);
+        void run(size_t self);
+
+        //events of one lane handled before it goes to the back of the queue
+        static const size_t kBatch = 64;
+        static const size_t kLanes = 256;
+
+        Lane m_lanes[kLanes];
+        std::vector<std::unique_ptr<Worker> > m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::atomic<size_t> m_readyLanes;
+        bool m_stopping;
+
+        std::atomic<uint64_t> m_posted;
+        std::atomic<uint64_t> m_delivered;
+        std::atomic<uint64_t> m_highWater;
+        std::atomic<uint64_t> m_steals;
+};
+
+}
@@ -0,0 +1,418 @@
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+
+#include "FakeRecordingEngine.h"
+
+namespace agora {
+
+using agora::linuxsdk::AudioFrame;
+using agora::linuxsdk::VideoFrame;
+
+namespace {
+
+const uint64_t kNever = UINT64_MAX;
+//don't replay more than this much missed time after a stall
+const uint64_t kMaxCatchUpMs = 1000;
+
+uint64_t stepFor(uint32_t intervalMs) {
+  return intervalMs ? intervalMs : kNever;
+}
+
+void fillAnnexB(std::vector<unsigned char> &buf, size_t bytes, unsigned char nalHeader) {
+  buf.assign(bytes < 5 ? 5 : bytes, 0xAA);
+  buf[0] = 0;
+  buf[1] = 0;
+  buf[2] = 0;
+  buf[3] = 1;
+  buf[4] = nalHeader;
+}
+
+int adtsFrequencyIndex(uint32_t sampleRate) {
+  static const uint32_t rates[] = {96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000};
+  for (int i = 0; i < static_cast<int>(sizeof(rates) / sizeof(rates[0])); i++) {
+    if (rates[i] == sampleRate)
+      return i;
+  }
+  return 3;
+}
+
+//mono AAC-LC with an ADTS header covering the whole buffer
+void fillAdts(std::vector<unsigned char> &buf, size_t payload, uint32_t sampleRate) {
+  size_t len = payload + 7;
+  int index = adtsFrequencyIndex(sampleRate);
+  buf.assign(len, 0);
+  buf[0] = 0xFF;
+  buf[1] = 0xF1;
+  buf[2] = static_cast<unsigned char>((1 << 6) | (index << 2));
+  buf[3] = static_cast<unsigned char>((1 << 6) | ((len >> 11) & 0x3));
+  buf[4] = static_cast<unsigned char>((len >> 3) & 0xFF);
+  buf[5] = static_cast<unsigned char>(((len & 0x7) << 5) | 0x1F);
+  buf[6] = 0xFC;
+}
+
+}
+
+FakeRecordingEngine::FakeRecordingEngine(agora::recording::IRecordingEngineEventHandler *handler, const FakeEngineConfig &config) :
+  m_handler(handler)
+  , m_fake(config)
+  , m_decodeVideo(agora::linuxsdk::VIDEO_FORMAT_DEFAULT_TYPE)
+  , m_decodeAudio(agora::linuxsdk::AUDIO_FORMAT_DEFAULT_TYPE)
+  , m_volumeIntervalMs(0)
+  , m_localUid(0)
+  , m_nextUid(config.m_firstUid)
+  , m_random(config.m_seed ? config.m_seed : 1)
+  , m_joinedMs(0)
+  , m_rxBytes(0)
+  , m_activeSpeaker(0)
+  , m_running(false)
+  , m_stopping(false)
+  , m_notifyLeave(false)
+  , m_videoFrames(0)
+  , m_audioFrames(0)
+  , m_userCount(0)
+{
+  fillAnnexB(m_keyframe, m_fake.m_videoFrameBytes, 0x65);
+  fillAnnexB(m_deltaFrame, m_fake.m_videoFrameBytes / 4, 0x41);
+  m_yuv.assign(m_fake.m_videoWidth * m_fake.m_videoHeight * 3 / 2, 0x80);
+  //64 kbps worth of AAC per frame
+  fillAdts(m_aac, m_fake.m_audioFrameMs * 8, m_fake.m_audioSampleRate);
+  m_pcm.assign(m_fake.m_audioSampleRate / 1000 * m_fake.m_audioFrameMs * 2, 0);
+}
+
+FakeRecordingEngine::~FakeRecordingEngine() {
+  stop(false);
+}
+
+int FakeRecordingEngine::joinChannel(const char * /*channelKey*/, const char *channelId, agora::linuxsdk::uid_t uid,
+    const agora::recording::RecordingConfig &config) {
+  return start(channelId, uid, NULL, config);
+}
+
+int FakeRecordingEngine::joinChannelWithUserAccount(const char * /*token*/, const char *channelId, const char *userAccount,
+    const agora::recording::RecordingConfig &config) {
+  return start(channelId, 0, userAccount ? userAccount : "", config);
+}
+
+int FakeRecordingEngine::getUserInfoByUserAccount(const char *userAccount, agora::linuxsdk::UserInfo *userinfo) {
+  unsigned int uid = 0;
+  if (!userAccount || !userinfo || sscanf(userAccount, "user-%u", &uid) != 1)
+    return agora::linuxsdk::ERR_INVALID_ARGUMENT;
+  userinfo->uid = uid;
+  snprintf(userinfo->userAccount, sizeof(userinfo->userAccount), "%s", userAccount);
+  return agora::linuxsdk::ERR_OK;
+}
+
+int FakeRecordingEngine::getUserInfoByUid(agora::linuxsdk::uid_t uid, agora::linuxsdk::UserInfo *userInfo) {
+  if (!userInfo)
+    return agora::linuxsdk::ERR_INVALID_ARGUMENT;
+  userInfo->uid = uid;
+  snprintf(userInfo->userAccount, sizeof(userInfo->userAccount), "user-%u", uid);
+  return agora::linuxsdk::ERR_OK;
+}
+
+int FakeRecordingEngine::stoppedOnError() {
+  stop(false);
+  return agora::linuxsdk::ERR_OK;
+}
+
+int FakeRecordingEngine::leaveChannel() {
+  stop(true);
+  return agora::linuxsdk::ERR_OK;
+}
+
+int FakeRecordingEngine::start(const char *channelId, agora::linuxsdk::uid_t uid, const char *userAccount,
+    const agora::recording::RecordingConfig &config) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_running)
+    return agora::linuxsdk::ERR_FAILED;
+
+  m_channel = channelId ? channelId : "";
+  m_account = userAccount ? userAccount : "";
+  m_localUid = uid ? uid : m_fake.m_firstUid - 1;
+  m_decodeVideo = config.decodeVideo;
+  m_decodeAudio = config.decodeAudio;
+  m_volumeIntervalMs = config.audioIndicationInterval > 0 ? config.audioIndicationInterval : 0;
+  m_stopping = false;
+  m_notifyLeave = false;
+  m_running = true;
+  m_thread = std::thread(&FakeRecordingEngine::run, this);
+  return agora::linuxsdk::ERR_OK;
+}
+
+void FakeRecordingEngine::stop(bool notify) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running)
+      return;
+    m_stopping = true;
+    m_notifyLeave = notify;
+  }
+  m_wake.notify_all();
+  //a handler leaving from its own callback only gets the flag; the thread
+  //is joined by whoever stops or releases the engine next
+  if (m_thread.get_id() == std::this_thread::get_id())
+    return;
+  if (m_thread.joinable())
+    m_thread.join();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_running = false;
+}
+
+uint64_t FakeRecordingEngine::nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t FakeRecordingEngine::random() {
+  //xorshift32
+  m_random ^= m_random << 13;
+  m_random ^= m_random >> 17;
+  m_random ^= m_random << 5;
+  return m_random;
+}
+
+void FakeRecordingEngine::run() {
+  uint64_t start = nowMs();
+  m_joinedMs = start;
+  if (m_handler) {
+    if (!m_account.empty())
+      m_handler->onLocalUserRegistered(m_localUid, m_account.c_str());
+    m_handler->onJoinChannelSuccess(m_channel.c_str(), m_localUid);
+  }
+  for (uint32_t i = 0; i < m_fake.m_users; i++)
+    addPeer(start);
+
+  bool video = m_decodeVideo == agora::linuxsdk::VIDEO_FORMAT_H264_FRAME_TYPE
+    || m_decodeVideo == agora::linuxsdk::VIDEO_FORMAT_YUV_FRAME_TYPE;
+  bool audio = m_decodeAudio == agora::linuxsdk::AUDIO_FORMAT_AAC_FRAME_TYPE
+    || m_decodeAudio == agora::linuxsdk::AUDIO_FORMAT_PCM_FRAME_TYPE
+    || m_decodeAudio == agora::linuxsdk::AUDIO_FORMAT_MIXED_PCM_FRAME_TYPE;
+  uint64_t videoStep = video && m_fake.m_videoFps ? 1000 / m_fake.m_videoFps : kNever;
+  uint64_t audioStep = audio ? stepFor(m_fake.m_audioFrameMs) : kNever;
+  uint64_t statsStep = stepFor(m_fake.m_statsIntervalMs);
+  uint64_t volumeStep = stepFor(m_volumeIntervalMs);
+  uint64_t churnStep = stepFor(m_fake.m_churnIntervalMs);
+  uint64_t nextVideo = videoStep == kNever ? kNever : start;
+  uint64_t nextAudio = audioStep == kNever ? kNever : start;
+  uint64_t nextStats = statsStep == kNever ? kNever : start + statsStep;
+  uint64_t nextVolume = volumeStep == kNever ? kNever : start + volumeStep;
+  uint64_t nextChurn = churnStep == kNever ? kNever : start + churnStep;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stopping) {
+    uint64_t due = std::min(std::min(nextVideo, nextAudio), std::min(std::min(nextStats, nextVolume), nextChurn));
+    if (due == kNever) {
+      m_wake.wait(lock, [this] { return m_stopping; });
+      break;
+    }
+    std::chrono::steady_clock::time_point deadline{std::chrono::milliseconds(due)};
+    if (m_wake.wait_until(lock, deadline, [this] { return m_stopping; }))
+      break;
+    lock.unlock();
+
+    uint64_t now = nowMs();
+    if (nextChurn <= now) {
+      if (!m_peers.empty())
+        removePeer();
+      addPeer(now);
+      nextChurn = now + churnStep;
+    }
+    if (nextVideo <= now) {
+      nextVideo = std::max(nextVideo, now - kMaxCatchUpMs);
+      for (; nextVideo <= now; nextVideo += videoStep)
+        sendVideo(nextVideo);
+    }
+    if (nextAudio <= now) {
+      nextAudio = std::max(nextAudio, now - kMaxCatchUpMs);
+      for (; nextAudio <= now; nextAudio += audioStep)
+        sendAudio(nextAudio);
+    }
+    if (nextVolume <= now) {
+      sendVolume();
+      nextVolume = now + volumeStep;
+    }
+    if (nextStats <= now) {
+      sendStats(now);
+      nextStats = now + statsStep;
+    }
+    lock.lock();
+  }
+  bool notify = m_notifyLeave;
+  lock.unlock();
+
+  if (notify && m_handler)
+    m_handler->onLeaveChannel(agora::linuxsdk::LEAVE_CODE_CLIENT_LEAVE);
+  m_peers.clear();
+  m_userCount = 0;
+}
+
+void FakeRecordingEngine::addPeer(uint64_t nowMs) {
+  Peer peer;
+  peer.m_uid = m_nextUid++;
+  peer.m_frameNum = 0;
+  m_peers.push_back(peer);
+  m_userCount = static_cast<uint32_t>(m_peers.size());
+  if (!m_handler)
+    return;
+
+  agora::linuxsdk::UserJoinInfos infos;
+  infos.storageDir = "";
+  m_handler->onUserJoined(peer.m_uid, infos);
+  if (!m_account.empty()) {
+    agora::linuxsdk::UserInfo info;
+    getUserInfoByUid(peer.m_uid, &info);
+    m_handler->onUserInfoUpdated(peer.m_uid, info);
+  }
+  int elapsed = static_cast<int>(nowMs - m_joinedMs);
+  m_handler->onFirstRemoteAudioFrame(peer.m_uid, elapsed);
+  m_handler->onFirstRemoteVideoDecoded(peer.m_uid, m_fake.m_videoWidth, m_fake.m_videoHeight, elapsed);
+}
+
+void FakeRecordingEngine::removePeer() {
+  uint32_t uid = m_peers.front().m_uid;
+  m_peers.erase(m_peers.begin());
+  m_userCount = static_cast<uint32_t>(m_peers.size());
+  if (m_handler)
+    m_handler->onUserOffline(uid, agora::linuxsdk::USER_OFFLINE_QUIT);
+}
+
+void FakeRecordingEngine::sendVideo(uint64_t frameMs) {
+  VideoFrame frame;
+  frame.mType = agora::linuxsdk::STACK_MEM_TYPE;
+  frame.rotation_ = 0;
+  if (m_decodeVideo == agora::linuxsdk::VIDEO_FORMAT_YUV_FRAME_TYPE) {
+    uint32_t width = m_fake.m_videoWidth;
+    agora::linuxsdk::VideoYuvFrame yuv(frameMs, width, m_fake.m_videoHeight, width, width / 2, width / 2);
+    size_t ySize = width * m_fake.m_videoHeight;
+    yuv.buf_ = m_yuv.data();
+    yuv.bufSize_ = static_cast<uint32_t>(m_yuv.size());
+    yuv.ybuf_ = m_yuv.data();
+    yuv.ubuf_ = m_yuv.data() + ySize;
+    yuv.vbuf_ = m_yuv.data() + ySize + ySize / 4;
+    frame.type = agora::linuxsdk::VIDEO_FRAME_RAW_YUV;
+    frame.frame.yuv = &yuv;
+    for (size_t i = 0; i < m_peers.size(); i++) {
+      if (m_handler)
+        m_handler->videoFrameReceived(m_peers[i].m_uid, &frame);
+      m_rxBytes += m_yuv.size();
+    }
+    //the buffers belong to us, not to the frame destructors
+    yuv.buf_ = yuv.ybuf_ = yuv.ubuf_ = yuv.vbuf_ = NULL;
+  } else {
+    agora::linuxsdk::VideoH264Frame h264;
+    h264.frame_ms_ = frameMs;
+    frame.type = agora::linuxsdk::VIDEO_FRAME_H264;
+    frame.frame.h264 = &h264;
+    for (size_t i = 0; i < m_peers.size(); i++) {
+      Peer &peer = m_peers[i];
+      bool keyframe = !m_fake.m_keyframeInterval || peer.m_frameNum % m_fake.m_keyframeInterval == 0;
+      const std::vector<unsigned char> &payload = keyframe ? m_keyframe : m_deltaFrame;
+      h264.frame_num_ = peer.m_frameNum++;
+      h264.buf_ = payload.data();
+      h264.bufSize_ = static_cast<uint32_t>(payload.size());
+      if (m_handler)
+        m_handler->videoFrameReceived(peer.m_uid, &frame);
+      m_rxBytes += payload.size();
+    }
+    h264.buf_ = NULL;
+  }
+  frame.frame.h264 = NULL;
+  m_videoFrames += m_peers.size();
+}
+
+void FakeRecordingEngine::sendAudio(uint64_t frameMs) {
+  AudioFrame frame;
+  frame.mType = agora::linuxsdk::STACK_MEM_TYPE;
+  if (m_decodeAudio == agora::linuxsdk::AUDIO_FORMAT_AAC_FRAME_TYPE) {
+    agora::linuxsdk::AudioAacFrame aac(frameMs);
+    aac.aacBuf_ = m_aac.data();
+    aac.aacBufSize_ = static_cast<uint32_t>(m_aac.size());
+    aac.channels_ = 1;
+    aac.bitrate_ = 64000;
+    frame.type = agora::linuxsdk::AUDIO_FRAME_AAC;
+    frame.frame.aac = &aac;
+    for (size_t i = 0; i < m_peers.size(); i++) {
+      if (m_handler)
+        m_handler->audioFrameReceived(m_peers[i].m_uid, &frame);
+      m_rxBytes += m_aac.size();
+    }
+    aac.aacBuf_ = NULL;
+  } else {
+    uint32_t samples = static_cast<uint32_t>(m_pcm.size() / 2);
+    agora::linuxsdk::AudioPcmFrame pcm(frameMs, m_fake.m_audioSampleRate, samples);
+    pcm.channels_ = 1;
+    pcm.sample_bits_ = 16;
+    pcm.sample_rates_ = m_fake.m_audioSampleRate;
+    pcm.samples_ = samples;
+    pcm.pcmBuf_ = m_pcm.data();
+    pcm.pcmBufSize_ = static_cast<uint32_t>(m_pcm.size());
+    frame.type = agora::linuxsdk::AUDIO_FRAME_RAW_PCM;
+    frame.frame.pcm = &pcm;
+    for (size_t i = 0; i < m_peers.size(); i++) {
+      if (m_handler)
+        m_handler->audioFrameReceived(m_peers[i].m_uid, &frame);
+      m_rxBytes += m_pcm.size();
+    }
+    pcm.pcmBuf_ = NULL;
+  }
+  frame.frame.pcm = NULL;
+  m_audioFrames += m_peers.size();
+}
+
+void FakeRecordingEngine::sendVolume() {
+  m_volumes.resize(m_peers.size());
+  uint32_t loudest = 0;
+  uint32_t loudestVolume = 0;
+  for (size_t i = 0; i < m_peers.size(); i++) {
+    m_volumes[i].uid = m_peers[i].m_uid;
+    m_volumes[i].volume = random() % 256;
+    if (m_volumes[i].volume > loudestVolume) {
+      loudest = m_peers[i].m_uid;
+      loudestVolume = m_volumes[i].volume;
+    }
+  }
+  if (!m_handler || m_volumes.empty())
+    return;
+  m_handler->onAudioVolumeIndication(m_volumes.data(), static_cast<unsigned int>(m_volumes.size()));
+  if (loudest && loudest != m_activeSpeaker) {
+    m_activeSpeaker = loudest;
+    m_handler->onActiveSpeaker(loudest);
+  }
+}
+
+void FakeRecordingEngine::sendStats(uint64_t nowMs) {
+  if (!m_handler)
+    return;
+  int videoKbps = static_cast<int>(m_keyframe.size() * 8 * m_fake.m_videoFps / 1000);
+  for (size_t i = 0; i < m_peers.size(); i++) {
+    agora::linuxsdk::RemoteVideoStats video;
+    video.delay = 20 + random() % 60;
+    video.width = m_fake.m_videoWidth;
+    video.height = m_fake.m_videoHeight;
+    video.receivedBitrate = videoKbps;
+    video.decoderOutputFrameRate = m_fake.m_videoFps;
+    m_handler->onRemoteVideoStats(m_peers[i].m_uid, video);
+
+    agora::linuxsdk::RemoteAudioStats audio;
+    audio.quality = 1;
+    audio.networkTransportDelay = 10 + random() % 40;
+    audio.jitterBufferDelay = 20 + random() % 40;
+    audio.audioLossRate = random() % 3;
+    m_handler->onRemoteAudioStats(m_peers[i].m_uid, audio);
+  }
+
+  uint64_t elapsedMs = nowMs - m_joinedMs;
+  agora::linuxsdk::RecordingStats stats;
+  stats.duration = static_cast<uint32_t>(elapsedMs / 1000);
+  stats.rxBytes = static_cast<uint32_t>(m_rxBytes);
+  stats.rxKBitRate = elapsedMs ? static_cast<uint32_t>(m_rxBytes * 8 / elapsedMs) : 0;
+  stats.rxVideoKBitRate = videoKbps * static_cast<uint32_t>(m_peers.size());
+  stats.rxAudioKBitRate = 64 * static_cast<uint32_t>(m_peers.size());
+  stats.lastmileDelay = 10 + random() % 20;
+  stats.userCount = static_cast<uint32_t>(m_peers.size());
+  m_handler->onRecordingStats(stats);
+}
+
+}
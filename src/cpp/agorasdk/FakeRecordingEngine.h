@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "StubRecordingEngine.h"
+
+namespace agora {
+
+//Rates and sizes for FakeRecordingEngine. An interval or rate of 0 turns
+//that event off. Mirrored by FakeEngineConfig in lib.rs.
+struct FakeEngineConfig {
+    uint32_t m_users;
+    uint32_t m_firstUid;
+    uint32_t m_videoFps;
+    uint32_t m_videoFrameBytes;
+    uint32_t m_keyframeInterval;
+    uint32_t m_videoWidth;
+    uint32_t m_videoHeight;
+    uint32_t m_audioFrameMs;
+    uint32_t m_audioSampleRate;
+    uint32_t m_statsIntervalMs;
+    uint32_t m_churnIntervalMs;
+    uint32_t m_seed;
+    FakeEngineConfig():
+        m_users(16),
+        m_firstUid(1000),
+        m_videoFps(15),
+        m_videoFrameBytes(4096),
+        m_keyframeInterval(30),
+        m_videoWidth(320),
+        m_videoHeight(180),
+        m_audioFrameMs(20),
+        m_audioSampleRate(48000),
+        m_statsIntervalMs(2000),
+        m_churnIntervalMs(0),
+        m_seed(1)
+    {};
+};
+
+//In-process engine that needs no AgoraCoreService. joinChannel starts a
+//thread that plays a channel of m_users synthetic peers into the handler:
+//joins, leaves every m_churnIntervalMs, remote and recording stats, volume
+//indications at the config's audioIndicationInterval, and frames in the
+//formats picked by decodeVideo/decodeAudio (H.264 with periodic IDRs or
+//YUV; AAC or PCM). Payloads are preallocated and shared by all peers.
+class FakeRecordingEngine : public StubRecordingEngine {
+    public:
+        FakeRecordingEngine(agora::recording::IRecordingEngineEventHandler *handler, const FakeEngineConfig &config);
+        virtual ~FakeRecordingEngine();
+
+        virtual int joinChannel(const char *channelKey, const char *channelId, agora::linuxsdk::uid_t uid,
+                const agora::recording::RecordingConfig &config);
+        virtual int joinChannelWithUserAccount(const char *token, const char *channelId, const char *userAccount,
+                const agora::recording::RecordingConfig &config);
+        virtual int getUserInfoByUserAccount(const char *userAccount, agora::linuxsdk::UserInfo *userinfo);
+        virtual int getUserInfoByUid(agora::linuxsdk::uid_t uid, agora::linuxsdk::UserInfo *userInfo);
+        virtual int stoppedOnError();
+        virtual int leaveChannel();
+
+        uint64_t videoFrames() const { return m_videoFrames.load(); }
+        uint64_t audioFrames() const { return m_audioFrames.load(); }
+        uint32_t userCount() const { return m_userCount.load(); }
+
+    private:
+        struct Peer {
+            uint32_t m_uid;
+            uint32_t m_frameNum;
+        };
+
+        int start(const char *channelId, agora::linuxsdk::uid_t uid, const char *userAccount,
+                const agora::recording::RecordingConfig &config);
+        void stop(bool notify);
+        void run();
+        void addPeer(uint64_t nowMs);
+        void removePeer();
+        void sendVideo(uint64_t frameMs);
+        void sendAudio(uint64_t frameMs);
+        void sendStats(uint64_t nowMs);
+        void sendVolume();
+        uint32_t random();
+        static uint64_t nowMs();
+
+        agora::recording::IRecordingEngineEventHandler *m_handler;
+        FakeEngineConfig m_fake;
+        agora::linuxsdk::VIDEO_FORMAT_TYPE m_decodeVideo;
+        agora::linuxsdk::AUDIO_FORMAT_TYPE m_decodeAudio;
+        uint32_t m_volumeIntervalMs;
+        std::string m_channel;
+        std::string m_account;
+        agora::linuxsdk::uid_t m_localUid;
+        uint32_t m_nextUid;
+        uint32_t m_random;
+        uint64_t m_joinedMs;
+        uint64_t m_rxBytes;
+        uint32_t m_activeSpeaker;
+        std::vector<Peer> m_peers;
+        std::vector<unsigned char> m_keyframe;
+        std::vector<unsigned char> m_deltaFrame;
+        std::vector<unsigned char> m_yuv;
+        std::vector<unsigned char> m_aac;
+        std::vector<unsigned char> m_pcm;
+        std::vector<agora::linuxsdk::AudioVolumeInfo> m_volumes;
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_running;
+        bool m_stopping;
+        bool m_notifyLeave;
+        std::atomic<uint64_t> m_videoFrames;
+        std::atomic<uint64_t> m_audioFrames;
+        std::atomic<uint32_t> m_userCount;
+};
+
+}
@@ -0,0 +1,185 @@
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "FlatSet.h"
+
+namespace agora {
+
+//elements compared at once at the end of a search, and the largest set that
+//is scanned outright
+static const size_t kBlock = 16;
+
+uint32_t hashBytes(const char *bytes, size_t length) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    h ^= static_cast<unsigned char>(bytes[i]);
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static bool scanBlock(const agora::linuxsdk::uid_t *uids, size_t count, agora::linuxsdk::uid_t uid) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  __m256i key = _mm256_set1_epi32(static_cast<int>(uid));
+  for (; i + 8 <= count; i += 8) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uids + i));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(block, key)))
+      return true;
+  }
+#elif defined(__SSE2__)
+  __m128i key = _mm_set1_epi32(static_cast<int>(uid));
+  for (; i + 4 <= count; i += 4) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uids + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(block, key)))
+      return true;
+  }
+#endif
+  for (; i < count; i++) {
+    if (uids[i] == uid)
+      return true;
+  }
+  return false;
+}
+
+bool FlatUidSet::contains(agora::linuxsdk::uid_t uid) const {
+  const agora::linuxsdk::uid_t *base = m_uids.data();
+  const agora::linuxsdk::uid_t *end = base + m_uids.size();
+  size_t count = m_uids.size();
+  //the first uid >= the key stays within [base, base + count]
+  while (count > kBlock) {
+    size_t half = count / 2;
+    base = base[half] < uid ? base + half : base;
+    count -= half;
+  }
+  size_t block = static_cast<size_t>(end - base);
+  return scanBlock(base, block < count + 1 ? block : count + 1, uid);
+}
+
+size_t FlatUidSet::containsBatch(const agora::linuxsdk::uid_t *uids, size_t count, uint8_t *found) const {
+  size_t hits = 0;
+  size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  //a small set is compared against several queries at once, one set
+  //element at a time
+  if (m_uids.size() <= kBlock) {
+#if defined(__AVX2__)
+    const size_t lanes = 8;
+#else
+    const size_t lanes = 4;
+#endif
+    for (; i + lanes <= count; i += lanes) {
+      int mask = 0;
+#if defined(__AVX2__)
+      __m256i queries = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uids + i));
+      for (size_t j = 0; j < m_uids.size(); j++)
+        mask |= _mm256_movemask_ps(_mm256_castsi256_ps(
+            _mm256_cmpeq_epi32(queries, _mm256_set1_epi32(static_cast<int>(m_uids[j])))));
+#else
+      __m128i queries = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uids + i));
+      for (size_t j = 0; j < m_uids.size(); j++)
+        mask |= _mm_movemask_ps(_mm_castsi128_ps(
+            _mm_cmpeq_epi32(queries, _mm_set1_epi32(static_cast<int>(m_uids[j])))));
+#endif
+      for (size_t lane = 0; lane < lanes; lane++) {
+        found[i + lane] = (mask >> lane) & 1;
+        hits += found[i + lane];
+      }
+    }
+  }
+#endif
+  //larger sets run a group of searches in lockstep; every search takes the
+  //same steps, so their loads are independent and overlap in the cache
+  //misses that dominate a lone search
+  const size_t group = 8;
+  const agora::linuxsdk::uid_t *end = m_uids.data() + m_uids.size();
+  for (; m_uids.size() > kBlock && i + group <= count; i += group) {
+    const agora::linuxsdk::uid_t *base[group];
+    for (size_t g = 0; g < group; g++)
+      base[g] = m_uids.data();
+    size_t remaining = m_uids.size();
+    while (remaining > kBlock) {
+      size_t half = remaining / 2;
+      for (size_t g = 0; g < group; g++)
+        base[g] = base[g][half] < uids[i + g] ? base[g] + half : base[g];
+      remaining -= half;
+    }
+    for (size_t g = 0; g < group; g++) {
+      size_t block = static_cast<size_t>(end - base[g]);
+      found[i + g] = scanBlock(base[g], block < remaining + 1 ? block : remaining + 1, uids[i + g]) ? 1 : 0;
+      hits += found[i + g];
+    }
+  }
+  for (; i < count; i++) {
+    found[i] = contains(uids[i]) ? 1 : 0;
+    hits += found[i];
+  }
+  return hits;
+}
+
+static const size_t kInitialSlots = 16;
+
+const uint32_t FlatAccountSet::kEmpty;
+
+FlatAccountSet::FlatAccountSet() :
+  m_slots(kInitialSlots, kEmpty)
+{
+}
+
+size_t FlatAccountSet::find(const char *account, size_t length, uint32_t hash) const {
+  size_t mask = m_slots.size() - 1;
+  for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    uint32_t index = m_slots[slot];
+    if (index == kEmpty)
+      return slot;
+    const Entry &entry = m_entries[index];
+    if (entry.m_hash == hash && entry.m_length == length && memcmp(&m_chars[entry.m_offset], account, length) == 0)
+      return slot;
+  }
+}
+
+void FlatAccountSet::grow() {
+  size_t mask = m_slots.size() * 2 - 1;
+  m_slots.assign(mask + 1, kEmpty);
+  for (uint32_t i = 0; i < m_entries.size(); i++) {
+    size_t slot = m_entries[i].m_hash & mask;
+    while (m_slots[slot] != kEmpty)
+      slot = (slot + 1) & mask;
+    m_slots[slot] = i;
+  }
+}
+
+bool FlatAccountSet::insert(const char *account, size_t length) {
+  if ((m_entries.size() + 1) * 2 > m_slots.size())
+    grow();
+  uint32_t hash = hashBytes(account, length);
+  size_t slot = find(account, length, hash);
+  if (m_slots[slot] != kEmpty)
+    return false;
+
+  Entry entry;
+  entry.m_offset = static_cast<uint32_t>(m_chars.size());
+  entry.m_length = static_cast<uint32_t>(length);
+  entry.m_hash = hash;
+  m_chars.insert(m_chars.end(), account, account + length);
+  m_slots[slot] = static_cast<uint32_t>(m_entries.size());
+  m_entries.push_back(entry);
+  return true;
+}
+
+bool FlatAccountSet::contains(const char *account, size_t length) const {
+  return m_slots[find(account, length, hashBytes(account, length))] != kEmpty;
+}
+
+void FlatAccountSet::clear() {
+  m_chars.clear();
+  m_entries.clear();
+  m_slots.assign(kInitialSlots, kEmpty);
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "IAgoraLinuxSdkCommon.h"
+
+namespace agora {
+
+//FNV-1a over the bytes of a string.
+uint32_t hashBytes(const char *bytes, size_t length);
+
+//Membership of uids in one sorted contiguous array. A lookup narrows the
+//array to a small block with a branchless binary search and compares the
+//whole block at once with SIMD (AVX2 when the build enables it, SSE2
+//otherwise on x86, scalar elsewhere). Sets small enough to be one block are
+//probed a batch of uids at a time instead.
+class FlatUidSet {
+    public:
+        FlatUidSet() {}
+
+        //uids must be sorted and distinct.
+        void assign(const std::vector<agora::linuxsdk::uid_t> &uids) { m_uids = uids; }
+        void swap(std::vector<agora::linuxsdk::uid_t> &uids) { m_uids.swap(uids); }
+        void clear() { m_uids.clear(); }
+
+        bool contains(agora::linuxsdk::uid_t uid) const;
+        //found[i] is set to 1 or 0 for uids[i]; returns the number found.
+        size_t containsBatch(const agora::linuxsdk::uid_t *uids, size_t count, uint8_t *found) const;
+
+        const std::vector<agora::linuxsdk::uid_t>& uids() const { return m_uids; }
+        size_t size() const { return m_uids.size(); }
+        bool empty() const { return m_uids.empty(); }
+
+    private:
+        std::vector<agora::linuxsdk::uid_t> m_uids;
+};
+
+//Set of account strings in flat storage: the characters of every account in
+//one pool, an entry per account with its offset, length and hash, and an
+//open addressing table of entry indexes kept at most half full. A probe
+//compares stored hashes before touching the characters.
+class FlatAccountSet {
+    public:
+        FlatAccountSet();
+
+        //False if the account was already there.
+        bool insert(const char *account, size_t length);
+        bool contains(const char *account, size_t length) const;
+        void clear();
+
+        size_t size() const { return m_entries.size(); }
+
+    private:
+        struct Entry {
+            uint32_t m_offset;
+            uint32_t m_length;
+            uint32_t m_hash;
+        };
+
+        static const uint32_t kEmpty = 0xffffffff;
+
+        //slot holding the account, or the empty slot it would go in
+        size_t find(const char *account, size_t length, uint32_t hash) const;
+        void grow();
+
+        std::vector<char> m_chars;
+        std::vector<Entry> m_entries;
+        std::vector<uint32_t> m_slots;
+};
+
+}
@@ -0,0 +1,144 @@
+#include <cstring>
+
+#include "FramePool.h"
+
+namespace agora {
+
+FrameBuffer::FrameBuffer(FramePool *pool, int sizeClass, size_t capacity) :
+  m_pool(pool)
+  , m_sizeClass(sizeClass)
+  , m_capacity(capacity)
+  , m_size(0)
+  , m_refs(1)
+  , m_data(new unsigned char[capacity])
+{
+}
+
+FrameBuffer::~FrameBuffer() {
+  delete []m_data;
+}
+
+void FrameBuffer::retain() {
+  m_refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameBuffer::release() {
+  if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    m_pool->recycle(this);
+}
+
+FramePool::FramePool(size_t maxCachedPerClass) :
+  m_maxCachedPerClass(maxCachedPerClass)
+  , m_hits(0)
+  , m_misses(0)
+  , m_inUse(0)
+  , m_highWater(0)
+  , m_inUseBytes(0)
+  , m_highWaterBytes(0)
+  , m_cachedBytes(0)
+{
+}
+
+FramePool::~FramePool() {
+  trim();
+}
+
+FramePool* FramePool::shared() {
+  //never destroyed, so buffers released during static destruction still have a pool
+  static FramePool *pool = new FramePool();
+  return pool;
+}
+
+int FramePool::sizeClassFor(size_t bytes) {
+  size_t classBytes = static_cast<size_t>(1) << kMinClassShift;
+  for (int sizeClass = 0; sizeClass < kSizeClasses; sizeClass++) {
+    if (bytes <= classBytes)
+      return sizeClass;
+    classBytes <<= 1;
+  }
+  return -1;
+}
+
+void FramePool::raise(std::atomic<uint64_t> &mark, uint64_t value) {
+  uint64_t current = mark.load(std::memory_order_relaxed);
+  while (value > current && !mark.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+FrameBuffer* FramePool::acquire(size_t bytes) {
+  int sizeClass = sizeClassFor(bytes);
+  FrameBuffer *buffer = NULL;
+  if (sizeClass >= 0) {
+    std::lock_guard<std::mutex> lock(m_mutex[sizeClass]);
+    if (!m_free[sizeClass].empty()) {
+      buffer = m_free[sizeClass].back();
+      m_free[sizeClass].pop_back();
+    }
+  }
+
+  if (buffer) {
+    m_hits++;
+    m_cachedBytes -= buffer->m_capacity;
+    buffer->m_refs.store(1, std::memory_order_relaxed);
+  } else {
+    m_misses++;
+    size_t capacity = sizeClass >= 0 ? (static_cast<size_t>(1) << (kMinClassShift + sizeClass)) : bytes;
+    buffer = new FrameBuffer(this, sizeClass, capacity);
+  }
+  buffer->m_size = bytes;
+
+  raise(m_highWater, ++m_inUse);
+  raise(m_highWaterBytes, m_inUseBytes += buffer->m_capacity);
+  return buffer;
+}
+
+FrameBuffer* FramePool::copy(const unsigned char *data, size_t bytes) {
+  FrameBuffer *buffer = acquire(bytes);
+  if (bytes > 0)
+    memcpy(buffer->m_data, data, bytes);
+  return buffer;
+}
+
+void FramePool::recycle(FrameBuffer *buffer) {
+  m_inUse--;
+  m_inUseBytes -= buffer->m_capacity;
+
+  int sizeClass = buffer->m_sizeClass;
+  if (sizeClass >= 0) {
+    std::lock_guard<std::mutex> lock(m_mutex[sizeClass]);
+    if (m_free[sizeClass].size() < m_maxCachedPerClass) {
+      m_free[sizeClass].push_back(buffer);
+      m_cachedBytes += buffer->m_capacity;
+      return;
+    }
+  }
+  delete buffer;
+}
+
+void FramePool::trim() {
+  for (int sizeClass = 0; sizeClass < kSizeClasses; sizeClass++) {
+    std::vector<FrameBuffer*> buffers;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex[sizeClass]);
+      buffers.swap(m_free[sizeClass]);
+    }
+    for (size_t i = 0; i < buffers.size(); i++) {
+      m_cachedBytes -= buffers[i]->m_capacity;
+      delete buffers[i];
+    }
+  }
+}
+
+FramePoolStats FramePool::stats() const {
+  FramePoolStats stats;
+  stats.m_hits = m_hits.load();
+  stats.m_misses = m_misses.load();
+  stats.m_inUse = m_inUse.load();
+  stats.m_highWater = m_highWater.load();
+  stats.m_inUseBytes = m_inUseBytes.load();
+  stats.m_highWaterBytes = m_highWaterBytes.load();
+  stats.m_cachedBytes = m_cachedBytes.load();
+  return stats;
+}
+
+}
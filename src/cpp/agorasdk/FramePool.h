@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace agora {
+
+class FramePool;
+
+//Refcounted slab handed out by FramePool. The last release() returns it to
+//the pool's free list for its size class instead of freeing the memory.
+class FrameBuffer {
+    public:
+        unsigned char* data() { return m_data; }
+        const unsigned char* data() const { return m_data; }
+        size_t size() const { return m_size; }
+        void setSize(size_t size) { m_size = size < m_capacity ? size : m_capacity; }
+        size_t capacity() const { return m_capacity; }
+
+        void retain();
+        void release();
+        int refCount() const { return m_refs.load(); }
+
+    private:
+        friend class FramePool;
+        FrameBuffer(FramePool *pool, int sizeClass, size_t capacity);
+        ~FrameBuffer();
+
+        FramePool *m_pool;
+        int m_sizeClass;
+        size_t m_capacity;
+        size_t m_size;
+        std::atomic<int> m_refs;
+        unsigned char *m_data;
+};
+
+struct FramePoolStats {
+    uint64_t m_hits;
+    uint64_t m_misses;
+    uint64_t m_inUse;
+    uint64_t m_highWater;
+    uint64_t m_inUseBytes;
+    uint64_t m_highWaterBytes;
+    uint64_t m_cachedBytes;
+    FramePoolStats():
+        m_hits(0),
+        m_misses(0),
+        m_inUse(0),
+        m_highWater(0),
+        m_inUseBytes(0),
+        m_highWaterBytes(0),
+        m_cachedBytes(0)
+    {};
+};
+
+//Power-of-two size classes from 4 KB to 16 MB. Requests above the largest
+//class are allocated exactly and freed on release.
+class FramePool {
+    public:
+        enum {
+            kMinClassShift = 12,
+            kSizeClasses = 13,
+        };
+
+        explicit FramePool(size_t maxCachedPerClass = 64);
+        ~FramePool();
+
+        static FramePool* shared();
+
+        FrameBuffer* acquire(size_t bytes);
+        FrameBuffer* copy(const unsigned char *data, size_t bytes);
+        void trim();
+        void setMaxCachedPerClass(size_t count) { m_maxCachedPerClass = count; }
+        FramePoolStats stats() const;
+
+    private:
+        friend class FrameBuffer;
+        void recycle(FrameBuffer *buffer);
+        static int sizeClassFor(size_t bytes);
+        static void raise(std::atomic<uint64_t> &mark, uint64_t value);
+
+        std::mutex m_mutex[kSizeClasses];
+        std::vector<FrameBuffer*> m_free[kSizeClasses];
+        std::atomic<size_t> m_maxCachedPerClass;
+        std::atomic<uint64_t> m_hits;
+        std::atomic<uint64_t> m_misses;
+        std::atomic<uint64_t> m_inUse;
+        std::atomic<uint64_t> m_highWater;
+        std::atomic<uint64_t> m_inUseBytes;
+        std::atomic<uint64_t> m_highWaterBytes;
+        std::atomic<uint64_t> m_cachedBytes;
+};
+
+}
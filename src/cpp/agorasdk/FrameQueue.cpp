@@ -0,0 +1,304 @@
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+#include "FrameQueue.h"
+
+namespace agora {
+
+static size_t roundCapacity(size_t capacity) {
+  size_t rounded = 2;
+  while (rounded < capacity)
+    rounded <<= 1;
+  return rounded;
+}
+
+FrameQueue::FrameQueue(size_t capacity, FRAME_QUEUE_POLICY policy, uint32_t blockTimeoutMs, FramePool *pool) :
+  m_pool(pool ? pool : FramePool::shared())
+  , m_policy(policy)
+  , m_blockTimeoutMs(blockTimeoutMs)
+  , m_mask(roundCapacity(capacity) - 1)
+  , m_cells(new Cell[m_mask + 1])
+  , m_enqueuePos(0)
+  , m_dequeuePos(0)
+  , m_refs(1)
+  , m_closed(false)
+  , m_pushed(0)
+  , m_popped(0)
+  , m_dropped(0)
+  , m_waiters(0)
+{
+  for (size_t i = 0; i <= m_mask; i++)
+    m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+  for (size_t i = 0; i < kUidSlots; i++) {
+    m_uids[i].m_key.store(0, std::memory_order_relaxed);
+    m_uids[i].m_dropped.store(0, std::memory_order_relaxed);
+    m_uids[i].m_needKeyframe.store(false, std::memory_order_relaxed);
+  }
+  m_otherUids.m_key.store(0, std::memory_order_relaxed);
+  m_otherUids.m_dropped.store(0, std::memory_order_relaxed);
+  m_otherUids.m_needKeyframe.store(false, std::memory_order_relaxed);
+}
+
+FrameQueue::~FrameQueue() {
+  QueuedFrame frame;
+  while (tryDequeue(frame))
+    frame.m_buffer->release();
+  delete []m_cells;
+}
+
+void FrameQueue::retain() {
+  m_refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameQueue::release() {
+  if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    delete this;
+}
+
+bool FrameQueue::pushVideo(uint32_t uid, const VideoFrameView &view) {
+  if (m_closed.load(std::memory_order_relaxed))
+    return false;
+
+  QueuedFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.m_uid = uid;
+  frame.m_type = QUEUED_VIDEO_FRAME;
+  frame.m_keyframe = isVideoKeyframe(view);
+  frame.m_video = view;
+
+  //decide what would be discarded before paying for the copy
+  if (m_policy == FRAME_QUEUE_KEYFRAMES_ONLY && !frame.m_keyframe) {
+    const UidSlot *slot = slotFor(uid);
+    if ((slot && slot->m_needKeyframe.load(std::memory_order_relaxed)) || size() > m_mask) {
+      drop(frame);
+      return false;
+    }
+  } else if (m_policy == FRAME_QUEUE_DROP_NEWEST && size() > m_mask) {
+    drop(frame);
+    return false;
+  }
+
+  frame.m_buffer = copyVideoFrameView(m_pool, view, frame.m_video);
+  return push(frame);
+}
+
+bool FrameQueue::pushAudio(uint32_t uid, const AudioFrameView &view) {
+  if (m_closed.load(std::memory_order_relaxed))
+    return false;
+
+  QueuedFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.m_uid = uid;
+  frame.m_type = QUEUED_AUDIO_FRAME;
+  frame.m_audio = view;
+
+  if ((m_policy == FRAME_QUEUE_DROP_NEWEST || m_policy == FRAME_QUEUE_KEYFRAMES_ONLY) && size() > m_mask) {
+    drop(frame);
+    return false;
+  }
+
+  frame.m_buffer = copyAudioFrameView(m_pool, view, frame.m_audio);
+  return push(frame);
+}
+
+bool FrameQueue::push(QueuedFrame &frame) {
+  bool keyframe = frame.m_type == QUEUED_VIDEO_FRAME && frame.m_keyframe;
+  switch (m_policy) {
+  case FRAME_QUEUE_KEYFRAMES_ONLY:
+    if (keyframe) {
+      while (!tryEnqueue(frame))
+        evictOldest();
+      if (UidSlot *slot = slotFor(frame.m_uid, false))
+        slot->m_needKeyframe.store(false, std::memory_order_relaxed);
+      break;
+    }
+    //fall through
+  case FRAME_QUEUE_DROP_NEWEST:
+    if (!tryEnqueue(frame)) {
+      drop(frame);
+      return false;
+    }
+    break;
+  case FRAME_QUEUE_BLOCK: {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+      + std::chrono::milliseconds(m_blockTimeoutMs);
+    for (unsigned spins = 0; !tryEnqueue(frame); spins++) {
+      if (m_closed.load(std::memory_order_relaxed) || std::chrono::steady_clock::now() >= deadline) {
+        drop(frame);
+        return false;
+      }
+      if (spins < 64)
+        std::this_thread::yield();
+      else
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    break;
+  }
+  default:
+    while (!tryEnqueue(frame))
+      evictOldest();
+    break;
+  }
+
+  m_pushed++;
+  wake();
+  return true;
+}
+
+bool FrameQueue::pop(QueuedFrame &frame, uint32_t timeoutMs) {
+  bool popped = tryDequeue(frame);
+  if (!popped && timeoutMs > 0) {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+      + std::chrono::milliseconds(timeoutMs);
+    std::unique_lock<std::mutex> lock(m_waitMutex);
+    m_waiters++;
+    //pairs with the fence in wake() so a push is either seen here or notifies us
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!(popped = tryDequeue(frame)) && !m_closed.load()) {
+      if (m_waitCond.wait_until(lock, deadline) == std::cv_status::timeout) {
+        popped = tryDequeue(frame);
+        break;
+      }
+    }
+    m_waiters--;
+  }
+  if (popped)
+    m_popped++;
+  return popped;
+}
+
+void FrameQueue::close() {
+  m_closed.store(true);
+  std::lock_guard<std::mutex> lock(m_waitMutex);
+  m_waitCond.notify_all();
+}
+
+void FrameQueue::wake() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_waiters.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lock(m_waitMutex);
+    m_waitCond.notify_one();
+  }
+}
+
+size_t FrameQueue::size() const {
+  size_t dequeuePos = m_dequeuePos.load(std::memory_order_relaxed);
+  size_t enqueuePos = m_enqueuePos.load(std::memory_order_relaxed);
+  return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+}
+
+//Bounded MPMC ring: each cell's sequence says whether it is free for the
+//producer at position pos (== pos) or holds the frame for pos (== pos + 1).
+bool FrameQueue::tryEnqueue(const QueuedFrame &frame) {
+  size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+  Cell *cell;
+  for (;;) {
+    cell = &m_cells[pos & m_mask];
+    size_t seq = cell->m_sequence.load(std::memory_order_acquire);
+    intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = m_enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+  cell->m_frame = frame;
+  cell->m_sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool FrameQueue::tryDequeue(QueuedFrame &frame) {
+  size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+  Cell *cell;
+  for (;;) {
+    cell = &m_cells[pos & m_mask];
+    size_t seq = cell->m_sequence.load(std::memory_order_acquire);
+    intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+    if (diff == 0) {
+      if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = m_dequeuePos.load(std::memory_order_relaxed);
+    }
+  }
+  frame = cell->m_frame;
+  cell->m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+  return true;
+}
+
+bool FrameQueue::evictOldest() {
+  QueuedFrame oldest;
+  if (!tryDequeue(oldest))
+    return false;
+  drop(oldest);
+  return true;
+}
+
+void FrameQueue::drop(const QueuedFrame &frame) {
+  m_dropped++;
+  UidSlot *slot = slotFor(frame.m_uid, true);
+  slot->m_dropped++;
+  //later delta frames reference the lost one, so wait for the next keyframe
+  if (m_policy == FRAME_QUEUE_KEYFRAMES_ONLY && frame.m_type == QUEUED_VIDEO_FRAME)
+    slot->m_needKeyframe.store(true, std::memory_order_relaxed);
+  if (frame.m_buffer)
+    frame.m_buffer->release();
+}
+
+//Open addressing keyed by uid + 1 so that 0 marks a free slot.
+FrameQueue::UidSlot* FrameQueue::slotFor(uint32_t uid, bool create) {
+  uint64_t key = static_cast<uint64_t>(uid) + 1;
+  size_t index = (uid * 2654435761u) & (kUidSlots - 1);
+  for (size_t probe = 0; probe < kUidSlots; probe++) {
+    UidSlot &slot = m_uids[(index + probe) & (kUidSlots - 1)];
+    uint64_t current = slot.m_key.load(std::memory_order_acquire);
+    if (current == 0) {
+      if (!create)
+        return NULL;
+      if (slot.m_key.compare_exchange_strong(current, key, std::memory_order_acq_rel) || current == key)
+        return &slot;
+    } else if (current == key) {
+      return &slot;
+    }
+  }
+  return create ? &m_otherUids : NULL;
+}
+
+const FrameQueue::UidSlot* FrameQueue::slotFor(uint32_t uid) const {
+  return const_cast<FrameQueue*>(this)->slotFor(uid, false);
+}
+
+uint64_t FrameQueue::droppedFor(uint32_t uid) const {
+  const UidSlot *slot = slotFor(uid);
+  return slot ? slot->m_dropped.load() : 0;
+}
+
+size_t FrameQueue::droppedByUid(uint32_t *uids, uint64_t *counts, size_t max) const {
+  size_t count = 0;
+  for (size_t i = 0; i < kUidSlots && count < max; i++) {
+    uint64_t key = m_uids[i].m_key.load(std::memory_order_acquire);
+    if (key == 0)
+      continue;
+    uids[count] = static_cast<uint32_t>(key - 1);
+    counts[count] = m_uids[i].m_dropped.load();
+    count++;
+  }
+  return count;
+}
+
+FrameQueueStats FrameQueue::stats() const {
+  FrameQueueStats stats;
+  stats.m_pushed = m_pushed.load();
+  stats.m_popped = m_popped.load();
+  stats.m_dropped = m_dropped.load();
+  stats.m_size = size();
+  return stats;
+}
+
+}
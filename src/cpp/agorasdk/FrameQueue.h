@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "FramePool.h"
+#include "FrameView.h"
+
+namespace agora {
+
+enum FRAME_QUEUE_POLICY {
+    FRAME_QUEUE_DROP_OLDEST = 0,
+    FRAME_QUEUE_DROP_NEWEST = 1,
+    FRAME_QUEUE_KEYFRAMES_ONLY = 2,
+    FRAME_QUEUE_BLOCK = 3,
+};
+
+enum QUEUED_FRAME_TYPE {
+    QUEUED_VIDEO_FRAME = 0,
+    QUEUED_AUDIO_FRAME = 1,
+};
+
+//A frame copied out of an SDK callback. The view pointers refer to m_buffer,
+//whose reference passes to whoever pops the frame.
+struct QueuedFrame {
+    uint32_t m_uid;
+    uint32_t m_type;
+    bool m_keyframe;
+    VideoFrameView m_video;
+    AudioFrameView m_audio;
+    FrameBuffer *m_buffer;
+};
+
+struct FrameQueueStats {
+    uint64_t m_pushed;
+    uint64_t m_popped;
+    uint64_t m_dropped;
+    uint64_t m_size;
+    FrameQueueStats():
+        m_pushed(0),
+        m_popped(0),
+        m_dropped(0),
+        m_size(0)
+    {};
+};
+
+//Bounded lock-free ring between the SDK frame callbacks (any number of
+//producer threads) and slow consumers. When the ring is full the policy
+//decides what goes:
+//  DROP_OLDEST      evict the oldest queued frame
+//  DROP_NEWEST      discard the incoming frame
+//  KEYFRAMES_ONLY   like DROP_NEWEST, but once a uid loses a video frame its
+//                   delta frames are discarded until the next keyframe, and
+//                   keyframes evict the oldest frame rather than being lost
+//  BLOCK            wait up to the block timeout for room, then discard
+//Refcounted so the SDK bridge and the consumer can both hold it.
+class FrameQueue {
+    public:
+        FrameQueue(size_t capacity, FRAME_QUEUE_POLICY policy, uint32_t blockTimeoutMs = 0,
+                FramePool *pool = FramePool::shared());
+
+        void retain();
+        void release();
+
+        bool pushVideo(uint32_t uid, const VideoFrameView &view);
+        bool pushAudio(uint32_t uid, const AudioFrameView &view);
+        //Waits up to timeoutMs for a frame. Returns false on timeout or once
+        //the queue is closed and drained.
+        bool pop(QueuedFrame &frame, uint32_t timeoutMs);
+        void close();
+        bool closed() const { return m_closed.load(); }
+
+        size_t capacity() const { return m_mask + 1; }
+        size_t size() const;
+        FRAME_QUEUE_POLICY policy() const { return m_policy; }
+        FrameQueueStats stats() const;
+        uint64_t droppedFor(uint32_t uid) const;
+        //Copies up to max (uid, dropped) pairs, returns how many were written.
+        size_t droppedByUid(uint32_t *uids, uint64_t *counts, size_t max) const;
+
+    private:
+        enum {
+            kUidSlots = 1024,
+        };
+
+        struct Cell {
+            std::atomic<size_t> m_sequence;
+            QueuedFrame m_frame;
+        };
+
+        struct UidSlot {
+            std::atomic<uint64_t> m_key;
+            std::atomic<uint64_t> m_dropped;
+            std::atomic<bool> m_needKeyframe;
+        };
+
+        ~FrameQueue();
+        bool push(QueuedFrame &frame);
+        bool tryEnqueue(const QueuedFrame &frame);
+        bool tryDequeue(QueuedFrame &frame);
+        bool evictOldest();
+        void drop(const QueuedFrame &frame);
+        void wake();
+        UidSlot* slotFor(uint32_t uid, bool create);
+        const UidSlot* slotFor(uint32_t uid) const;
+
+        FramePool *m_pool;
+        FRAME_QUEUE_POLICY m_policy;
+        uint32_t m_blockTimeoutMs;
+        size_t m_mask;
+        Cell *m_cells;
+        std::atomic<size_t> m_enqueuePos;
+        std::atomic<size_t> m_dequeuePos;
+        std::atomic<int> m_refs;
+        std::atomic<bool> m_closed;
+        std::atomic<uint64_t> m_pushed;
+        std::atomic<uint64_t> m_popped;
+        std::atomic<uint64_t> m_dropped;
+        UidSlot m_uids[kUidSlots];
+        //uids that did not fit in m_uids
+        UidSlot m_otherUids;
+
+        std::mutex m_waitMutex;
+        std::condition_variable m_waitCond;
+        std::atomic<int> m_waiters;
+};
+
+}
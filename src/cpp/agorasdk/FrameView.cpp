@@ -0,0 +1,170 @@
+#include <cstring>
+
+#include "FrameView.h"
+#include "FramePool.h"
+
+namespace agora {
+
+bool fillAudioFrameView(const agora::linuxsdk::AudioFrame *frame, AudioFrameView &view) {
+  memset(&view, 0, sizeof(view));
+  view.kind = frame->type;
+  switch (frame->type) {
+  case agora::linuxsdk::AUDIO_FRAME_RAW_PCM: {
+    const agora::linuxsdk::AudioPcmFrame *pcm = frame->frame.pcm;
+    if (!pcm)
+      return false;
+    view.channels = pcm->channels_;
+    view.sample_bits = pcm->sample_bits_;
+    view.sample_rate = pcm->sample_rates_;
+    view.samples = pcm->samples_;
+    view.frame_ms = pcm->frame_ms_;
+    view.buf = pcm->pcmBuf_;
+    view.buf_size = pcm->pcmBufSize_;
+    return true;
+  }
+  case agora::linuxsdk::AUDIO_FRAME_AAC: {
+    const agora::linuxsdk::AudioAacFrame *aac = frame->frame.aac;
+    if (!aac)
+      return false;
+    view.channels = aac->channels_;
+    view.bitrate = aac->bitrate_;
+    view.frame_ms = aac->frame_ms_;
+    view.buf = aac->aacBuf_;
+    view.buf_size = aac->aacBufSize_;
+    return true;
+  }
+  }
+  return false;
+}
+
+bool fillVideoFrameView(const agora::linuxsdk::VideoFrame *frame, VideoFrameView &view) {
+  memset(&view, 0, sizeof(view));
+  view.kind = frame->type;
+  view.rotation = frame->rotation_;
+  switch (frame->type) {
+  case agora::linuxsdk::VIDEO_FRAME_RAW_YUV: {
+    const agora::linuxsdk::VideoYuvFrame *yuv = frame->frame.yuv;
+    if (!yuv)
+      return false;
+    view.frame_ms = yuv->frame_ms_;
+    view.width = yuv->width_;
+    view.height = yuv->height_;
+    view.y_stride = yuv->ystride_;
+    view.u_stride = yuv->ustride_;
+    view.v_stride = yuv->vstride_;
+    view.buf = yuv->buf_;
+    view.buf_size = yuv->bufSize_;
+    view.y = yuv->ybuf_;
+    view.u = yuv->ubuf_;
+    view.v = yuv->vbuf_;
+    return true;
+  }
+  case agora::linuxsdk::VIDEO_FRAME_H264: {
+    const agora::linuxsdk::VideoH264Frame *h264 = frame->frame.h264;
+    if (!h264)
+      return false;
+    view.frame_ms = h264->frame_ms_;
+    view.frame_num = h264->frame_num_;
+    view.buf = h264->buf_;
+    view.buf_size = h264->bufSize_;
+    return true;
+  }
+  case agora::linuxsdk::VIDEO_FRAME_H265: {
+    const agora::linuxsdk::VideoH265Frame *h265 = frame->frame.h265;
+    if (!h265)
+      return false;
+    view.frame_ms = h265->frame_ms_;
+    view.frame_num = h265->frame_num_;
+    view.buf = h265->buf_;
+    view.buf_size = h265->bufSize_;
+    return true;
+  }
+  case agora::linuxsdk::VIDEO_FRAME_JPG: {
+    const agora::linuxsdk::VideoJpgFrame *jpg = frame->frame.jpg;
+    if (!jpg)
+      return false;
+    view.frame_ms = jpg->frame_ms_;
+    view.buf = jpg->buf_;
+    view.buf_size = jpg->bufSize_;
+    return true;
+  }
+  }
+  return false;
+}
+
+size_t videoFramePayloadSize(const VideoFrameView &view) {
+  if (view.kind != agora::linuxsdk::VIDEO_FRAME_RAW_YUV)
+    return view.buf_size;
+  size_t chromaHeight = (view.height + 1) / 2;
+  return static_cast<size_t>(view.y_stride) * view.height
+    + static_cast<size_t>(view.u_stride) * chromaHeight
+    + static_cast<size_t>(view.v_stride) * chromaHeight;
+}
+
+static bool hasKeyNal(const unsigned char *buf, size_t size, bool hevc) {
+  //walk Annex B start codes and inspect each NAL header
+  for (size_t i = 0; i + 3 < size; i++) {
+    if (buf[i] != 0 || buf[i + 1] != 0 || buf[i + 2] != 1)
+      continue;
+    unsigned char header = buf[i + 3];
+    if (hevc) {
+      int type = (header >> 1) & 0x3f;
+      //BLA/IDR/CRA
+      if (type >= 16 && type <= 21)
+        return true;
+    } else if ((header & 0x1f) == 5) {
+      return true;
+    }
+    i += 2;
+  }
+  return false;
+}
+
+bool isVideoKeyframe(const VideoFrameView &view) {
+  switch (view.kind) {
+  case agora::linuxsdk::VIDEO_FRAME_H264:
+    return hasKeyNal(view.buf, view.buf_size, false);
+  case agora::linuxsdk::VIDEO_FRAME_H265:
+    return hasKeyNal(view.buf, view.buf_size, true);
+  }
+  return true;
+}
+
+static void copyPlane(unsigned char *dst, const unsigned char *src, size_t bytes) {
+  if (src)
+    memcpy(dst, src, bytes);
+  else
+    memset(dst, 0, bytes);
+}
+
+FrameBuffer* copyVideoFrameView(FramePool *pool, const VideoFrameView &view, VideoFrameView &copy) {
+  size_t bytes = videoFramePayloadSize(view);
+  FrameBuffer *buffer = pool->acquire(bytes);
+  unsigned char *data = buffer->data();
+  copy = view;
+  if (view.kind == agora::linuxsdk::VIDEO_FRAME_RAW_YUV) {
+    size_t chromaHeight = (view.height + 1) / 2;
+    size_t ySize = static_cast<size_t>(view.y_stride) * view.height;
+    size_t uSize = static_cast<size_t>(view.u_stride) * chromaHeight;
+    copyPlane(data, view.y, ySize);
+    copyPlane(data + ySize, view.u, uSize);
+    copyPlane(data + ySize + uSize, view.v, bytes - ySize - uSize);
+    copy.y = data;
+    copy.u = data + ySize;
+    copy.v = data + ySize + uSize;
+  } else {
+    copyPlane(data, view.buf, bytes);
+  }
+  copy.buf = data;
+  copy.buf_size = static_cast<uint32_t>(bytes);
+  return buffer;
+}
+
+FrameBuffer* copyAudioFrameView(FramePool *pool, const AudioFrameView &view, AudioFrameView &copy) {
+  FrameBuffer *buffer = pool->copy(view.buf, view.buf ? view.buf_size : 0);
+  copy = view;
+  copy.buf = buffer->data();
+  return buffer;
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "IAgoraLinuxSdkCommon.h"
+
+namespace agora {
+
+class FrameBuffer;
+class FramePool;
+
+//Flattened view over an SDK video frame. The layout is mirrored by
+//RawVideoFrame on the Rust side, keep the two in sync.
+struct VideoFrameView {
+    uint32_t kind;
+    int32_t rotation;
+    uint64_t frame_ms;
+    uint32_t frame_num;
+    uint32_t width;
+    uint32_t height;
+    uint32_t y_stride;
+    uint32_t u_stride;
+    uint32_t v_stride;
+    uint32_t buf_size;
+    const unsigned char *buf;
+    const unsigned char *y;
+    const unsigned char *u;
+    const unsigned char *v;
+};
+
+//Mirrored by RawAudioFrame on the Rust side.
+struct AudioFrameView {
+    uint32_t kind;
+    uint32_t channels;
+    uint32_t sample_bits;
+    uint32_t sample_rate;
+    uint32_t samples;
+    uint32_t bitrate;
+    uint64_t frame_ms;
+    uint32_t buf_size;
+    const unsigned char *buf;
+};
+
+bool fillVideoFrameView(const agora::linuxsdk::VideoFrame *frame, VideoFrameView &view);
+bool fillAudioFrameView(const agora::linuxsdk::AudioFrame *frame, AudioFrameView &view);
+
+//Bytes needed to hold the frame payload; YUV planes are stored back to back.
+size_t videoFramePayloadSize(const VideoFrameView &view);
+
+//True for H.264 IDR and H.265 IRAP access units. Other formats are
+//intra-only and always count as keyframes.
+bool isVideoKeyframe(const VideoFrameView &view);
+
+//Copy the payload into a buffer from pool and point copy at it; the caller
+//owns the returned buffer. Missing YUV planes are zero filled.
+FrameBuffer* copyVideoFrameView(FramePool *pool, const VideoFrameView &view, VideoFrameView &copy);
+FrameBuffer* copyAudioFrameView(FramePool *pool, const AudioFrameView &view, AudioFrameView &copy);
+
+}
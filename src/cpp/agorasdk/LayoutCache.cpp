@@ -0,0 +1,109 @@
+#include "LayoutCache.h"
+
+namespace agora {
+
+size_t LayoutKeyHash::operator()(const LayoutKey &key) const {
+  uint64_t h = static_cast<uint64_t>(key.m_mode);
+  h = h * 31 + key.m_count;
+  h = h * 31 + static_cast<uint32_t>(key.m_maxSlot);
+  h = h * 31 + static_cast<uint32_t>(key.m_canvasWidth);
+  h = h * 31 + static_cast<uint32_t>(key.m_canvasHeight);
+  return static_cast<size_t>(h ^ (h >> 32));
+}
+
+void LayoutTemplate::apply(const std::vector<agora::linuxsdk::uid_t> &uids,
+    agora::linuxsdk::VideoMixingLayout::Region *regionList) const {
+  for (size_t i = 0; i < m_regions.size(); i++) {
+    regionList[i] = m_regions[i];
+    if (m_source[i] >= 0)
+      regionList[i].uid = uids[m_source[i]];
+  }
+}
+
+static bool sameRegion(const agora::linuxsdk::VideoMixingLayout::Region &a,
+    const agora::linuxsdk::VideoMixingLayout::Region &b) {
+  return a.uid == b.uid && a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height &&
+    a.alpha == b.alpha && a.renderMode == b.renderMode;
+}
+
+AppliedLayout::AppliedLayout() :
+  m_valid(false)
+  , m_canvasWidth(0)
+  , m_canvasHeight(0)
+  , m_keepLastFrame(false)
+{
+}
+
+size_t AppliedLayout::diff(const agora::linuxsdk::VideoMixingLayout &layout) const {
+  size_t count = layout.regions ? layout.regionCount : 0;
+  size_t all = count > 0 ? count : 1;
+  const char *background = layout.backgroundColor ? layout.backgroundColor : "";
+  //appData and watermarks are not kept, so layouts carrying them always go through
+  if (!m_valid || layout.wm_num > 0 || layout.appDataLength > 0)
+    return all;
+  if (layout.canvasWidth != m_canvasWidth || layout.canvasHeight != m_canvasHeight ||
+      layout.keepLastFrame != m_keepLastFrame || m_backgroundColor != background ||
+      count != m_regions.size())
+    return all;
+
+  size_t changed = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!sameRegion(layout.regions[i], m_regions[i]))
+      changed++;
+  }
+  return changed;
+}
+
+void AppliedLayout::assign(const agora::linuxsdk::VideoMixingLayout &layout) {
+  size_t count = layout.regions ? layout.regionCount : 0;
+  m_valid = true;
+  m_canvasWidth = layout.canvasWidth;
+  m_canvasHeight = layout.canvasHeight;
+  m_keepLastFrame = layout.keepLastFrame;
+  m_backgroundColor = layout.backgroundColor ? layout.backgroundColor : "";
+  m_regions.assign(layout.regions, layout.regions + count);
+}
+
+void AppliedLayout::clear() {
+  m_valid = false;
+  m_regions.clear();
+}
+
+LayoutCache::LayoutCache() :
+  m_hits(0)
+  , m_misses(0)
+{
+}
+
+const LayoutTemplate* LayoutCache::find(const LayoutKey &key) const {
+  std::unordered_map<LayoutKey, Order::iterator, LayoutKeyHash>::const_iterator it = m_templates.find(key);
+  if (it == m_templates.end()) {
+    m_misses++;
+    return NULL;
+  }
+  m_hits++;
+  m_order.splice(m_order.begin(), m_order, it->second);
+  return &it->second->second;
+}
+
+LayoutTemplate& LayoutCache::insert(const LayoutKey &key) {
+  std::unordered_map<LayoutKey, Order::iterator, LayoutKeyHash>::iterator it = m_templates.find(key);
+  if (it != m_templates.end()) {
+    m_order.splice(m_order.begin(), m_order, it->second);
+    return it->second->second;
+  }
+  m_order.push_front(std::make_pair(key, LayoutTemplate()));
+  m_templates[key] = m_order.begin();
+  if (m_order.size() > kMaxTemplates) {
+    m_templates.erase(m_order.back().first);
+    m_order.pop_back();
+  }
+  return m_order.front().second;
+}
+
+void LayoutCache::clear() {
+  m_templates.clear();
+  m_order.clear();
+}
+
+}
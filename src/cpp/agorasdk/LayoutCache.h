@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+
+#include "IAgoraLinuxSdkCommon.h"
+
+namespace agora {
+
+struct LayoutKey {
+    int m_mode;
+    uint32_t m_count;
+    int m_maxSlot;
+    int m_canvasWidth;
+    int m_canvasHeight;
+    LayoutKey():
+        m_mode(0),
+        m_count(0),
+        m_maxSlot(-1),
+        m_canvasWidth(0),
+        m_canvasHeight(0)
+    {};
+    bool operator==(const LayoutKey &other) const {
+        return m_mode == other.m_mode && m_count == other.m_count && m_maxSlot == other.m_maxSlot &&
+            m_canvasWidth == other.m_canvasWidth && m_canvasHeight == other.m_canvasHeight;
+    }
+};
+
+struct LayoutKeyHash {
+    size_t operator()(const LayoutKey &key) const;
+};
+
+//Normalized region geometry for one layout case. m_source[i] is the index of the
+//subscribed uid that fills region i, or -1 if the layout leaves the region empty.
+struct LayoutTemplate {
+    std::vector<agora::linuxsdk::VideoMixingLayout::Region> m_regions;
+    std::vector<int> m_source;
+
+    void apply(const std::vector<agora::linuxsdk::uid_t> &uids, agora::linuxsdk::VideoMixingLayout::Region *regionList) const;
+};
+
+//Copy of the last layout the engine accepted, so a recompute that lands on
+//the same layout can skip the engine call and the compositor reconfiguration
+//that comes with it.
+class AppliedLayout {
+    public:
+        AppliedLayout();
+
+        //Regions that differ from the applied layout, 0 when nothing does. A
+        //change to the canvas, background, region count or watermarks counts
+        //as every region changing.
+        size_t diff(const agora::linuxsdk::VideoMixingLayout &layout) const;
+        void assign(const agora::linuxsdk::VideoMixingLayout &layout);
+        void clear();
+        const std::vector<agora::linuxsdk::VideoMixingLayout::Region>& regions() const { return m_regions; }
+
+    private:
+        bool m_valid;
+        int m_canvasWidth;
+        int m_canvasHeight;
+        bool m_keepLastFrame;
+        std::string m_backgroundColor;
+        std::vector<agora::linuxsdk::VideoMixingLayout::Region> m_regions;
+};
+
+//The most recently used templates, at most kMaxTemplates of them. Presentation
+//keys include the large tile's slot, so a churning channel would otherwise
+//keep a template for every count and slot it has passed through.
+class LayoutCache {
+    public:
+        static const size_t kMaxTemplates = 64;
+
+        LayoutCache();
+
+        const LayoutTemplate* find(const LayoutKey &key) const;
+        //Evicts the least recently used template when full.
+        LayoutTemplate& insert(const LayoutKey &key);
+        void clear();
+
+        size_t size() const { return m_templates.size(); }
+        uint64_t hits() const { return m_hits; }
+        uint64_t misses() const { return m_misses; }
+
+    private:
+        typedef std::list<std::pair<LayoutKey, LayoutTemplate> > Order;
+
+        //most recently used first
+        mutable Order m_order;
+        std::unordered_map<LayoutKey, Order::iterator, LayoutKeyHash> m_templates;
+        mutable uint64_t m_hits;
+        mutable uint64_t m_misses;
+};
+
+}
@@ -0,0 +1,107 @@
+#include "LayoutScheduler.h"
+
+namespace agora {
+
+LayoutScheduler::LayoutScheduler() :
+  m_windowMs(0)
+  , m_timers(TimerQueue::shared())
+  , m_timerQueued(false)
+  , m_pending(false)
+  , m_stopped(false)
+  , m_pushed(0)
+  , m_coalesced(0)
+{
+}
+
+LayoutScheduler::~LayoutScheduler() {
+  stop();
+}
+
+void LayoutScheduler::setCallback(const PushCallback &callback) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_callback = callback;
+}
+
+void LayoutScheduler::setWindow(uint32_t window_ms) {
+  m_windowMs = window_ms;
+  if (window_ms == 0)
+    flush();
+}
+
+void LayoutScheduler::schedule() {
+  if (m_windowMs == 0) {
+    push();
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_stopped)
+    return;
+  if (m_pending) {
+    //the layout already waiting in this window supersedes the previous one
+    m_coalesced++;
+    return;
+  }
+  m_pending = true;
+  m_deadline = clock::now() + std::chrono::milliseconds(m_windowMs.load());
+  //one timer at a time; fire() re-arms it for windows opened meanwhile
+  if (!m_timerQueued) {
+    m_timerQueued = true;
+    m_timers->schedule(m_deadline, std::bind(&LayoutScheduler::fire, this), this);
+  }
+}
+
+void LayoutScheduler::flush() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_pending)
+      return;
+    m_pending = false;
+  }
+  push();
+}
+
+void LayoutScheduler::start() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stopped = false;
+}
+
+void LayoutScheduler::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+    m_pending = false;
+    m_timerQueued = false;
+  }
+  m_timers->cancel(this);
+}
+
+void LayoutScheduler::fire() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_pending && clock::now() >= m_deadline) {
+    m_pending = false;
+    lock.unlock();
+    push();
+    lock.lock();
+  }
+  m_timerQueued = m_pending;
+  if (m_pending)
+    m_timers->schedule(m_deadline, std::bind(&LayoutScheduler::fire, this), this);
+}
+
+void LayoutScheduler::push() {
+  PushCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    //a stopped recorder has nothing left to push to
+    if (m_stopped)
+      return;
+    callback = m_callback;
+  }
+  if (callback) {
+    callback();
+    m_pushed++;
+  }
+}
+
+}
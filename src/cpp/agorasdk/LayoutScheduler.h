@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+#include "TimerQueue.h"
+
+namespace agora {
+
+//Coalesces layout requests that arrive within m_windowMs into a single push.
+//With a zero window every request is pushed immediately on the caller's thread.
+//Windows are timed on TimerQueue::shared() unless another queue, such as a
+//RecorderManager's, is set. Once stopped, requests are dropped until start().
+//Nothing in it is layout specific, and AgoraSdk batches subscription updates
+//with a second one.
+class LayoutScheduler {
+    public:
+        typedef std::function<int()> PushCallback;
+
+        LayoutScheduler();
+        ~LayoutScheduler();
+
+        void setCallback(const PushCallback &callback);
+        void setWindow(uint32_t window_ms);
+        //Call before anything is scheduled; timers must outlive the scheduler.
+        void setTimerQueue(TimerQueue *timers) { m_timers = timers ? timers : TimerQueue::shared(); }
+        uint32_t window() const { return m_windowMs; }
+
+        void schedule();
+        void flush();
+        void start();
+        //Drops the pending push and waits out a running one.
+        void stop();
+
+        uint64_t pushed() const { return m_pushed.load(); }
+        uint64_t coalesced() const { return m_coalesced.load(); }
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        void fire();
+        void push();
+
+        PushCallback m_callback;
+        std::atomic<uint32_t> m_windowMs;
+        std::mutex m_mutex;
+        TimerQueue *m_timers;
+        bool m_timerQueued;
+        bool m_pending;
+        bool m_stopped;
+        clock::time_point m_deadline;
+        std::atomic<uint64_t> m_pushed;
+        std::atomic<uint64_t> m_coalesced;
+};
+
+}
@@ -0,0 +1,199 @@
+#include "LayoutSolver.h"
+
+namespace agora {
+
+//widest the column strip of a solved presentation layout gets
+static const double kMaxStripWidth = 0.25;
+
+//Equal tiles of m_width x m_height (canvas fractions), m_cols per row.
+struct TileGrid {
+    uint32_t m_cols;
+    double m_width;
+    double m_height;
+    //center each row, and the rows as a block, instead of starting top left
+    bool m_center;
+};
+
+//A presentation layout's column strip: m_rows tiles per column, filled one
+//column at a time, with the large tile taking the width to its left.
+struct TileStrip {
+    uint32_t m_rows;
+    double m_width;
+    double m_height;
+    double m_x;
+};
+
+static void setRegion(agora::linuxsdk::VideoMixingLayout::Region &region, double x, double y,
+    double width, double height, double alpha, int renderMode) {
+  region.uid = 0;
+  region.x = x;
+  region.y = y;
+  region.width = width;
+  region.height = height;
+  region.alpha = alpha;
+  region.renderMode = renderMode;
+}
+
+static void resetTemplate(uint32_t count, LayoutTemplate &out) {
+  out.m_regions.assign(count, agora::linuxsdk::VideoMixingLayout::Region());
+  out.m_source.resize(count);
+  for (uint32_t i = 0; i < count; i++)
+    out.m_source[i] = static_cast<int>(i);
+}
+
+//The shapes of the original hand written best fit layouts.
+static bool legacyBestFitGrid(uint32_t count, TileGrid &grid) {
+  grid.m_center = false;
+  if (count == 1) {
+    grid.m_cols = 1;
+    grid.m_width = grid.m_height = 1.0;
+  } else if (count == 2) {
+    //side by side at full height
+    grid.m_cols = 2;
+    grid.m_width = 0.5;
+    grid.m_height = 1.0;
+  } else if (count <= 4) {
+    grid.m_cols = 2;
+    grid.m_width = grid.m_height = 1.0 / 2;
+  } else if (count <= 9) {
+    grid.m_cols = 3;
+    grid.m_width = grid.m_height = 1.0 / 3;
+  } else if (count <= 16) {
+    grid.m_cols = 4;
+    grid.m_width = grid.m_height = 1.0 / 4;
+  } else if (count == 17) {
+    grid.m_cols = 4;
+    grid.m_width = grid.m_height = 1.0 / 5;
+    grid.m_center = true;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+//Tries every column count and keeps the one with the largest tiles; on a tie
+//the wider grid wins.
+static TileGrid solveGrid(uint32_t count) {
+  TileGrid best;
+  best.m_cols = 1;
+  best.m_width = 0;
+  best.m_height = 0;
+  best.m_center = true;
+  for (uint32_t cols = 1; cols <= count; cols++) {
+    uint32_t rows = (count + cols - 1) / cols;
+    double width = 1.0 / cols;
+    if (width * rows > 1.0)
+      width = 1.0 / rows;
+    if (width >= best.m_width) {
+      best.m_cols = cols;
+      best.m_width = width;
+      best.m_height = width;
+    }
+  }
+  return best;
+}
+
+void solveBestFitLayout(uint32_t count, LayoutTemplate &out) {
+  resetTemplate(count, out);
+  if (count == 0)
+    return;
+
+  TileGrid grid;
+  if (!legacyBestFitGrid(count, grid))
+    grid = solveGrid(count);
+
+  uint32_t rows = (count + grid.m_cols - 1) / grid.m_cols;
+  double top = grid.m_center ? (1.0 - rows * grid.m_height) / 2 : 0.0;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t row = i / grid.m_cols;
+    uint32_t col = i % grid.m_cols;
+    double left = 0.0;
+    if (grid.m_center) {
+      uint32_t inRow = count - row * grid.m_cols;
+      if (inRow > grid.m_cols)
+        inRow = grid.m_cols;
+      left = (1.0 - inRow * grid.m_width) / 2;
+    }
+    setRegion(out.m_regions[i], left + col * grid.m_width, top + row * grid.m_height,
+        grid.m_width, grid.m_height, static_cast<double>(i + 1), 0);
+  }
+}
+
+//The shapes of the original hand written presentation layouts, picked by how
+//many tiles go in the strip.
+static bool legacyPresentationStrip(uint32_t tiles, TileStrip &strip) {
+  if (tiles <= 4) {
+    strip.m_rows = 4;
+    strip.m_width = 1.0 - 0.8;
+    strip.m_height = 1.0 / 4;
+    strip.m_x = 0.8;
+  } else if (tiles <= 6) {
+    strip.m_rows = 6;
+    strip.m_width = 1.0 / 7;
+    strip.m_height = 1.0 / 6;
+    strip.m_x = 6.0 / 7;
+  } else if (tiles <= 8) {
+    strip.m_rows = 8;
+    strip.m_width = 1.0 / 9;
+    strip.m_height = 1.0 / 8;
+    strip.m_x = 8.0 / 9;
+  } else if (tiles <= 16) {
+    strip.m_rows = 8;
+    strip.m_width = 1.0 / 10;
+    strip.m_height = 1.0 / 8;
+    strip.m_x = 0.8;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+//Largest tiles whose columns fit in kMaxStripWidth.
+static TileStrip solveStrip(uint32_t tiles) {
+  TileStrip best;
+  best.m_rows = tiles;
+  best.m_width = 0;
+  best.m_height = 0;
+  for (uint32_t cols = 1; cols <= tiles; cols++) {
+    uint32_t rows = (tiles + cols - 1) / cols;
+    double width = kMaxStripWidth / cols;
+    if (width * rows > 1.0)
+      width = 1.0 / rows;
+    if (width > best.m_width) {
+      best.m_rows = rows;
+      best.m_width = width;
+      best.m_height = width;
+    }
+  }
+  uint32_t cols = (tiles + best.m_rows - 1) / best.m_rows;
+  best.m_x = 1.0 - cols * best.m_width;
+  return best;
+}
+
+void solvePresentationLayout(uint32_t count, int maxSlot, LayoutTemplate &out) {
+  resetTemplate(count, out);
+  if (count == 0)
+    return;
+  if (maxSlot >= static_cast<int>(count))
+    maxSlot = -1;
+
+  uint32_t tiles = maxSlot >= 0 ? count - 1 : count;
+  TileStrip strip;
+  if (!legacyPresentationStrip(tiles, strip))
+    strip = solveStrip(tiles);
+
+  uint32_t tile = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    if (static_cast<int>(i) == maxSlot) {
+      setRegion(out.m_regions[i], 0.0, 0.0, strip.m_x, 1.0, 1.0, 1);
+      continue;
+    }
+    uint32_t col = tile / strip.m_rows;
+    uint32_t row = tile % strip.m_rows;
+    setRegion(out.m_regions[i], strip.m_x + col * strip.m_width, row * strip.m_height,
+        strip.m_width, strip.m_height, 1.0, 0);
+    tile++;
+  }
+}
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include "LayoutCache.h"
+
+namespace agora {
+
+//Geometry of the automatic layouts for any number of tiles. Both solvers fill
+//a LayoutTemplate with one region per slot, in slot order, so m_source is the
+//identity. Tiles are uniform and take the canvas' shape, so the geometry in
+//canvas fractions does not depend on the canvas size.
+//
+//Up to 17 tiles the shapes are the ones the recorder has always produced;
+//past that the grid (or presentation strip) is the one that gives each tile
+//the most area.
+
+//Rows of equal tiles covering the canvas.
+void solveBestFitLayout(uint32_t count, LayoutTemplate &out);
+
+//maxSlot takes the large tile on the left and the rest go in columns down
+//the right edge. Without a maxSlot (-1) every slot goes in the columns.
+void solvePresentationLayout(uint32_t count, int maxSlot, LayoutTemplate &out);
+
+}
@@ -0,0 +1,148 @@
+#include "MediaAccounting.h"
+
+namespace agora {
+
+MediaAccounting::MediaAccounting() :
+  m_size(0)
+{
+  for (size_t i = 0; i < kMaxUids; i++) {
+    m_slots[i].m_key.store(0, std::memory_order_relaxed);
+    m_slots[i].m_channels.store(0, std::memory_order_relaxed);
+    resetStream(m_slots[i].m_audio);
+    resetStream(m_slots[i].m_video);
+  }
+}
+
+void MediaAccounting::resetStream(Stream &stream) {
+  stream.m_frames.store(0, std::memory_order_relaxed);
+  stream.m_bytes.store(0, std::memory_order_relaxed);
+  stream.m_lastFrameMs.store(0, std::memory_order_relaxed);
+  stream.m_gaps.store(0, std::memory_order_relaxed);
+  stream.m_gapMs.store(0, std::memory_order_relaxed);
+  stream.m_maxGapMs.store(0, std::memory_order_relaxed);
+  stream.m_interval8.store(0, std::memory_order_relaxed);
+  stream.m_jitter16.store(0, std::memory_order_relaxed);
+  stream.m_lastStep.store(0, std::memory_order_relaxed);
+}
+
+void MediaAccounting::addAudioFrame(uint32_t uid, uint64_t frameMs, size_t bytes, uint32_t channels) {
+  Slot *slot = slotFor(uid);
+  if (!slot)
+    return;
+  slot->m_channels.store(channels, std::memory_order_relaxed);
+  addFrame(slot->m_audio, frameMs, bytes);
+}
+
+void MediaAccounting::addVideoFrame(uint32_t uid, uint64_t frameMs, size_t bytes) {
+  Slot *slot = slotFor(uid);
+  if (!slot)
+    return;
+  addFrame(slot->m_video, frameMs, bytes);
+}
+
+void MediaAccounting::addFrame(Stream &stream, uint64_t frameMs, size_t bytes) {
+  uint64_t frames = stream.m_frames.fetch_add(1, std::memory_order_relaxed);
+  stream.m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  uint64_t lastMs = stream.m_lastFrameMs.exchange(frameMs, std::memory_order_relaxed);
+  //first frame, or timestamps went backwards after a rejoin
+  if (frames == 0 || frameMs <= lastMs)
+    return;
+
+  uint64_t step = frameMs - lastMs;
+  uint32_t step32 = step > 0xffffffu ? 0xffffffu : static_cast<uint32_t>(step);
+  uint32_t interval8 = stream.m_interval8.load(std::memory_order_relaxed);
+  if (interval8 > 0 && step * 8 > 2 * static_cast<uint64_t>(interval8)) {
+    stream.m_gaps.fetch_add(1, std::memory_order_relaxed);
+    stream.m_gapMs.fetch_add(step, std::memory_order_relaxed);
+    if (step > stream.m_maxGapMs.load(std::memory_order_relaxed))
+      stream.m_maxGapMs.store(step, std::memory_order_relaxed);
+  } else {
+    //gaps would otherwise drag the interval estimate up
+    int32_t delta = static_cast<int32_t>(step32 * 8) - static_cast<int32_t>(interval8);
+    stream.m_interval8.store(interval8 == 0 ? step32 * 8 : interval8 + delta / 8, std::memory_order_relaxed);
+  }
+
+  if (frames > 1) {
+    uint32_t lastStep = stream.m_lastStep.load(std::memory_order_relaxed);
+    int32_t variation = static_cast<int32_t>(step32) - static_cast<int32_t>(lastStep);
+    if (variation < 0)
+      variation = -variation;
+    uint32_t jitter16 = stream.m_jitter16.load(std::memory_order_relaxed);
+    int32_t update = variation - static_cast<int32_t>((jitter16 + 8) >> 4);
+    stream.m_jitter16.store(static_cast<uint32_t>(static_cast<int32_t>(jitter16) + update), std::memory_order_relaxed);
+  }
+  stream.m_lastStep.store(step32, std::memory_order_relaxed);
+}
+
+//Open addressing keyed by uid + 1 so that 0 marks a free slot.
+MediaAccounting::Slot* MediaAccounting::slotFor(uint32_t uid) {
+  uint64_t key = static_cast<uint64_t>(uid) + 1;
+  size_t index = (uid * 2654435761u) & (kMaxUids - 1);
+  for (size_t probe = 0; probe < kMaxUids; probe++) {
+    Slot &slot = m_slots[(index + probe) & (kMaxUids - 1)];
+    uint64_t current = slot.m_key.load(std::memory_order_acquire);
+    if (current == key)
+      return &slot;
+    if (current == 0) {
+      if (slot.m_key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+        m_size++;
+        return &slot;
+      }
+      if (current == key)
+        return &slot;
+    }
+  }
+  return NULL;
+}
+
+const MediaAccounting::Slot* MediaAccounting::findSlot(uint32_t uid) const {
+  uint64_t key = static_cast<uint64_t>(uid) + 1;
+  size_t index = (uid * 2654435761u) & (kMaxUids - 1);
+  for (size_t probe = 0; probe < kMaxUids; probe++) {
+    const Slot &slot = m_slots[(index + probe) & (kMaxUids - 1)];
+    uint64_t current = slot.m_key.load(std::memory_order_acquire);
+    if (current == key)
+      return &slot;
+    if (current == 0)
+      return NULL;
+  }
+  return NULL;
+}
+
+void MediaAccounting::readStream(const Stream &stream, MediaStreamStats &stats) {
+  stats.m_frames = stream.m_frames.load(std::memory_order_relaxed);
+  stats.m_bytes = stream.m_bytes.load(std::memory_order_relaxed);
+  stats.m_lastFrameMs = stream.m_lastFrameMs.load(std::memory_order_relaxed);
+  stats.m_gaps = stream.m_gaps.load(std::memory_order_relaxed);
+  stats.m_gapMs = stream.m_gapMs.load(std::memory_order_relaxed);
+  stats.m_maxGapMs = stream.m_maxGapMs.load(std::memory_order_relaxed);
+  stats.m_intervalMs = stream.m_interval8.load(std::memory_order_relaxed) / 8.0;
+  stats.m_jitterMs = stream.m_jitter16.load(std::memory_order_relaxed) / 16.0;
+}
+
+void MediaAccounting::readSlot(const Slot &slot, MediaAccountingEntry &entry) {
+  entry.m_uid = static_cast<uint32_t>(slot.m_key.load(std::memory_order_acquire) - 1);
+  entry.m_channels = slot.m_channels.load(std::memory_order_relaxed);
+  readStream(slot.m_audio, entry.m_audio);
+  readStream(slot.m_video, entry.m_video);
+}
+
+bool MediaAccounting::get(uint32_t uid, MediaAccountingEntry &entry) const {
+  const Slot *slot = findSlot(uid);
+  if (!slot)
+    return false;
+  readSlot(*slot, entry);
+  return true;
+}
+
+size_t MediaAccounting::snapshot(MediaAccountingEntry *entries, size_t max) const {
+  size_t count = 0;
+  for (size_t i = 0; i < kMaxUids && count < max; i++) {
+    if (m_slots[i].m_key.load(std::memory_order_acquire) == 0)
+      continue;
+    readSlot(m_slots[i], entries[count++]);
+  }
+  return count;
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+namespace agora {
+
+struct MediaStreamStats {
+    uint64_t m_frames;
+    uint64_t m_bytes;
+    uint64_t m_lastFrameMs;
+    uint64_t m_gaps;
+    uint64_t m_gapMs;
+    uint64_t m_maxGapMs;
+    double m_intervalMs;
+    double m_jitterMs;
+};
+
+//Snapshot of one uid. The layout is mirrored by MediaStats on the Rust side.
+struct MediaAccountingEntry {
+    uint32_t m_uid;
+    uint32_t m_channels;
+    MediaStreamStats m_audio;
+    MediaStreamStats m_video;
+};
+
+//Per-uid frame accounting fed from the frame callbacks. Slots live in a
+//fixed open-addressed table and are updated with atomics only, so the
+//callbacks never lock or allocate. Each uid's audio and video are expected
+//to be delivered by one thread at a time, as the SDK does; readers may see
+//a snapshot that is mid-update but never a torn counter.
+//
+//A gap is an inter-frame step of more than twice the smoothed frame
+//interval. Jitter is the RFC 3550 estimator applied to frame_ms steps.
+class MediaAccounting {
+    public:
+        enum {
+            kMaxUids = 1024,
+        };
+
+        MediaAccounting();
+
+        void addAudioFrame(uint32_t uid, uint64_t frameMs, size_t bytes, uint32_t channels);
+        void addVideoFrame(uint32_t uid, uint64_t frameMs, size_t bytes);
+
+        bool get(uint32_t uid, MediaAccountingEntry &entry) const;
+        //Copies up to max entries, returns how many were written.
+        size_t snapshot(MediaAccountingEntry *entries, size_t max) const;
+        size_t size() const { return m_size.load(); }
+
+    private:
+        struct Stream {
+            std::atomic<uint64_t> m_frames;
+            std::atomic<uint64_t> m_bytes;
+            std::atomic<uint64_t> m_lastFrameMs;
+            std::atomic<uint64_t> m_gaps;
+            std::atomic<uint64_t> m_gapMs;
+            std::atomic<uint64_t> m_maxGapMs;
+            //fixed point: interval * 8, jitter * 16
+            std::atomic<uint32_t> m_interval8;
+            std::atomic<uint32_t> m_jitter16;
+            std::atomic<uint32_t> m_lastStep;
+        };
+
+        struct Slot {
+            std::atomic<uint64_t> m_key;
+            std::atomic<uint32_t> m_channels;
+            Stream m_audio;
+            Stream m_video;
+        };
+
+        Slot* slotFor(uint32_t uid);
+        const Slot* findSlot(uint32_t uid) const;
+        static void resetStream(Stream &stream);
+        static void addFrame(Stream &stream, uint64_t frameMs, size_t bytes);
+        static void readStream(const Stream &stream, MediaStreamStats &stats);
+        static void readSlot(const Slot &slot, MediaAccountingEntry &entry);
+
+        Slot m_slots[kMaxUids];
+        std::atomic<size_t> m_size;
+};
+
+}
@@ -0,0 +1,247 @@
+#include <cstring>
+#include <algorithm>
+
+#include "MediaRetention.h"
+
+namespace agora {
+
+RetentionRing::RetentionRing(size_t bytes, size_t frames) :
+  m_arena(new unsigned char[bytes])
+  , m_arenaSize(bytes)
+  , m_entries(frames > 0 ? frames : 1)
+  , m_times(m_entries.size())
+  , m_head(0)
+  , m_count(0)
+  , m_writePos(0)
+{
+}
+
+void RetentionRing::evictOldest() {
+  m_head = slot(1);
+  m_count--;
+}
+
+bool RetentionRing::append(const RetainedFrame &frame, const unsigned char *payload, uint64_t frameMs, uint32_t keepMs) {
+  size_t size = frame.m_size;
+  if (size == 0 || size > m_arenaSize)
+    return false;
+
+  uint64_t newest = m_count > 0 ? m_times[slot(m_count - 1)] : 0;
+  //a jump back of more than the window means the stream restarted
+  if (m_count > 0 && frameMs + keepMs < newest)
+    m_count = 0;
+  if (m_count == 0) {
+    m_head = 0;
+    m_writePos = 0;
+    newest = 0;
+  }
+  if (m_count == m_entries.size())
+    evictOldest();
+
+  size_t pos = m_writePos;
+  if (pos + size > m_arenaSize) {
+    //whatever still sits in the skipped tail is older than the wrapped data
+    while (m_count > 0 && m_entries[m_head].m_offset >= pos)
+      evictOldest();
+    pos = 0;
+  }
+  while (m_count > 0 && m_entries[m_head].m_offset >= pos && m_entries[m_head].m_offset < pos + size)
+    evictOldest();
+
+  memcpy(&m_arena[pos], payload, size);
+  size_t index = slot(m_count);
+  m_entries[index] = frame;
+  m_entries[index].m_offset = pos;
+  //keep the index sorted when frames arrive slightly out of order
+  m_times[index] = std::max(frameMs, newest);
+  m_count++;
+  m_writePos = pos + size;
+
+  uint64_t latest = m_times[index];
+  while (m_count > 1 && latest - m_times[m_head] > keepMs)
+    evictOldest();
+  return true;
+}
+
+size_t RetentionRing::seek(uint64_t ms) const {
+  size_t low = 0;
+  size_t high = m_count;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (m_times[slot(mid)] < ms)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+void RetentionRing::collect(uint64_t sinceMs, std::vector<RetainedFrame> &frames) const {
+  size_t start = seek(sinceMs);
+  if (start >= m_count)
+    return;
+  if (m_entries[slot(start)].m_type == QUEUED_VIDEO_FRAME) {
+    size_t keyframe = start;
+    while (keyframe > 0 && !m_entries[slot(keyframe)].m_keyframe)
+      keyframe--;
+    if (!m_entries[slot(keyframe)].m_keyframe) {
+      //the keyframe was evicted, start at the next one instead
+      while (start < m_count && !m_entries[slot(start)].m_keyframe)
+        start++;
+      keyframe = start;
+    }
+    start = keyframe;
+  }
+  for (size_t i = start; i < m_count; i++)
+    frames.push_back(m_entries[slot(i)]);
+}
+
+MediaRetention::MediaRetention() :
+  m_keepMs(0)
+  , m_videoBytes(8 << 20)
+  , m_audioBytes(1 << 20)
+  , m_frames(2048)
+{
+}
+
+void MediaRetention::setKeepTime(uint32_t keepMs) {
+  m_keepMs.store(keepMs);
+  if (keepMs == 0)
+    clear();
+}
+
+void MediaRetention::setBudget(size_t videoBytes, size_t audioBytes, size_t frames) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_videoBytes = videoBytes;
+  m_audioBytes = audioBytes;
+  m_frames = frames;
+}
+
+MediaRetention::RingPtr MediaRetention::ringFor(uint32_t uid, uint32_t type) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  RingPtr &ring = m_rings[key(uid, type)];
+  if (!ring)
+    ring.reset(new RetentionRing(type == QUEUED_VIDEO_FRAME ? m_videoBytes : m_audioBytes, m_frames));
+  return ring;
+}
+
+MediaRetention::RingPtr MediaRetention::findRing(uint32_t uid, uint32_t type) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::unordered_map<uint64_t, RingPtr>::const_iterator it = m_rings.find(key(uid, type));
+  return it != m_rings.end() ? it->second : RingPtr();
+}
+
+bool MediaRetention::retainVideo(uint32_t uid, const VideoFrameView &view) {
+  uint32_t keepMs = m_keepMs.load(std::memory_order_relaxed);
+  if (keepMs == 0 || !view.buf)
+    return false;
+  if (view.kind != agora::linuxsdk::VIDEO_FRAME_H264 && view.kind != agora::linuxsdk::VIDEO_FRAME_H265)
+    return false;
+
+  RetainedFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.m_uid = uid;
+  frame.m_type = QUEUED_VIDEO_FRAME;
+  frame.m_keyframe = isVideoKeyframe(view);
+  frame.m_video = view;
+  frame.m_size = view.buf_size;
+
+  RingPtr ring = ringFor(uid, QUEUED_VIDEO_FRAME);
+  std::lock_guard<std::mutex> lock(ring->m_mutex);
+  return ring->append(frame, view.buf, view.frame_ms, keepMs);
+}
+
+bool MediaRetention::retainAudio(uint32_t uid, const AudioFrameView &view) {
+  uint32_t keepMs = m_keepMs.load(std::memory_order_relaxed);
+  if (keepMs == 0 || !view.buf || view.kind != agora::linuxsdk::AUDIO_FRAME_AAC)
+    return false;
+
+  RetainedFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.m_uid = uid;
+  frame.m_type = QUEUED_AUDIO_FRAME;
+  frame.m_keyframe = true;
+  frame.m_audio = view;
+  frame.m_size = view.buf_size;
+
+  RingPtr ring = ringFor(uid, QUEUED_AUDIO_FRAME);
+  std::lock_guard<std::mutex> lock(ring->m_mutex);
+  return ring->append(frame, view.buf, view.frame_ms, keepMs);
+}
+
+static uint64_t retainedFrameMs(const RetainedFrame &frame) {
+  return frame.m_type == QUEUED_VIDEO_FRAME ? frame.m_video.frame_ms : frame.m_audio.frame_ms;
+}
+
+static bool earlierFrame(const RetainedFrame &a, const RetainedFrame &b) {
+  return retainedFrameMs(a) < retainedFrameMs(b);
+}
+
+FrameBuffer* MediaRetention::dump(uint32_t uid, uint64_t sinceMs, std::vector<RetainedFrame> &frames,
+    FramePool *pool) const {
+  frames.clear();
+  RingPtr video = findRing(uid, QUEUED_VIDEO_FRAME);
+  RingPtr audio = findRing(uid, QUEUED_AUDIO_FRAME);
+  if (!video && !audio)
+    return NULL;
+
+  //hold both rings so nothing is overwritten between collect and copy;
+  //append only ever takes one, always video before audio here
+  std::unique_lock<std::mutex> videoLock, audioLock;
+  if (video) {
+    videoLock = std::unique_lock<std::mutex>(video->m_mutex);
+    video->collect(sinceMs, frames);
+  }
+  size_t videoFrames = frames.size();
+  if (audio) {
+    audioLock = std::unique_lock<std::mutex>(audio->m_mutex);
+    audio->collect(sinceMs, frames);
+  }
+  if (frames.empty())
+    return NULL;
+
+  size_t bytes = 0;
+  for (size_t i = 0; i < frames.size(); i++)
+    bytes += frames[i].m_size;
+  FrameBuffer *buffer = pool->acquire(bytes);
+  unsigned char *data = buffer->data();
+  size_t offset = 0;
+  for (size_t i = 0; i < frames.size(); i++) {
+    RetainedFrame &frame = frames[i];
+    const RetentionRing *ring = i < videoFrames ? video.get() : audio.get();
+    memcpy(data + offset, ring->payload(frame), frame.m_size);
+    frame.m_offset = offset;
+    if (frame.m_type == QUEUED_VIDEO_FRAME)
+      frame.m_video.buf = data + offset;
+    else
+      frame.m_audio.buf = data + offset;
+    offset += frame.m_size;
+  }
+  std::stable_sort(frames.begin(), frames.end(), earlierFrame);
+  return buffer;
+}
+
+std::vector<uint32_t> MediaRetention::uids() const {
+  std::vector<uint32_t> uids;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (std::unordered_map<uint64_t, RingPtr>::const_iterator it = m_rings.begin(); it != m_rings.end(); ++it)
+    uids.push_back(static_cast<uint32_t>(it->first >> 1));
+  std::sort(uids.begin(), uids.end());
+  uids.erase(std::unique(uids.begin(), uids.end()), uids.end());
+  return uids;
+}
+
+uint64_t MediaRetention::reservedBytes() const {
+  uint64_t bytes = 0;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (std::unordered_map<uint64_t, RingPtr>::const_iterator it = m_rings.begin(); it != m_rings.end(); ++it)
+    bytes += it->second->capacity();
+  return bytes;
+}
+
+void MediaRetention::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_rings.clear();
+}
+
+}
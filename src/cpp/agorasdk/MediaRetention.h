@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "FramePool.h"
+#include "FrameQueue.h"
+#include "FrameView.h"
+
+namespace agora {
+
+//One frame of a dumped clip. The view pointers refer to the dump buffer,
+//m_offset/m_size locate the payload inside it.
+struct RetainedFrame {
+    uint32_t m_uid;
+    uint32_t m_type;
+    bool m_keyframe;
+    VideoFrameView m_video;
+    AudioFrameView m_audio;
+    size_t m_offset;
+    size_t m_size;
+};
+
+//Rolling window of one uid's audio or video. Payloads are packed into a
+//byte arena allocated up front; the index is a circular array in arrival
+//order whose timestamps never decrease, so seek is a binary search.
+//Callers hold m_mutex.
+class RetentionRing {
+    public:
+        RetentionRing(size_t bytes, size_t frames);
+
+        bool append(const RetainedFrame &frame, const unsigned char *payload, uint64_t frameMs, uint32_t keepMs);
+        //Index of the first frame with frame_ms >= ms.
+        size_t seek(uint64_t ms) const;
+        size_t size() const { return m_count; }
+        size_t capacity() const { return m_arenaSize; }
+        //Appends frames from sinceMs on; video is backed up to the keyframe
+        //the first frame depends on. Offsets still point into the arena.
+        void collect(uint64_t sinceMs, std::vector<RetainedFrame> &frames) const;
+        const unsigned char* payload(const RetainedFrame &frame) const { return &m_arena[frame.m_offset]; }
+
+        std::mutex m_mutex;
+
+    private:
+        size_t slot(size_t index) const { return (m_head + index) % m_entries.size(); }
+        void evictOldest();
+
+        //left uninitialized so untouched pages of a large budget cost nothing
+        std::unique_ptr<unsigned char[]> m_arena;
+        size_t m_arenaSize;
+        std::vector<RetainedFrame> m_entries;
+        std::vector<uint64_t> m_times;
+        size_t m_head;
+        size_t m_count;
+        size_t m_writePos;
+};
+
+//Keeps the last keep-time milliseconds of H.264/H.265 video and AAC audio
+//per uid, as configured by KEEPMEDIATIME or setMediaKeepTime. Raw YUV and
+//PCM frames are not retained. A uid's rings are allocated on its first
+//frame with a fixed budget, so the window is shorter than the keep time
+//when a stream outgrows it.
+class MediaRetention {
+    public:
+        MediaRetention();
+
+        //0 disables retention and frees every ring.
+        void setKeepTime(uint32_t keepMs);
+        uint32_t keepTime() const { return m_keepMs.load(); }
+        //Applies to rings created afterwards.
+        void setBudget(size_t videoBytes, size_t audioBytes, size_t frames);
+
+        bool retainVideo(uint32_t uid, const VideoFrameView &view);
+        bool retainAudio(uint32_t uid, const AudioFrameView &view);
+
+        //Copies the uid's frames from sinceMs on into one pooled buffer and
+        //fills frames, ordered by frame_ms, with views into it. Returns NULL
+        //if nothing is retained.
+        FrameBuffer* dump(uint32_t uid, uint64_t sinceMs, std::vector<RetainedFrame> &frames,
+                FramePool *pool = FramePool::shared()) const;
+        std::vector<uint32_t> uids() const;
+        //Arena bytes held by every ring, used or not.
+        uint64_t reservedBytes() const;
+        void clear();
+
+    private:
+        typedef std::shared_ptr<RetentionRing> RingPtr;
+
+        static uint64_t key(uint32_t uid, uint32_t type) { return (static_cast<uint64_t>(uid) << 1) | type; }
+        RingPtr ringFor(uint32_t uid, uint32_t type);
+        RingPtr findRing(uint32_t uid, uint32_t type) const;
+
+        std::atomic<uint32_t> m_keepMs;
+        size_t m_videoBytes;
+        size_t m_audioBytes;
+        size_t m_frames;
+        mutable std::mutex m_mutex;
+        std::unordered_map<uint64_t, RingPtr> m_rings;
+};
+
+}
@@ -0,0 +1,70 @@
+#include <cstdio>
+
+#include "MembershipBench.h"
+
+namespace agora {
+
+static const size_t kProbes = 256;
+static const uint32_t kFirstUid = 1000;
+
+static std::string accountOf(uint32_t uid) {
+  char account[32];
+  snprintf(account, sizeof(account), "user-%u", uid);
+  return account;
+}
+
+MembershipBench::MembershipBench(int type, size_t entries) :
+  m_type(type)
+  , m_found(kProbes)
+{
+  //every other uid is in the set
+  std::vector<agora::linuxsdk::uid_t> uids;
+  for (size_t i = 0; i < entries; i++)
+    uids.push_back(kFirstUid + 2 * static_cast<uint32_t>(i));
+
+  uint32_t random = 2463534242u;
+  for (size_t i = 0; i < kProbes; i++) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    uint32_t uid = kFirstUid + random % static_cast<uint32_t>(2 * entries + 1);
+    m_queries.push_back(uid);
+    m_accountQueries.push_back(accountOf(uid));
+  }
+
+  for (size_t i = 0; i < uids.size(); i++) {
+    if (type == MEMBERSHIP_HASHED_UIDS) {
+      m_hashedUids.insert(uids[i]);
+    } else if (type == MEMBERSHIP_FLAT_ACCOUNTS) {
+      std::string account = accountOf(uids[i]);
+      m_flatAccounts.insert(account.data(), account.size());
+    } else if (type == MEMBERSHIP_TREE_ACCOUNTS) {
+      m_treeAccounts.insert(accountOf(uids[i]));
+    }
+  }
+  if (type == MEMBERSHIP_FLAT_UIDS)
+    m_flatUids.swap(uids);
+}
+
+size_t MembershipBench::probe() {
+  size_t hits = 0;
+  switch (m_type) {
+    case MEMBERSHIP_FLAT_UIDS:
+      return m_flatUids.containsBatch(m_queries.data(), m_queries.size(), m_found.data());
+    case MEMBERSHIP_HASHED_UIDS:
+      for (size_t i = 0; i < m_queries.size(); i++)
+        hits += m_hashedUids.count(m_queries[i]);
+      break;
+    case MEMBERSHIP_FLAT_ACCOUNTS:
+      for (size_t i = 0; i < m_accountQueries.size(); i++)
+        hits += m_flatAccounts.contains(m_accountQueries[i].data(), m_accountQueries[i].size()) ? 1 : 0;
+      break;
+    case MEMBERSHIP_TREE_ACCOUNTS:
+      for (size_t i = 0; i < m_accountQueries.size(); i++)
+        hits += m_treeAccounts.count(m_accountQueries[i]);
+      break;
+  }
+  return hits;
+}
+
+}
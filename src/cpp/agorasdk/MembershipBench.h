@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "FlatSet.h"
+
+namespace agora {
+
+enum MEMBERSHIP_SET_TYPE {
+    MEMBERSHIP_FLAT_UIDS = 0,
+    //the node based containers the subscriptions used to be kept in
+    MEMBERSHIP_HASHED_UIDS = 1,
+    MEMBERSHIP_FLAT_ACCOUNTS = 2,
+    MEMBERSHIP_TREE_ACCOUNTS = 3,
+};
+
+//A subscription set of one type with entries uids (or "user-<uid>"
+//accounts), and a fixed batch of probes of which about half hit, for
+//comparing membership checks across set types and sizes.
+class MembershipBench {
+    public:
+        MembershipBench(int type, size_t entries);
+
+        //Runs the batch; returns the number of hits.
+        size_t probe();
+
+    private:
+        int m_type;
+        FlatUidSet m_flatUids;
+        std::unordered_set<uint32_t> m_hashedUids;
+        FlatAccountSet m_flatAccounts;
+        std::set<std::string> m_treeAccounts;
+        std::vector<agora::linuxsdk::uid_t> m_queries;
+        std::vector<std::string> m_accountQueries;
+        std::vector<uint8_t> m_found;
+};
+
+}
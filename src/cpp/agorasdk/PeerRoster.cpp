@@ -0,0 +1,97 @@
+#include "PeerRoster.h"
+
+namespace agora {
+
+PeerRoster::PeerRoster() :
+  m_first(NULL)
+  , m_last(NULL)
+  , m_visibleStale(false)
+{
+}
+
+bool PeerRoster::add(agora::linuxsdk::uid_t uid, bool visible) {
+  std::pair<std::unordered_map<agora::linuxsdk::uid_t, Entry>::iterator, bool> inserted =
+      m_entries.insert(std::make_pair(uid, Entry()));
+  if (!inserted.second)
+    return false;
+
+  Entry &entry = inserted.first->second;
+  entry.m_uid = uid;
+  entry.m_visible = visible;
+  entry.m_prev = m_last;
+  entry.m_next = NULL;
+  if (m_last)
+    m_last->m_next = &entry;
+  else
+    m_first = &entry;
+  m_last = &entry;
+  //newest join always sorts last
+  if (visible && !m_visibleStale)
+    m_visibleUids.push_back(uid);
+  return true;
+}
+
+void PeerRoster::unlink(Entry *entry) {
+  if (entry->m_prev)
+    entry->m_prev->m_next = entry->m_next;
+  else
+    m_first = entry->m_next;
+  if (entry->m_next)
+    entry->m_next->m_prev = entry->m_prev;
+  else
+    m_last = entry->m_prev;
+}
+
+bool PeerRoster::remove(agora::linuxsdk::uid_t uid) {
+  std::unordered_map<agora::linuxsdk::uid_t, Entry>::iterator it = m_entries.find(uid);
+  if (it == m_entries.end())
+    return false;
+
+  unlink(&it->second);
+  if (it->second.m_visible)
+    m_visibleStale = true;
+  m_entries.erase(it);
+  return true;
+}
+
+bool PeerRoster::setVisible(agora::linuxsdk::uid_t uid, bool visible) {
+  std::unordered_map<agora::linuxsdk::uid_t, Entry>::iterator it = m_entries.find(uid);
+  if (it == m_entries.end() || it->second.m_visible == visible)
+    return false;
+
+  it->second.m_visible = visible;
+  m_visibleStale = true;
+  return true;
+}
+
+const std::vector<agora::linuxsdk::uid_t>& PeerRoster::visible() const {
+  if (m_visibleStale) {
+    m_visibleUids.clear();
+    for (const Entry *entry = m_first; entry; entry = entry->m_next) {
+      if (entry->m_visible)
+        m_visibleUids.push_back(entry->m_uid);
+    }
+    m_visibleStale = false;
+  }
+  return m_visibleUids;
+}
+
+void PeerRoster::members(std::vector<agora::linuxsdk::uid_t> &uids) const {
+  uids.clear();
+  for (const Entry *entry = m_first; entry; entry = entry->m_next)
+    uids.push_back(entry->m_uid);
+}
+
+bool PeerRoster::contains(agora::linuxsdk::uid_t uid) const {
+  return m_entries.find(uid) != m_entries.end();
+}
+
+void PeerRoster::clear() {
+  m_entries.clear();
+  m_first = NULL;
+  m_last = NULL;
+  m_visibleUids.clear();
+  m_visibleStale = false;
+}
+
+}
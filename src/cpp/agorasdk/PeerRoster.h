@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+#include "IAgoraLinuxSdkCommon.h"
+
+namespace agora {
+
+//Channel members in join order. Lookups go through a hash map whose entries are
+//also threaded onto a join-order list, so joins, leaves and visibility changes
+//are O(1). The list of visible (subscribed) peers is extended in place by joins
+//and rebuilt from the join-order list on the next read after anything else
+//changed it.
+class PeerRoster {
+    public:
+        PeerRoster();
+
+        bool add(agora::linuxsdk::uid_t uid, bool visible);
+        bool remove(agora::linuxsdk::uid_t uid);
+        bool setVisible(agora::linuxsdk::uid_t uid, bool visible);
+        bool contains(agora::linuxsdk::uid_t uid) const;
+        void clear();
+
+        //Every member, visible or not, in join order.
+        void members(std::vector<agora::linuxsdk::uid_t> &uids) const;
+
+        size_t size() const { return m_entries.size(); }
+        const std::vector<agora::linuxsdk::uid_t>& visible() const;
+
+    private:
+        //unordered_map never moves its elements, so the links stay valid
+        struct Entry {
+            agora::linuxsdk::uid_t m_uid;
+            bool m_visible;
+            Entry *m_prev;
+            Entry *m_next;
+        };
+
+        void unlink(Entry *entry);
+
+        std::unordered_map<agora::linuxsdk::uid_t, Entry> m_entries;
+        Entry *m_first;
+        Entry *m_last;
+        mutable std::vector<agora::linuxsdk::uid_t> m_visibleUids;
+        mutable bool m_visibleStale;
+};
+
+}
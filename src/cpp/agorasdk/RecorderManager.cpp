@@ -0,0 +1,176 @@
+#include "RecorderManager.h"
+
+namespace agora {
+
+RecorderManager::RecorderManager(size_t workers, FramePool *pool) :
+  m_refs(1)
+  , m_pool(pool ? pool : FramePool::shared())
+  , m_timers(workers)
+  , m_events(workers)
+  , m_nextId(1)
+{
+}
+
+RecorderManager::~RecorderManager() {
+}
+
+void RecorderManager::retain() {
+  m_refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RecorderManager::release() {
+  if (m_refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+  //the last reference can go from a listener or a timer task, and the
+  //manager cannot join the thread it is running on
+  if (m_timers.ownsThread() || m_events.ownsThread())
+    std::thread([this] { delete this; }).detach();
+  else
+    delete this;
+}
+
+AgoraSdk* RecorderManager::createSession() {
+  //the session's reference on the manager goes with the session itself, so
+  //its timers outlive whichever thread ends up deleting it
+  retain();
+  SessionPtr sdk(new AgoraSdk(), [this](AgoraSdk *session) {
+    delete session;
+    release();
+  });
+  sdk->setFramePool(m_pool);
+  sdk->setTimerQueue(&m_timers);
+  sdk->setEventExecutor(&m_events);
+
+  Session session;
+  session.m_sdk = sdk;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    session.m_id = m_nextId++;
+    m_sessions.push_back(session);
+  }
+  return sdk.get();
+}
+
+void RecorderManager::destroySession(AgoraSdk *session) {
+  SessionPtr sdk;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_sessions.size(); i++) {
+      if (m_sessions[i].m_sdk.get() == session) {
+        sdk = m_sessions[i].m_sdk;
+        m_sessions.erase(m_sessions.begin() + i);
+        break;
+      }
+    }
+  }
+  if (!sdk)
+    return;
+
+  if (sdk->joined())
+    sdk->leaveChannel();
+}
+
+uint32_t RecorderManager::sessionId(const AgoraSdk *session) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (size_t i = 0; i < m_sessions.size(); i++) {
+    if (m_sessions[i].m_sdk.get() == session)
+      return m_sessions[i].m_id;
+  }
+  return 0;
+}
+
+RecorderManager::SessionPtr RecorderManager::find(uint32_t id) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (size_t i = 0; i < m_sessions.size(); i++) {
+    if (m_sessions[i].m_id == id)
+      return m_sessions[i].m_sdk;
+  }
+  return SessionPtr();
+}
+
+bool RecorderManager::startSession(uint32_t id, const string &appid, const string &channelKey, const string &name,
+    agora::linuxsdk::uid_t uid, agora::recording::RecordingConfig &config) {
+  SessionPtr sdk = find(id);
+  return sdk && sdk->createChannel(appid, channelKey, name, uid, config);
+}
+
+bool RecorderManager::stopSession(uint32_t id) {
+  SessionPtr sdk = find(id);
+  if (!sdk || !sdk->joined())
+    return false;
+  return sdk->leaveChannel();
+}
+
+void RecorderManager::stopAll() {
+  std::vector<SessionPtr> sessions;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_sessions.size(); i++)
+      sessions.push_back(m_sessions[i].m_sdk);
+  }
+  for (size_t i = 0; i < sessions.size(); i++) {
+    if (sessions[i]->joined())
+      sessions[i]->leaveChannel();
+  }
+}
+
+size_t RecorderManager::sessionCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_sessions.size();
+}
+
+std::vector<uint32_t> RecorderManager::sessionIds() const {
+  std::vector<uint32_t> ids;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (size_t i = 0; i < m_sessions.size(); i++)
+    ids.push_back(m_sessions[i].m_id);
+  return ids;
+}
+
+void RecorderManager::collect(uint32_t id, AgoraSdk &sdk, RecorderSessionStats &stats) {
+  stats = RecorderSessionStats();
+  stats.m_id = id;
+  stats.m_running = sdk.joined();
+  stats.m_peers = static_cast<uint32_t>(sdk.getPeerCount());
+  stats.m_layoutPushes = sdk.getLayoutPushCount();
+  stats.m_retainedBytes = sdk.getRetainedBytes();
+
+  std::vector<MediaAccountingEntry> entries(sdk.getMediaStatsCount());
+  entries.resize(sdk.getMediaStats(entries.data(), entries.size()));
+  stats.m_mediaUids = static_cast<uint32_t>(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    stats.m_audioFrames += entries[i].m_audio.m_frames;
+    stats.m_audioBytes += entries[i].m_audio.m_bytes;
+    stats.m_videoFrames += entries[i].m_video.m_frames;
+    stats.m_videoBytes += entries[i].m_video.m_bytes;
+  }
+
+  FrameQueue *queue = sdk.getFrameQueue();
+  if (queue) {
+    FrameQueueStats queueStats = queue->stats();
+    stats.m_queuedFrames = queueStats.m_size;
+    stats.m_droppedFrames = queueStats.m_dropped;
+  }
+}
+
+bool RecorderManager::getSessionStats(uint32_t id, RecorderSessionStats &stats) const {
+  SessionPtr sdk = find(id);
+  if (!sdk)
+    return false;
+  collect(id, *sdk, stats);
+  return true;
+}
+
+std::vector<RecorderSessionStats> RecorderManager::getStats() const {
+  std::vector<Session> sessions;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    sessions = m_sessions;
+  }
+  std::vector<RecorderSessionStats> stats(sessions.size());
+  for (size_t i = 0; i < sessions.size(); i++)
+    collect(sessions[i].m_id, *sessions[i].m_sdk, stats[i]);
+  return stats;
+}
+
+}
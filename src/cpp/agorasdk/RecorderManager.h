@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AgoraSdk.h"
+#include "EventExecutor.h"
+#include "FramePool.h"
+#include "TimerQueue.h"
+
+namespace agora {
+
+//Resource use of one session. Mirrored by SessionStats in lib.rs.
+struct RecorderSessionStats {
+    uint32_t m_id;
+    bool m_running;
+    uint32_t m_peers;
+    uint32_t m_mediaUids;
+    uint64_t m_audioFrames;
+    uint64_t m_audioBytes;
+    uint64_t m_videoFrames;
+    uint64_t m_videoBytes;
+    uint64_t m_layoutPushes;
+    uint64_t m_retainedBytes;
+    uint64_t m_queuedFrames;
+    uint64_t m_droppedFrames;
+    RecorderSessionStats():
+        m_id(0),
+        m_running(false),
+        m_peers(0),
+        m_mediaUids(0),
+        m_audioFrames(0),
+        m_audioBytes(0),
+        m_videoFrames(0),
+        m_videoBytes(0),
+        m_layoutPushes(0),
+        m_retainedBytes(0),
+        m_queuedFrames(0),
+        m_droppedFrames(0)
+    {};
+};
+
+//Hosts many recorders in one process. Every session is an AgoraSdk with
+//its own handler and engine; they share the manager's timer threads for
+//layout debouncing, its event workers and one frame pool. Sessions hold a reference, so the
+//manager lives until the last session is destroyed and the last owner
+//releases it. A last release from one of the manager's own threads hands
+//the teardown to a detached thread, since those threads are joined.
+class RecorderManager {
+    public:
+        explicit RecorderManager(size_t workers = 2, FramePool *pool = FramePool::shared());
+
+        void retain();
+        void release();
+
+        AgoraSdk* createSession();
+        //Leaves the session's channel if needed and deletes it.
+        void destroySession(AgoraSdk *session);
+        //0 if session is not one of ours.
+        uint32_t sessionId(const AgoraSdk *session) const;
+
+        bool startSession(uint32_t id, const string &appid, const string &channelKey, const string &name,
+                agora::linuxsdk::uid_t uid, agora::recording::RecordingConfig &config);
+        bool stopSession(uint32_t id);
+        void stopAll();
+
+        size_t sessionCount() const;
+        std::vector<uint32_t> sessionIds() const;
+        bool getSessionStats(uint32_t id, RecorderSessionStats &stats) const;
+        std::vector<RecorderSessionStats> getStats() const;
+
+        FramePool* framePool() const { return m_pool; }
+        TimerQueue* timers() { return &m_timers; }
+        EventExecutor* events() { return &m_events; }
+
+    private:
+        typedef std::shared_ptr<AgoraSdk> SessionPtr;
+        struct Session {
+            uint32_t m_id;
+            SessionPtr m_sdk;
+        };
+
+        ~RecorderManager();
+        SessionPtr find(uint32_t id) const;
+        static void collect(uint32_t id, AgoraSdk &sdk, RecorderSessionStats &stats);
+
+        std::atomic<int> m_refs;
+        FramePool *m_pool;
+        TimerQueue m_timers;
+        EventExecutor m_events;
+        mutable std::mutex m_mutex;
+        std::vector<Session> m_sessions;
+        uint32_t m_nextId;
+};
+
+}
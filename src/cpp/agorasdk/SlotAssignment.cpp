@@ -0,0 +1,70 @@
+#include "SlotAssignment.h"
+
+namespace agora {
+
+SlotAssignment::SlotAssignment() :
+  m_firstHole(0)
+  , m_compactions(0)
+{
+}
+
+const std::vector<agora::linuxsdk::uid_t>& SlotAssignment::assign(const std::vector<agora::linuxsdk::uid_t> &uids) {
+  m_seen.clear();
+  for (size_t i = 0; i < uids.size(); i++)
+    m_seen[uids[i]] = i;
+
+  //leavers leave holes
+  for (std::unordered_map<agora::linuxsdk::uid_t, size_t>::iterator it = m_index.begin(); it != m_index.end();) {
+    if (m_seen.find(it->first) == m_seen.end()) {
+      m_slots[it->second] = 0;
+      if (it->second < m_firstHole)
+        m_firstHole = it->second;
+      it = m_index.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  //joiners take the lowest hole, in the order they are listed
+  for (size_t i = 0; i < uids.size(); i++) {
+    if (uids[i] == 0 || m_index.find(uids[i]) != m_index.end())
+      continue;
+    while (m_firstHole < m_slots.size() && m_slots[m_firstHole] != 0)
+      m_firstHole++;
+    if (m_firstHole == m_slots.size())
+      m_slots.push_back(0);
+    m_slots[m_firstHole] = uids[i];
+    m_index[uids[i]] = m_firstHole;
+    m_firstHole++;
+  }
+
+  while (!m_slots.empty() && m_slots.back() == 0)
+    m_slots.pop_back();
+  if (m_firstHole > m_slots.size())
+    m_firstHole = m_slots.size();
+  return m_slots;
+}
+
+void SlotAssignment::compact() {
+  if (holes() == 0)
+    return;
+  size_t out = 0;
+  for (size_t i = 0; i < m_slots.size(); i++) {
+    if (m_slots[i] == 0)
+      continue;
+    m_slots[out] = m_slots[i];
+    m_index[m_slots[i]] = out;
+    out++;
+  }
+  m_slots.resize(out);
+  m_firstHole = out;
+  m_compactions++;
+}
+
+void SlotAssignment::clear() {
+  m_slots.clear();
+  m_index.clear();
+  m_firstHole = 0;
+}
+
+}
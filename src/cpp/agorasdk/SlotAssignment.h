@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+#include "IAgoraLinuxSdkCommon.h"
+
+namespace agora {
+
+//Keeps each uid in the layout slot it was first given, so a leaver doesn't
+//shift everyone after it into a new tile. A leaver's slot becomes a hole (uid
+//0) that the next joiner takes; trailing holes are dropped since nobody moves
+//when they go. compact() closes the remaining holes, keeping slot order, and
+//is left to the caller for when the tile size would change anyway.
+//Not thread safe; AgoraSdk calls it under its layout mutex.
+class SlotAssignment {
+    public:
+        SlotAssignment();
+
+        //Slots for uids, holes included.
+        const std::vector<agora::linuxsdk::uid_t>& assign(const std::vector<agora::linuxsdk::uid_t> &uids);
+        void compact();
+        void clear();
+
+        const std::vector<agora::linuxsdk::uid_t>& slots() const { return m_slots; }
+        size_t active() const { return m_index.size(); }
+        size_t holes() const { return m_slots.size() - m_index.size(); }
+        uint64_t compactions() const { return m_compactions; }
+
+    private:
+        std::vector<agora::linuxsdk::uid_t> m_slots;
+        //uid -> slot
+        std::unordered_map<agora::linuxsdk::uid_t, size_t> m_index;
+        //uids seen in the current assign(), reused between calls
+        std::unordered_map<agora::linuxsdk::uid_t, size_t> m_seen;
+        size_t m_firstHole;
+        uint64_t m_compactions;
+};
+
+}
@@ -0,0 +1,244 @@
+#include <chrono>
+#include <cstring>
+
+#include "StatsBatch.h"
+
+namespace agora {
+
+static uint64_t steadyMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+StatsBatch::StatsBatch(StatsBatcher *owner, size_t capacity) :
+  m_owner(owner)
+  , m_capacity(capacity)
+  , m_volumeMs(capacity), m_volumeUid(capacity), m_volume(capacity)
+  , m_videoMs(capacity), m_videoUid(capacity), m_videoDelay(capacity), m_videoWidth(capacity)
+  , m_videoHeight(capacity), m_videoBitrate(capacity), m_videoFps(capacity), m_videoStreamType(capacity)
+  , m_audioMs(capacity), m_audioUid(capacity), m_audioQuality(capacity), m_audioNetworkDelay(capacity)
+  , m_audioJitterDelay(capacity), m_audioLossRate(capacity)
+  , m_recordingMs(capacity), m_recordingDuration(capacity), m_recordingRxBytes(capacity)
+  , m_recordingRxKBitRate(capacity), m_recordingRxAudioKBitRate(capacity), m_recordingRxVideoKBitRate(capacity)
+  , m_recordingLastmileDelay(capacity), m_recordingUserCount(capacity), m_recordingCpuApp(capacity)
+  , m_recordingCpuTotal(capacity)
+{
+  //the columns never resize, so the pointers hold for the batch's lifetime
+  memset(&m_view, 0, sizeof(m_view));
+  m_view.volume_ms = m_volumeMs.data();
+  m_view.volume_uid = m_volumeUid.data();
+  m_view.volume = m_volume.data();
+  m_view.video_ms = m_videoMs.data();
+  m_view.video_uid = m_videoUid.data();
+  m_view.video_delay = m_videoDelay.data();
+  m_view.video_width = m_videoWidth.data();
+  m_view.video_height = m_videoHeight.data();
+  m_view.video_bitrate = m_videoBitrate.data();
+  m_view.video_fps = m_videoFps.data();
+  m_view.video_stream_type = m_videoStreamType.data();
+  m_view.audio_ms = m_audioMs.data();
+  m_view.audio_uid = m_audioUid.data();
+  m_view.audio_quality = m_audioQuality.data();
+  m_view.audio_network_delay = m_audioNetworkDelay.data();
+  m_view.audio_jitter_delay = m_audioJitterDelay.data();
+  m_view.audio_loss_rate = m_audioLossRate.data();
+  m_view.recording_ms = m_recordingMs.data();
+  m_view.recording_duration = m_recordingDuration.data();
+  m_view.recording_rx_bytes = m_recordingRxBytes.data();
+  m_view.recording_rx_kbitrate = m_recordingRxKBitRate.data();
+  m_view.recording_rx_audio_kbitrate = m_recordingRxAudioKBitRate.data();
+  m_view.recording_rx_video_kbitrate = m_recordingRxVideoKBitRate.data();
+  m_view.recording_lastmile_delay = m_recordingLastmileDelay.data();
+  m_view.recording_user_count = m_recordingUserCount.data();
+  m_view.recording_cpu_app = m_recordingCpuApp.data();
+  m_view.recording_cpu_total = m_recordingCpuTotal.data();
+}
+
+bool StatsBatch::empty() const {
+  return m_view.volumes == 0 && m_view.video_stats == 0 && m_view.audio_stats == 0 && m_view.recording_stats == 0;
+}
+
+bool StatsBatch::full() const {
+  return m_view.volumes == m_capacity || m_view.video_stats == m_capacity
+    || m_view.audio_stats == m_capacity || m_view.recording_stats == m_capacity;
+}
+
+void StatsBatch::clear() {
+  m_view.first_ms = 0;
+  m_view.last_ms = 0;
+  m_view.volumes = 0;
+  m_view.video_stats = 0;
+  m_view.audio_stats = 0;
+  m_view.recording_stats = 0;
+}
+
+void StatsBatch::touch(uint64_t ms) {
+  if (empty())
+    m_view.first_ms = ms;
+  m_view.last_ms = ms;
+}
+
+void StatsBatch::release() {
+  m_owner->recycle(this);
+}
+
+StatsBatcher::StatsBatcher(size_t capacity, uint32_t intervalMs) :
+  m_capacity(capacity ? capacity : 1)
+  , m_intervalMs(intervalMs)
+  , m_current(NULL)
+{
+}
+
+StatsBatcher::~StatsBatcher() {
+  delete m_current;
+  for (size_t i = 0; i < m_free.size(); i++)
+    delete m_free[i];
+}
+
+void StatsBatcher::configure(size_t capacity, uint32_t intervalMs) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_capacity = capacity ? capacity : 1;
+  m_intervalMs = intervalMs;
+  for (size_t i = 0; i < m_free.size(); i++)
+    delete m_free[i];
+  m_free.clear();
+}
+
+void StatsBatcher::recycle(StatsBatch *batch) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  recycleLocked(batch);
+}
+
+void StatsBatcher::recycleLocked(StatsBatch *batch) {
+  if (batch->m_capacity != m_capacity) {
+    delete batch;
+    return;
+  }
+  batch->clear();
+  m_free.push_back(batch);
+}
+
+StatsBatch* StatsBatcher::current() {
+  if (m_current)
+    return m_current;
+  if (!m_free.empty()) {
+    m_current = m_free.back();
+    m_free.pop_back();
+  } else {
+    m_current = new StatsBatch(this, m_capacity);
+  }
+  return m_current;
+}
+
+StatsBatch* StatsBatcher::take() {
+  StatsBatch *batch = m_current;
+  m_current = NULL;
+  if (batch && batch->empty()) {
+    recycleLocked(batch);
+    return NULL;
+  }
+  if (batch)
+    m_stats.m_batches++;
+  return batch;
+}
+
+StatsBatch* StatsBatcher::ready(uint64_t now, size_t rows, uint32_t StatsBatchView::*count) {
+  StatsBatch *batch = m_current;
+  if (!batch || batch->empty())
+    return NULL;
+  bool aged = now - batch->m_view.first_ms >= m_intervalMs;
+  bool noRoom = batch->m_view.*count + rows > batch->m_capacity;
+  return aged || noRoom ? take() : NULL;
+}
+
+StatsBatch* StatsBatcher::addVolume(const agora::linuxsdk::AudioVolumeInfo *speakers, unsigned int speakerNum) {
+  uint64_t now = steadyMs();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t rows = speakers ? speakerNum : 0;
+  StatsBatch *out = ready(now, rows, &StatsBatchView::volumes);
+  StatsBatch *batch = current();
+  if (rows > batch->m_capacity)
+    rows = batch->m_capacity;
+  if (rows == 0)
+    return out;
+
+  batch->touch(now);
+  uint32_t row = batch->m_view.volumes;
+  for (size_t i = 0; i < rows; i++, row++) {
+    batch->m_volumeMs[row] = now;
+    batch->m_volumeUid[row] = speakers[i].uid;
+    batch->m_volume[row] = speakers[i].volume;
+  }
+  batch->m_view.volumes = row;
+  m_stats.m_samples += rows;
+  return out ? out : (batch->full() ? take() : NULL);
+}
+
+StatsBatch* StatsBatcher::addRemoteVideoStats(uint32_t uid, const agora::linuxsdk::RemoteVideoStats &stats) {
+  uint64_t now = steadyMs();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  StatsBatch *out = ready(now, 1, &StatsBatchView::video_stats);
+  StatsBatch *batch = current();
+  batch->touch(now);
+  uint32_t row = batch->m_view.video_stats++;
+  batch->m_videoMs[row] = now;
+  batch->m_videoUid[row] = uid;
+  batch->m_videoDelay[row] = stats.delay;
+  batch->m_videoWidth[row] = stats.width;
+  batch->m_videoHeight[row] = stats.height;
+  batch->m_videoBitrate[row] = stats.receivedBitrate;
+  batch->m_videoFps[row] = stats.decoderOutputFrameRate;
+  batch->m_videoStreamType[row] = stats.rxStreamType;
+  m_stats.m_samples++;
+  return out ? out : (batch->full() ? take() : NULL);
+}
+
+StatsBatch* StatsBatcher::addRemoteAudioStats(uint32_t uid, const agora::linuxsdk::RemoteAudioStats &stats) {
+  uint64_t now = steadyMs();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  StatsBatch *out = ready(now, 1, &StatsBatchView::audio_stats);
+  StatsBatch *batch = current();
+  batch->touch(now);
+  uint32_t row = batch->m_view.audio_stats++;
+  batch->m_audioMs[row] = now;
+  batch->m_audioUid[row] = uid;
+  batch->m_audioQuality[row] = stats.quality;
+  batch->m_audioNetworkDelay[row] = stats.networkTransportDelay;
+  batch->m_audioJitterDelay[row] = stats.jitterBufferDelay;
+  batch->m_audioLossRate[row] = stats.audioLossRate;
+  m_stats.m_samples++;
+  return out ? out : (batch->full() ? take() : NULL);
+}
+
+StatsBatch* StatsBatcher::addRecordingStats(const agora::linuxsdk::RecordingStats &stats) {
+  uint64_t now = steadyMs();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  StatsBatch *out = ready(now, 1, &StatsBatchView::recording_stats);
+  StatsBatch *batch = current();
+  batch->touch(now);
+  uint32_t row = batch->m_view.recording_stats++;
+  batch->m_recordingMs[row] = now;
+  batch->m_recordingDuration[row] = stats.duration;
+  batch->m_recordingRxBytes[row] = stats.rxBytes;
+  batch->m_recordingRxKBitRate[row] = stats.rxKBitRate;
+  batch->m_recordingRxAudioKBitRate[row] = stats.rxAudioKBitRate;
+  batch->m_recordingRxVideoKBitRate[row] = stats.rxVideoKBitRate;
+  batch->m_recordingLastmileDelay[row] = stats.lastmileDelay;
+  batch->m_recordingUserCount[row] = stats.userCount;
+  batch->m_recordingCpuApp[row] = stats.cpuAppUsage;
+  batch->m_recordingCpuTotal[row] = stats.cpuTotalUsage;
+  m_stats.m_samples++;
+  return out ? out : (batch->full() ? take() : NULL);
+}
+
+StatsBatch* StatsBatcher::flush() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return take();
+}
+
+StatsBatcherStats StatsBatcher::stats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "IAgoraLinuxSdkCommon.h"
+
+namespace agora {
+
+class StatsBatcher;
+
+//Columns of one flush, passed across to Rust by pointer. Every sample has
+//the steady clock ms it was taken at. Mirrored by RawStatsBatch in lib.rs.
+struct StatsBatchView {
+    uint64_t first_ms;
+    uint64_t last_ms;
+
+    uint32_t volumes;
+    const uint64_t *volume_ms;
+    const uint32_t *volume_uid;
+    const uint32_t *volume;
+
+    uint32_t video_stats;
+    const uint64_t *video_ms;
+    const uint32_t *video_uid;
+    const int32_t *video_delay;
+    const int32_t *video_width;
+    const int32_t *video_height;
+    const int32_t *video_bitrate;
+    const int32_t *video_fps;
+    const int32_t *video_stream_type;
+
+    uint32_t audio_stats;
+    const uint64_t *audio_ms;
+    const uint32_t *audio_uid;
+    const int32_t *audio_quality;
+    const int32_t *audio_network_delay;
+    const int32_t *audio_jitter_delay;
+    const int32_t *audio_loss_rate;
+
+    uint32_t recording_stats;
+    const uint64_t *recording_ms;
+    const uint32_t *recording_duration;
+    const uint32_t *recording_rx_bytes;
+    const uint32_t *recording_rx_kbitrate;
+    const uint32_t *recording_rx_audio_kbitrate;
+    const uint32_t *recording_rx_video_kbitrate;
+    const uint32_t *recording_lastmile_delay;
+    const uint32_t *recording_user_count;
+    const double *recording_cpu_app;
+    const double *recording_cpu_total;
+};
+
+//Fixed-capacity structure of arrays for the high-frequency stats callbacks.
+//Each kind of sample has its own columns, so a batch is full as soon as any
+//one of them is.
+class StatsBatch {
+    public:
+        size_t capacity() const { return m_capacity; }
+        bool empty() const;
+        const StatsBatchView& view() const { return m_view; }
+        //Hands the batch back to the batcher that filled it.
+        void release();
+
+    private:
+        friend class StatsBatcher;
+        explicit StatsBatch(StatsBatcher *owner, size_t capacity);
+        bool full() const;
+        void clear();
+        void touch(uint64_t ms);
+
+        StatsBatcher *m_owner;
+        size_t m_capacity;
+        StatsBatchView m_view;
+
+        std::vector<uint64_t> m_volumeMs;
+        std::vector<uint32_t> m_volumeUid;
+        std::vector<uint32_t> m_volume;
+
+        std::vector<uint64_t> m_videoMs;
+        std::vector<uint32_t> m_videoUid;
+        std::vector<int32_t> m_videoDelay;
+        std::vector<int32_t> m_videoWidth;
+        std::vector<int32_t> m_videoHeight;
+        std::vector<int32_t> m_videoBitrate;
+        std::vector<int32_t> m_videoFps;
+        std::vector<int32_t> m_videoStreamType;
+
+        std::vector<uint64_t> m_audioMs;
+        std::vector<uint32_t> m_audioUid;
+        std::vector<int32_t> m_audioQuality;
+        std::vector<int32_t> m_audioNetworkDelay;
+        std::vector<int32_t> m_audioJitterDelay;
+        std::vector<int32_t> m_audioLossRate;
+
+        std::vector<uint64_t> m_recordingMs;
+        std::vector<uint32_t> m_recordingDuration;
+        std::vector<uint32_t> m_recordingRxBytes;
+        std::vector<uint32_t> m_recordingRxKBitRate;
+        std::vector<uint32_t> m_recordingRxAudioKBitRate;
+        std::vector<uint32_t> m_recordingRxVideoKBitRate;
+        std::vector<uint32_t> m_recordingLastmileDelay;
+        std::vector<uint32_t> m_recordingUserCount;
+        std::vector<double> m_recordingCpuApp;
+        std::vector<double> m_recordingCpuTotal;
+};
+
+struct StatsBatcherStats {
+    uint64_t m_samples;
+    uint64_t m_batches;
+    StatsBatcherStats():
+        m_samples(0),
+        m_batches(0)
+    {};
+};
+
+//Collects volume indications and remote/recording stats into batches so
+//they cross to Rust once per interval instead of once per callback. A
+//batch is handed out when it fills up or when the next sample arrives
+//intervalMs after its first one; flush() takes whatever is left. Every add
+//returns the batch that is ready, if any, and the caller delivers it and
+//calls release() on it when done.
+class StatsBatcher {
+    public:
+        explicit StatsBatcher(size_t capacity = 256, uint32_t intervalMs = 1000);
+        //Batches still out must have been released.
+        ~StatsBatcher();
+
+        //Applies from the next batch. A capacity of 1 delivers every sample
+        //on its own.
+        void configure(size_t capacity, uint32_t intervalMs);
+
+        StatsBatch* addVolume(const agora::linuxsdk::AudioVolumeInfo *speakers, unsigned int speakerNum);
+        StatsBatch* addRemoteVideoStats(uint32_t uid, const agora::linuxsdk::RemoteVideoStats &stats);
+        StatsBatch* addRemoteAudioStats(uint32_t uid, const agora::linuxsdk::RemoteAudioStats &stats);
+        StatsBatch* addRecordingStats(const agora::linuxsdk::RecordingStats &stats);
+        StatsBatch* flush();
+
+        StatsBatcherStats stats() const;
+
+    private:
+        friend class StatsBatch;
+        void recycle(StatsBatch *batch);
+        //The rest are called with m_mutex held.
+        void recycleLocked(StatsBatch *batch);
+        //Current batch, starting one if needed.
+        StatsBatch* current();
+        //Hands out the current batch if it has aged out or has no room for
+        //rows more samples in the column counted by count.
+        StatsBatch* ready(uint64_t now, size_t rows, uint32_t StatsBatchView::*count);
+        StatsBatch* take();
+
+        mutable std::mutex m_mutex;
+        size_t m_capacity;
+        uint32_t m_intervalMs;
+        StatsBatch *m_current;
+        std::vector<StatsBatch*> m_free;
+        StatsBatcherStats m_stats;
+};
+
+}
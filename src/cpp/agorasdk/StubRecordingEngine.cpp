@@ -0,0 +1,83 @@
+#include "StubRecordingEngine.h"
+
+namespace agora {
+
+StubRecordingEngine::StubRecordingEngine() :
+  m_layoutCount(0)
+  , m_lastRegionCount(0)
+{
+}
+
+StubRecordingEngine::~StubRecordingEngine() {
+}
+
+int StubRecordingEngine::joinChannel(const char * /*channelKey*/, const char * /*channelId*/, agora::linuxsdk::uid_t /*uid*/,
+    const agora::recording::RecordingConfig & /*config*/) {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::joinChannelWithUserAccount(const char * /*token*/, const char * /*channelId*/, const char * /*userAccount*/,
+    const agora::recording::RecordingConfig & /*config*/) {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::getUserInfoByUserAccount(const char * /*userAccount*/, agora::linuxsdk::UserInfo * /*userinfo*/) {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::getUserInfoByUid(agora::linuxsdk::uid_t /*uid*/, agora::linuxsdk::UserInfo * /*userInfo*/) {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::setVideoMixingLayout(const agora::linuxsdk::VideoMixingLayout &layout) {
+  m_lastRegionCount = layout.regionCount;
+  m_layoutCount++;
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::stoppedOnError() {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::leaveChannel() {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::release() {
+  delete this;
+  return agora::linuxsdk::ERR_OK;
+}
+
+const agora::recording::RecordingEngineProperties* StubRecordingEngine::getProperties() {
+  return &m_properties;
+}
+
+int StubRecordingEngine::startService() {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::stopService() {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::setUserBackground(agora::linuxsdk::uid_t /*uid*/, const char * /*img_path*/) {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::setLogLevel(agora::linuxsdk::agora_log_level /*level*/) {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::updateSubscribeVideoUids(agora::linuxsdk::uid_t * /*uids*/, uint32_t /*num*/) {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::updateSubscribeAudioUids(agora::linuxsdk::uid_t * /*uids*/, uint32_t /*num*/) {
+  return agora::linuxsdk::ERR_OK;
+}
+
+int StubRecordingEngine::updateWatermarkConfigs(uint32_t /*wm_num*/, agora::linuxsdk::WatermarkConfig * /*config*/) {
+  return agora::linuxsdk::ERR_OK;
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+#include "IAgoraLinuxSdkCommon.h"
+#include "IAgoraRecordingEngine.h"
+
+namespace agora {
+
+//IRecordingEngine that talks to no service. Every call succeeds and only
+//layout pushes are counted, so the wrapper can be driven without
+//AgoraCoreService or a channel.
+class StubRecordingEngine : public agora::recording::IRecordingEngine {
+    public:
+        StubRecordingEngine();
+        virtual ~StubRecordingEngine();
+
+        virtual int joinChannel(const char *channelKey, const char *channelId, agora::linuxsdk::uid_t uid,
+                const agora::recording::RecordingConfig &config);
+        virtual int joinChannelWithUserAccount(const char *token, const char *channelId, const char *userAccount,
+                const agora::recording::RecordingConfig &config);
+        virtual int getUserInfoByUserAccount(const char *userAccount, agora::linuxsdk::UserInfo *userinfo);
+        virtual int getUserInfoByUid(agora::linuxsdk::uid_t uid, agora::linuxsdk::UserInfo *userInfo);
+        virtual int setVideoMixingLayout(const agora::linuxsdk::VideoMixingLayout &layout);
+        virtual int stoppedOnError();
+        virtual int leaveChannel();
+        virtual int release();
+        virtual const agora::recording::RecordingEngineProperties* getProperties();
+        virtual int startService();
+        virtual int stopService();
+        virtual int setUserBackground(agora::linuxsdk::uid_t uid, const char *img_path);
+        virtual int setLogLevel(agora::linuxsdk::agora_log_level level);
+        virtual int updateSubscribeVideoUids(agora::linuxsdk::uid_t *uids, uint32_t num);
+        virtual int updateSubscribeAudioUids(agora::linuxsdk::uid_t *uids, uint32_t num);
+        virtual int updateWatermarkConfigs(uint32_t wm_num, agora::linuxsdk::WatermarkConfig *config);
+
+        uint64_t layoutCount() const { return m_layoutCount.load(); }
+        uint32_t lastRegionCount() const { return m_lastRegionCount.load(); }
+
+    protected:
+        std::atomic<uint64_t> m_layoutCount;
+        std::atomic<uint32_t> m_lastRegionCount;
+        agora::recording::RecordingEngineProperties m_properties;
+};
+
+}
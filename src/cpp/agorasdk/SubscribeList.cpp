@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cstring>
+
+#include "SubscribeList.h"
+
+namespace agora {
+
+static bool isBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+//Calls entry(begin, end, rawBegin, rawEnd) for each non-empty entry, trimmed
+//and untrimmed.
+template <typename EntryFn>
+static void forEachEntry(const char *list, size_t length, EntryFn entry) {
+  size_t start = 0;
+  for (size_t i = 0; i <= length; i++) {
+    if (i < length && list[i] != ',')
+      continue;
+    size_t begin = start, end = i;
+    while (begin < end && isBlank(list[begin]))
+      begin++;
+    while (end > begin && isBlank(list[end - 1]))
+      end--;
+    if (begin < end)
+      entry(begin, end, start, i);
+    start = i + 1;
+  }
+}
+
+static void malformed(ListParseReport &report, size_t start, size_t end) {
+  if (report.m_malformed++ == 0) {
+    report.m_firstMalformed.m_offset = static_cast<uint32_t>(start);
+    report.m_firstMalformed.m_length = static_cast<uint32_t>(end - start);
+  }
+}
+
+void parseUidList(const char *list, size_t length, std::vector<agora::linuxsdk::uid_t> &uids, ListParseReport &report) {
+  report = ListParseReport();
+  uids.clear();
+  if (!list)
+    return;
+
+  //lists are usually written in order, so the sort is often skipped
+  bool sorted = true;
+  forEachEntry(list, length, [&](size_t begin, size_t end, size_t start, size_t stop) {
+    uint64_t value = 0;
+    for (size_t i = begin; i < end; i++) {
+      unsigned digit = static_cast<unsigned char>(list[i]) - '0';
+      if (digit > 9 || (value = value * 10 + digit) > 0xffffffffu) {
+        malformed(report, start, stop);
+        return;
+      }
+    }
+    if (value == 0) {
+      malformed(report, start, stop);
+      return;
+    }
+    agora::linuxsdk::uid_t uid = static_cast<agora::linuxsdk::uid_t>(value);
+    if (!uids.empty() && uid <= uids.back())
+      sorted = false;
+    uids.push_back(uid);
+  });
+
+  size_t parsed = uids.size();
+  if (!sorted)
+    std::sort(uids.begin(), uids.end());
+  uids.erase(std::unique(uids.begin(), uids.end()), uids.end());
+  report.m_entries = uids.size();
+  report.m_duplicates = parsed - uids.size();
+}
+
+void parseAccountList(const char *list, size_t length, std::vector<ListEntry> &accounts, ListParseReport &report) {
+  report = ListParseReport();
+  accounts.clear();
+  if (!list)
+    return;
+
+  forEachEntry(list, length, [&](size_t begin, size_t end, size_t start, size_t stop) {
+    //the SDK's buffers hold the account and its terminator
+    if (end - begin >= agora::linuxsdk::MAX_USER_ACCOUNT_LENGTH) {
+      malformed(report, start, stop);
+      return;
+    }
+    ListEntry account;
+    account.m_offset = static_cast<uint32_t>(begin);
+    account.m_length = static_cast<uint32_t>(end - begin);
+    accounts.push_back(account);
+  });
+
+  std::sort(accounts.begin(), accounts.end(), [list](const ListEntry &a, const ListEntry &b) {
+    int order = memcmp(list + a.m_offset, list + b.m_offset, std::min(a.m_length, b.m_length));
+    return order < 0 || (order == 0 && a.m_length < b.m_length);
+  });
+  size_t parsed = accounts.size();
+  accounts.erase(std::unique(accounts.begin(), accounts.end(), [list](const ListEntry &a, const ListEntry &b) {
+    return a.m_length == b.m_length && memcmp(list + a.m_offset, list + b.m_offset, a.m_length) == 0;
+  }), accounts.end());
+  report.m_entries = accounts.size();
+  report.m_duplicates = parsed - accounts.size();
+}
+
+ListParseReport AccountList::assign(const char *list) {
+  ListParseReport report;
+  m_accounts.clear();
+  if (!list)
+    return report;
+  parseAccountList(list, strlen(list), m_parsed, report);
+  for (size_t i = 0; i < m_parsed.size(); i++)
+    m_accounts.insert(list + m_parsed[i].m_offset, m_parsed[i].m_length);
+  return report;
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "IAgoraLinuxSdkCommon.h"
+#include "FlatSet.h"
+
+namespace agora {
+
+//An entry of a comma separated list, by position in the list.
+struct ListEntry {
+    uint32_t m_offset;
+    uint32_t m_length;
+};
+
+struct ListParseReport {
+    //distinct entries kept
+    size_t m_entries;
+    size_t m_duplicates;
+    size_t m_malformed;
+    //the first malformed entry, untrimmed; zero length when there is none
+    ListEntry m_firstMalformed;
+    ListParseReport():
+        m_entries(0),
+        m_duplicates(0),
+        m_malformed(0)
+    {
+        m_firstMalformed.m_offset = 0;
+        m_firstMalformed.m_length = 0;
+    };
+};
+
+//Parsers for the subscribe lists in RecordingConfig. Both make one pass over
+//the list, trim blanks around each entry and skip empty ones, and write
+//straight into the caller's flat array, which is left sorted and without
+//duplicates. Nothing is allocated beyond growing that array, so reusing it
+//makes a parse allocation free.
+
+//A uid is 1 to 4294967295 in decimal; anything else is malformed and left out.
+void parseUidList(const char *list, size_t length, std::vector<agora::linuxsdk::uid_t> &uids, ListParseReport &report);
+
+//Entries point into list and are sorted by their bytes. An account is
+//malformed when it is longer than the SDK allows.
+void parseAccountList(const char *list, size_t length, std::vector<ListEntry> &accounts, ListParseReport &report);
+
+//A parsed account list, held in a hashed flat set for lookups.
+class AccountList {
+    public:
+        ListParseReport assign(const char *list);
+        bool contains(const char *account, size_t length) const { return m_accounts.contains(account, length); }
+        size_t size() const { return m_accounts.size(); }
+        void clear() { m_accounts.clear(); }
+
+    private:
+        FlatAccountSet m_accounts;
+        //reused between parses
+        std::vector<ListEntry> m_parsed;
+};
+
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "SubscriptionSet.h"
+
+namespace agora {
+
+SubscriptionSet::Reader::Reader(const SubscriptionSet &set) :
+  m_set(set)
+{
+  //a writer only frees snapshots it replaced before seeing no readers, so
+  //the one loaded after registering stays valid until the count drops
+  m_set.m_readers.fetch_add(1);
+  m_snapshot = m_set.m_current.load();
+}
+
+SubscriptionSet::Reader::~Reader() {
+  m_set.m_readers.fetch_sub(1);
+}
+
+SubscriptionSet::SubscriptionSet() :
+  m_version(0)
+  , m_flushedVersion(0)
+  , m_current(NULL)
+  , m_readers(0)
+{
+  SubscriptionSnapshot *empty = new SubscriptionSnapshot();
+  empty->m_version = 0;
+  m_current.store(empty);
+}
+
+SubscriptionSet::~SubscriptionSet() {
+  delete m_current.load();
+  for (size_t i = 0; i < m_retired.size(); i++)
+    delete m_retired[i];
+}
+
+size_t SubscriptionSet::add(const agora::linuxsdk::uid_t *uids, size_t count) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  //merge rather than insert one by one, so whitelists of tens of thousands
+  //of uids stay linear after sorting
+  size_t before = m_uids.size();
+  m_uids.insert(m_uids.end(), uids, uids + count);
+  std::vector<agora::linuxsdk::uid_t>::iterator added = m_uids.begin() + before;
+  if (!std::is_sorted(added, m_uids.end()))
+    std::sort(added, m_uids.end());
+  std::inplace_merge(m_uids.begin(), added, m_uids.end());
+  m_uids.erase(std::unique(m_uids.begin(), m_uids.end()), m_uids.end());
+  size_t changed = m_uids.size() - before;
+  if (changed > 0)
+    publish();
+  return changed;
+}
+
+size_t SubscriptionSet::remove(const agora::linuxsdk::uid_t *uids, size_t count) {
+  std::vector<agora::linuxsdk::uid_t> removed(uids, uids + count);
+  std::sort(removed.begin(), removed.end());
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t before = m_uids.size();
+  m_uids.erase(std::remove_if(m_uids.begin(), m_uids.end(), [&removed](agora::linuxsdk::uid_t uid) {
+    return std::binary_search(removed.begin(), removed.end(), uid);
+  }), m_uids.end());
+  size_t changed = before - m_uids.size();
+  if (changed > 0)
+    publish();
+  return changed;
+}
+
+size_t SubscriptionSet::assign(const agora::linuxsdk::uid_t *uids, size_t count) {
+  std::vector<agora::linuxsdk::uid_t> sorted(uids, uids + count);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  //uids in one set but not the other
+  std::vector<agora::linuxsdk::uid_t> difference;
+  std::set_symmetric_difference(m_uids.begin(), m_uids.end(), sorted.begin(), sorted.end(),
+      std::back_inserter(difference));
+  if (difference.empty())
+    return 0;
+  m_uids.swap(sorted);
+  publish();
+  return difference.size();
+}
+
+bool SubscriptionSet::pending(std::vector<agora::linuxsdk::uid_t> &uids, uint64_t &version) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_version == m_flushedVersion)
+    return false;
+  uids = m_uids;
+  version = m_version;
+  return true;
+}
+
+void SubscriptionSet::markFlushed(uint64_t version) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (version > m_flushedVersion)
+    m_flushedVersion = version;
+}
+
+bool SubscriptionSet::flushed() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_version == m_flushedVersion;
+}
+
+uint64_t SubscriptionSet::version() const {
+  Reader reader(*this);
+  return reader->m_version;
+}
+
+void SubscriptionSet::publish() {
+  SubscriptionSnapshot *snapshot = new SubscriptionSnapshot();
+  snapshot->m_version = ++m_version;
+  snapshot->m_uids.assign(m_uids);
+  m_retired.push_back(m_current.exchange(snapshot));
+  reclaim();
+}
+
+void SubscriptionSet::reclaim() {
+  //readers that register from here on load the new snapshot
+  if (m_readers.load() != 0)
+    return;
+  for (size_t i = 0; i < m_retired.size(); i++)
+    delete m_retired[i];
+  m_retired.clear();
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "IAgoraLinuxSdkCommon.h"
+#include "FlatSet.h"
+
+namespace agora {
+
+//One published state of a SubscriptionSet. Immutable once published.
+struct SubscriptionSnapshot {
+    uint64_t m_version;
+    FlatUidSet m_uids;
+
+    bool contains(agora::linuxsdk::uid_t uid) const { return m_uids.contains(uid); }
+};
+
+//The uids subscribed for one kind of media. Changes are serialized by a
+//mutex and each one publishes a new versioned snapshot; readers take the
+//current snapshot with a couple of atomic operations and never block on a
+//writer. Replaced snapshots are freed by the next change that finds no
+//reader in progress.
+//
+//The set also tracks which version the engine last accepted, so a burst of
+//changes can be sent to it as one update.
+class SubscriptionSet {
+    public:
+        SubscriptionSet();
+        ~SubscriptionSet();
+
+        //Pins the current snapshot for the reader's lifetime.
+        class Reader {
+            public:
+                explicit Reader(const SubscriptionSet &set);
+                ~Reader();
+                const SubscriptionSnapshot& operator*() const { return *m_snapshot; }
+                const SubscriptionSnapshot* operator->() const { return m_snapshot; }
+
+            private:
+                Reader(const Reader&);
+                Reader& operator=(const Reader&);
+
+                const SubscriptionSet &m_set;
+                const SubscriptionSnapshot *m_snapshot;
+        };
+
+        //Each returns the number of uids that changed; no new version is
+        //published when that is 0.
+        size_t add(const agora::linuxsdk::uid_t *uids, size_t count);
+        size_t remove(const agora::linuxsdk::uid_t *uids, size_t count);
+        size_t assign(const agora::linuxsdk::uid_t *uids, size_t count);
+
+        //Copies the set out if it has changed since the engine last accepted
+        //it; pass the version to markFlushed() once the engine has.
+        bool pending(std::vector<agora::linuxsdk::uid_t> &uids, uint64_t &version);
+        void markFlushed(uint64_t version);
+        bool flushed();
+
+        uint64_t version() const;
+
+    private:
+        SubscriptionSet(const SubscriptionSet&);
+        SubscriptionSet& operator=(const SubscriptionSet&);
+
+        void publish();
+        void reclaim();
+
+        std::mutex m_mutex;
+        //writer's copy, sorted
+        std::vector<agora::linuxsdk::uid_t> m_uids;
+        uint64_t m_version;
+        uint64_t m_flushedVersion;
+        std::atomic<const SubscriptionSnapshot*> m_current;
+        mutable std::atomic<uint32_t> m_readers;
+        std::vector<const SubscriptionSnapshot*> m_retired;
+};
+
+}
@@ -0,0 +1,130 @@
+#include <cstring>
+
+#include "TalkAnalytics.h"
+
+namespace agora {
+
+//speakers quieter than this are treated as background noise
+static const uint32_t kDefaultThreshold = 16;
+
+TalkAnalytics::TalkAnalytics() :
+  m_size(0)
+  , m_threshold(kDefaultThreshold)
+  , m_intervalMs(0)
+  , m_lastMs(0)
+{
+  clear();
+}
+
+void TalkAnalytics::clear() {
+  memset(m_slots, 0, sizeof(m_slots));
+  memset(&m_channel, 0, sizeof(m_channel));
+  m_size = 0;
+  m_lastMs = 0;
+}
+
+//Open addressing keyed by uid; uid 0 is the local user and never stored, so
+//it marks a free slot.
+TalkAnalytics::Slot* TalkAnalytics::find(agora::linuxsdk::uid_t uid) {
+  size_t index = (uid * 2654435761u) & (kSlots - 1);
+  while (m_slots[index].m_stats.m_uid != 0) {
+    if (m_slots[index].m_stats.m_uid == uid)
+      return &m_slots[index];
+    index = (index + 1) & (kSlots - 1);
+  }
+  return NULL;
+}
+
+TalkAnalytics::Slot* TalkAnalytics::slotFor(agora::linuxsdk::uid_t uid, uint64_t nowMs) {
+  size_t index = (uid * 2654435761u) & (kSlots - 1);
+  while (m_slots[index].m_stats.m_uid != 0) {
+    if (m_slots[index].m_stats.m_uid == uid)
+      return &m_slots[index];
+    index = (index + 1) & (kSlots - 1);
+  }
+  if (m_size == kMaxUids) {
+    m_channel.m_dropped++;
+    return NULL;
+  }
+  Slot &slot = m_slots[index];
+  slot.m_stats.m_uid = uid;
+  slot.m_joinedMs = nowMs;
+  slot.m_present = true;
+  m_order[m_size++] = static_cast<uint16_t>(index);
+  return &slot;
+}
+
+void TalkAnalytics::join(agora::linuxsdk::uid_t uid, uint64_t nowMs) {
+  if (uid == 0)
+    return;
+  Slot *slot = slotFor(uid, nowMs);
+  if (!slot || slot->m_present)
+    return;
+  slot->m_joinedMs = nowMs;
+  slot->m_present = true;
+}
+
+void TalkAnalytics::leave(agora::linuxsdk::uid_t uid, uint64_t nowMs) {
+  Slot *slot = uid != 0 ? find(uid) : NULL;
+  if (!slot || !slot->m_present)
+    return;
+  if (nowMs > slot->m_joinedMs)
+    slot->m_stats.m_presentMs += nowMs - slot->m_joinedMs;
+  slot->m_present = false;
+}
+
+void TalkAnalytics::addVolumes(const agora::linuxsdk::AudioVolumeInfo *speakers, unsigned int speakerNum, uint64_t nowMs) {
+  if (!speakers)
+    speakerNum = 0;
+
+  //the first indication only starts the clock
+  uint64_t step = 0;
+  if (m_lastMs != 0 && nowMs > m_lastMs) {
+    step = nowMs - m_lastMs;
+    if (m_intervalMs > 0 && step > 2 * static_cast<uint64_t>(m_intervalMs))
+      step = m_intervalMs;
+  }
+  m_lastMs = nowMs;
+
+  unsigned int speaking = 0;
+  for (unsigned int i = 0; i < speakerNum; i++) {
+    if (speakers[i].uid != 0 && speakers[i].volume >= m_threshold)
+      speaking++;
+  }
+
+  m_channel.m_elapsedMs += step;
+  if (speaking == 0) {
+    m_channel.m_silenceMs += step;
+    return;
+  }
+  m_channel.m_speechMs += step;
+  uint64_t overlap = speaking > 1 ? step : 0;
+  m_channel.m_overlapMs += overlap;
+
+  for (unsigned int i = 0; i < speakerNum; i++) {
+    if (speakers[i].uid == 0 || speakers[i].volume < m_threshold)
+      continue;
+    Slot *slot = slotFor(speakers[i].uid, nowMs);
+    if (!slot)
+      continue;
+    slot->m_stats.m_indications++;
+    slot->m_stats.m_speakingMs += step;
+    slot->m_stats.m_overlapMs += overlap;
+  }
+}
+
+size_t TalkAnalytics::snapshot(TalkUserStats *entries, size_t max, TalkChannelStats &channel, uint64_t nowMs) const {
+  channel = m_channel;
+  channel.m_snapshotMs = nowMs;
+  channel.m_users = static_cast<uint32_t>(m_size);
+  size_t count = m_size < max ? m_size : max;
+  for (size_t i = 0; i < count; i++) {
+    const Slot &slot = m_slots[m_order[i]];
+    entries[i] = slot.m_stats;
+    if (slot.m_present && nowMs > slot.m_joinedMs)
+      entries[i].m_presentMs += nowMs - slot.m_joinedMs;
+  }
+  return count;
+}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "IAgoraLinuxSdkCommon.h"
+
+namespace agora {
+
+//Totals for one uid. The layout is mirrored by TalkerStats on the Rust side.
+struct TalkUserStats {
+    uint32_t m_uid;
+    //indications the uid was speaking in
+    uint32_t m_indications;
+    uint64_t m_speakingMs;
+    //speaking while someone else was too
+    uint64_t m_overlapMs;
+    //time in the channel, counted from the join or the first indication
+    uint64_t m_presentMs;
+};
+
+//Channel totals. The layout is mirrored by TalkChannelStats on the Rust side.
+struct TalkChannelStats {
+    //time covered by volume indications
+    uint64_t m_elapsedMs;
+    //at least one uid speaking
+    uint64_t m_speechMs;
+    //two or more uids speaking
+    uint64_t m_overlapMs;
+    //nobody speaking
+    uint64_t m_silenceMs;
+    //steady clock time the snapshot was taken at
+    uint64_t m_snapshotMs;
+    uint32_t m_users;
+    //updates lost to uids that arrived after the table filled up
+    uint32_t m_dropped;
+};
+
+//Speaking time per uid from volume indications. A uid speaks in an indication
+//when its volume reaches the threshold, and the time since the previous
+//indication is credited to everyone speaking in it. Steps longer than twice
+//the indication interval are cut to one interval, so a stall in the callbacks
+//doesn't count as a long monologue. Counters live in a fixed open-addressed
+//table; each indication costs O(speakerNum) and never allocates.
+//Not thread safe; AgoraSdk calls it under its talk mutex.
+class TalkAnalytics {
+    public:
+        enum {
+            kMaxUids = 384,
+        };
+
+        TalkAnalytics();
+
+        //volume (0-255) that counts as speaking
+        void setThreshold(uint32_t volume) { m_threshold = volume; }
+        uint32_t threshold() const { return m_threshold; }
+        //expected time between indications; 0 leaves steps uncapped
+        void setInterval(uint32_t intervalMs) { m_intervalMs = intervalMs; }
+
+        void join(agora::linuxsdk::uid_t uid, uint64_t nowMs);
+        void leave(agora::linuxsdk::uid_t uid, uint64_t nowMs);
+        void addVolumes(const agora::linuxsdk::AudioVolumeInfo *speakers, unsigned int speakerNum, uint64_t nowMs);
+
+        //Copies up to max uids in first-seen order, returns how many were written.
+        size_t snapshot(TalkUserStats *entries, size_t max, TalkChannelStats &channel, uint64_t nowMs) const;
+        size_t size() const { return m_size; }
+        void clear();
+
+    private:
+        enum {
+            //twice kMaxUids rounded up, so probes stay short when full
+            kSlots = 1024,
+        };
+
+        struct Slot {
+            TalkUserStats m_stats;
+            uint64_t m_joinedMs;
+            bool m_present;
+        };
+
+        Slot* find(agora::linuxsdk::uid_t uid);
+        Slot* slotFor(agora::linuxsdk::uid_t uid, uint64_t nowMs);
+
+        Slot m_slots[kSlots];
+        //slot indexes in first-seen order
+        uint16_t m_order[kMaxUids];
+        size_t m_size;
+        uint32_t m_threshold;
+        uint32_t m_intervalMs;
+        uint64_t m_lastMs;
+        TalkChannelStats m_channel;
+};
+
+}
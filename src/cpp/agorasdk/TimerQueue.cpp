@@ -0,0 +1,122 @@
+#include "TimerQueue.h"
+
+namespace agora {
+
+TimerQueue::TimerQueue(size_t threads) :
+  m_nextId(1)
+  , m_stopping(false)
+  , m_fired(0)
+{
+  if (threads == 0)
+    threads = 1;
+  for (size_t i = 0; i < threads; i++)
+    m_threads.push_back(std::thread(&TimerQueue::run, this));
+}
+
+TimerQueue::~TimerQueue() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+    m_tasks.clear();
+  }
+  m_cond.notify_all();
+  for (size_t i = 0; i < m_threads.size(); i++)
+    m_threads[i].join();
+}
+
+TimerQueue* TimerQueue::shared() {
+  //leaked like EventExecutor::shared(), recorders may outlive static destruction
+  static TimerQueue *timers = new TimerQueue();
+  return timers;
+}
+
+bool TimerQueue::ownsThread() const {
+  for (size_t i = 0; i < m_threads.size(); i++) {
+    if (m_threads[i].get_id() == std::this_thread::get_id())
+      return true;
+  }
+  return false;
+}
+
+void TimerQueue::schedule(clock::time_point deadline, const Task &task, const void *owner) {
+  bool earliest;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Key key(deadline, m_nextId++);
+    Entry &entry = m_tasks[key];
+    entry.m_task = task;
+    entry.m_owner = owner;
+    earliest = m_tasks.begin()->first == key;
+  }
+  //only a new head changes how long the workers should sleep
+  if (earliest)
+    m_cond.notify_one();
+}
+
+bool TimerQueue::running(const void *owner) const {
+  for (size_t i = 0; i < m_running.size(); i++) {
+    if (m_running[i].m_owner == owner && m_running[i].m_thread != std::this_thread::get_id())
+      return true;
+  }
+  return false;
+}
+
+void TimerQueue::cancel(const void *owner) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (std::map<Key, Entry>::iterator it = m_tasks.begin(); it != m_tasks.end();) {
+    if (it->second.m_owner == owner)
+      m_tasks.erase(it++);
+    else
+      ++it;
+  }
+  m_done.wait(lock, [this, owner] { return !running(owner); });
+}
+
+size_t TimerQueue::pending() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_tasks.size();
+}
+
+void TimerQueue::run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stopping) {
+    if (m_tasks.empty()) {
+      m_cond.wait(lock);
+      continue;
+    }
+    std::map<Key, Entry>::iterator head = m_tasks.begin();
+    //copied: another worker may run and erase the head while this one sleeps
+    clock::time_point deadline = head->first.first;
+    if (clock::now() < deadline) {
+      m_cond.wait_until(lock, deadline);
+      continue;
+    }
+
+    Task task;
+    task.swap(head->second.m_task);
+    Running running;
+    running.m_thread = std::this_thread::get_id();
+    running.m_owner = head->second.m_owner;
+    m_running.push_back(running);
+    m_tasks.erase(head);
+    //another worker can take the next head while this one runs
+    if (!m_tasks.empty())
+      m_cond.notify_one();
+    lock.unlock();
+
+    task();
+    task = Task();
+    m_fired++;
+
+    lock.lock();
+    for (size_t i = 0; i < m_running.size(); i++) {
+      if (m_running[i].m_thread == running.m_thread) {
+        m_running.erase(m_running.begin() + i);
+        break;
+      }
+    }
+    m_done.notify_all();
+  }
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace agora {
+
+//Runs deadline tasks on a fixed set of threads, so many recorders can
+//share workers instead of each starting its own.
+class TimerQueue {
+    public:
+        typedef std::chrono::steady_clock clock;
+        typedef std::function<void()> Task;
+
+        explicit TimerQueue(size_t threads = 1);
+        //Pending tasks are dropped.
+        ~TimerQueue();
+
+        //For recorders outside a RecorderManager. Never destroyed.
+        static TimerQueue* shared();
+
+        void schedule(clock::time_point deadline, const Task &task, const void *owner);
+        //Drops owner's pending tasks and waits out any that another thread
+        //is running, so owner can be destroyed once this returns.
+        void cancel(const void *owner);
+
+        size_t threads() const { return m_threads.size(); }
+        //True when called from one of the queue's own threads.
+        bool ownsThread() const;
+        size_t pending() const;
+        uint64_t fired() const { return m_fired.load(); }
+
+    private:
+        typedef std::pair<clock::time_point, uint64_t> Key;
+        struct Entry {
+            Task m_task;
+            const void *m_owner;
+        };
+        struct Running {
+            std::thread::id m_thread;
+            const void *m_owner;
+        };
+
+        bool running(const void *owner) const;
+        void run();
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::condition_variable m_done;
+        std::map<Key, Entry> m_tasks;
+        std::vector<Running> m_running;
+        std::vector<std::thread> m_threads;
+        uint64_t m_nextId;
+        bool m_stopping;
+        std::atomic<uint64_t> m_fired;
+};
+
+}
@@ -0,0 +1,147 @@
+#include <cstring>
+
+#include "UserDirectory.h"
+#include "FlatSet.h"
+
+namespace agora {
+
+static const size_t kInitialSlots = 16;
+
+const uint32_t UserDirectory::kEmpty;
+
+UserDirectory::UserDirectory() :
+  m_byUid(kInitialSlots, kEmpty)
+  , m_byAccount(kInitialSlots, kEmpty)
+  , m_accountSlots(0)
+{
+}
+
+size_t UserDirectory::hashUid(agora::linuxsdk::uid_t uid) {
+  //uids are often sequential; spread them over the table
+  return static_cast<size_t>(static_cast<uint32_t>(uid) * 2654435761u);
+}
+
+size_t UserDirectory::hashAccount(const char *account, size_t length) {
+  return hashBytes(account, length);
+}
+
+bool UserDirectory::sameAccount(const Entry &entry, const char *account, size_t length) const {
+  return entry.m_length == length && memcmp(&m_chars[entry.m_offset], account, length) == 0;
+}
+
+uint32_t UserDirectory::findUid(agora::linuxsdk::uid_t uid) const {
+  size_t mask = m_byUid.size() - 1;
+  for (size_t slot = hashUid(uid) & mask;; slot = (slot + 1) & mask) {
+    uint32_t index = m_byUid[slot];
+    if (index == kEmpty || m_entries[index].m_uid == uid)
+      return index;
+  }
+}
+
+size_t UserDirectory::accountSlot(const char *account, size_t length) const {
+  size_t mask = m_byAccount.size() - 1;
+  for (size_t slot = hashAccount(account, length) & mask;; slot = (slot + 1) & mask) {
+    uint32_t index = m_byAccount[slot];
+    if (index == kEmpty || sameAccount(m_entries[index], account, length))
+      return slot;
+  }
+}
+
+void UserDirectory::insertUid(uint32_t index) {
+  size_t mask = m_byUid.size() - 1;
+  size_t slot = hashUid(m_entries[index].m_uid) & mask;
+  while (m_byUid[slot] != kEmpty)
+    slot = (slot + 1) & mask;
+  m_byUid[slot] = index;
+}
+
+void UserDirectory::grow() {
+  size_t slots = m_byUid.size() * 2;
+  m_byUid.assign(slots, kEmpty);
+  m_byAccount.assign(slots, kEmpty);
+  m_accountSlots = 0;
+  for (uint32_t i = 0; i < m_entries.size(); i++) {
+    insertUid(i);
+    //later entries take over an account from earlier ones
+    const Entry &entry = m_entries[i];
+    size_t slot = accountSlot(&m_chars[entry.m_offset], entry.m_length);
+    if (m_byAccount[slot] == kEmpty)
+      m_accountSlots++;
+    m_byAccount[slot] = i;
+  }
+}
+
+void UserDirectory::release(uint32_t index) {
+  const Entry &old = m_entries[index];
+  size_t slot = accountSlot(&m_chars[old.m_offset], old.m_length);
+  if (m_byAccount[slot] != index)
+    return;
+  //hand the account to another uid that still has it; interned accounts
+  //share an offset. Otherwise the slot stays behind and stops matching once
+  //the entry changes.
+  for (size_t i = m_entries.size(); i-- > 0;) {
+    if (i != index && m_entries[i].m_offset == old.m_offset) {
+      m_byAccount[slot] = static_cast<uint32_t>(i);
+      return;
+    }
+  }
+}
+
+bool UserDirectory::update(agora::linuxsdk::uid_t uid, const char *account, size_t length) {
+  if (uid == 0 || !account || length == 0)
+    return false;
+
+  uint32_t index = findUid(uid);
+  if (index != kEmpty && sameAccount(m_entries[index], account, length))
+    return false;
+  if ((m_entries.size() + 1) * 2 > m_byUid.size() || (m_accountSlots + 1) * 2 > m_byAccount.size())
+    grow();
+
+  size_t slot = accountSlot(account, length);
+  Entry entry;
+  entry.m_uid = uid;
+  entry.m_length = static_cast<uint32_t>(length);
+  if (m_byAccount[slot] != kEmpty) {
+    entry.m_offset = m_entries[m_byAccount[slot]].m_offset;
+  } else {
+    entry.m_offset = static_cast<uint32_t>(m_chars.size());
+    m_chars.insert(m_chars.end(), account, account + length);
+    m_accountSlots++;
+  }
+
+  if (index == kEmpty) {
+    index = static_cast<uint32_t>(m_entries.size());
+    m_entries.push_back(entry);
+    insertUid(index);
+  } else {
+    release(index);
+    m_entries[index] = entry;
+  }
+  m_byAccount[slot] = index;
+  return true;
+}
+
+agora::linuxsdk::uid_t UserDirectory::uid(const char *account, size_t length) const {
+  if (!account || length == 0)
+    return 0;
+  uint32_t index = m_byAccount[accountSlot(account, length)];
+  return index != kEmpty ? m_entries[index].m_uid : 0;
+}
+
+const char* UserDirectory::account(agora::linuxsdk::uid_t uid, size_t *length) const {
+  uint32_t index = findUid(uid);
+  if (index == kEmpty)
+    return NULL;
+  *length = m_entries[index].m_length;
+  return &m_chars[m_entries[index].m_offset];
+}
+
+void UserDirectory::clear() {
+  m_entries.clear();
+  m_chars.clear();
+  m_byUid.assign(kInitialSlots, kEmpty);
+  m_byAccount.assign(kInitialSlots, kEmpty);
+  m_accountSlots = 0;
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "IAgoraLinuxSdkCommon.h"
+
+namespace agora {
+
+//uid <-> user account map for user account channels, filled from the SDK's
+//onLocalUserRegistered and onUserInfoUpdated callbacks so that lookups never
+//have to go back to the engine. Accounts are interned into one character
+//pool and each entry refers to its account by offset, so an account seen for
+//several uids is stored once. Both directions are open addressing tables of
+//entry indexes with linear probing, kept at most half full.
+//
+//Entries are never removed: the SDK keeps a uid's account for the life of the
+//channel, so the directory is only cleared between channels. An account held
+//by several uids resolves to the one that took it last.
+//Not thread safe; AgoraSdk calls it under its directory mutex.
+class UserDirectory {
+    public:
+        UserDirectory();
+
+        //False when nothing changed, or for uid 0 or an empty account.
+        bool update(agora::linuxsdk::uid_t uid, const char *account, size_t length);
+        //0 when the account is unknown.
+        agora::linuxsdk::uid_t uid(const char *account, size_t length) const;
+        //The returned account is not nul terminated and only valid until the
+        //next update(). NULL when the uid is unknown.
+        const char* account(agora::linuxsdk::uid_t uid, size_t *length) const;
+        bool contains(agora::linuxsdk::uid_t uid) const { return findUid(uid) != kEmpty; }
+        void clear();
+
+        size_t size() const { return m_entries.size(); }
+        size_t accountBytes() const { return m_chars.size(); }
+
+    private:
+        struct Entry {
+            agora::linuxsdk::uid_t m_uid;
+            uint32_t m_offset;
+            uint32_t m_length;
+        };
+
+        static const uint32_t kEmpty = 0xffffffff;
+
+        static size_t hashUid(agora::linuxsdk::uid_t uid);
+        static size_t hashAccount(const char *account, size_t length);
+        bool sameAccount(const Entry &entry, const char *account, size_t length) const;
+        uint32_t findUid(agora::linuxsdk::uid_t uid) const;
+        //slot holding account, or the empty slot it would go in
+        size_t accountSlot(const char *account, size_t length) const;
+        void insertUid(uint32_t index);
+        //entry index is about to change account
+        void release(uint32_t index);
+        void grow();
+
+        std::vector<Entry> m_entries;
+        std::vector<char> m_chars;
+        //entry indexes, kEmpty for a free slot; both sized to a power of two
+        std::vector<uint32_t> m_byUid;
+        std::vector<uint32_t> m_byAccount;
+        //m_byAccount slots in use, counting those left behind by remaps
+        size_t m_accountSlots;
+};
+
+}
@@ -0,0 +1,355 @@
+use std::cell::UnsafeCell;
+use std::future::Future;
+use std::pin::Pin;
+use std::ptr;
+use std::sync::atomic::{AtomicBool, AtomicPtr, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+use std::task::{Context, Poll, Waker};
+
+use futures_core::Stream;
+
+use crate::frame::{AudioFrame, OwnedAudioFrame, OwnedVideoFrame, VideoFrame};
+use crate::handler::RecorderEvent;
+use crate::Listener;
+
+/// A listener callback, owned so it can be consumed from any task.
+#[derive(Clone)]
+pub enum Event {
+    Error { error: u32, stat_code: u32 },
+    ChannelJoined { channel: String, uid: u32 },
+    UserJoined { uid: u32 },
+    UserLeft { uid: u32 },
+    VideoFrame { uid: u32, frame: OwnedVideoFrame },
+    AudioFrame { uid: u32, frame: OwnedAudioFrame },
+    /// Handler callbacks without a variant of their own above.
+    Recorder(RecorderEvent),
+}
+
+/// Why a `Joined` future resolved without a channel.
+#[derive(PartialEq, Debug, Clone, Copy)]
+pub enum JoinError {
+    /// The engine reported an error before the join succeeded.
+    Failed { error: u32, stat_code: u32 },
+    /// The recorder was dropped first.
+    Closed,
+}
+
+struct Node {
+    next: AtomicPtr<Node>,
+    event: Option<Event>,
+}
+
+// Unbounded multi-producer/single-consumer linked queue (Vyukov). Producers
+// only swap `head`; the consumer owns `tail`, which always points at the last
+// node it took, so there is no lock on either side.
+struct Queue {
+    head: AtomicPtr<Node>,
+    tail: UnsafeCell<*mut Node>,
+}
+
+impl Queue {
+    fn new() -> Self {
+        let stub = Box::into_raw(Box::new(Node {
+            next: AtomicPtr::new(ptr::null_mut()),
+            event: None,
+        }));
+        Queue {
+            head: AtomicPtr::new(stub),
+            tail: UnsafeCell::new(stub),
+        }
+    }
+
+    fn push(&self, event: Event) {
+        let node = Box::into_raw(Box::new(Node {
+            next: AtomicPtr::new(ptr::null_mut()),
+            event: Some(event),
+        }));
+        let prev = self.head.swap(node, Ordering::AcqRel);
+        unsafe { (*prev).next.store(node, Ordering::Release) };
+    }
+
+    // Only called by the single consumer. A producer caught between its swap
+    // and its store looks like an empty queue; it wakes the consumer after.
+    unsafe fn pop(&self) -> Option<Event> {
+        let tail = *self.tail.get();
+        let next = (*tail).next.load(Ordering::Acquire);
+        if next.is_null() {
+            return None;
+        }
+        *self.tail.get() = next;
+        drop(Box::from_raw(tail));
+        (*next).event.take()
+    }
+}
+
+impl Drop for Queue {
+    fn drop(&mut self) {
+        unsafe {
+            while self.pop().is_some() {}
+            drop(Box::from_raw(*self.tail.get()));
+        }
+    }
+}
+
+const WAITING: usize = 0;
+const REGISTERING: usize = 1;
+const WAKING: usize = 2;
+
+// Waker slot for the one task polling the stream. Registering and waking
+// race through `state` instead of a lock; whichever side loses hands the
+// wake-up to the other.
+struct AtomicWaker {
+    state: AtomicUsize,
+    waker: UnsafeCell<Option<Waker>>,
+}
+
+impl AtomicWaker {
+    fn new() -> Self {
+        AtomicWaker {
+            state: AtomicUsize::new(WAITING),
+            waker: UnsafeCell::new(None),
+        }
+    }
+
+    fn register(&self, waker: &Waker) {
+        match self
+            .state
+            .compare_exchange(WAITING, REGISTERING, Ordering::Acquire, Ordering::Acquire)
+        {
+            Ok(_) => unsafe {
+                let slot = &mut *self.waker.get();
+                if !slot.as_ref().map_or(false, |old| old.will_wake(waker)) {
+                    *slot = Some(waker.clone());
+                }
+                if self
+                    .state
+                    .compare_exchange(REGISTERING, WAITING, Ordering::AcqRel, Ordering::Acquire)
+                    .is_err()
+                {
+                    // woken while registering
+                    let waker = slot.take();
+                    self.state.swap(WAITING, Ordering::AcqRel);
+                    if let Some(waker) = waker {
+                        waker.wake();
+                    }
+                }
+            },
+            Err(WAKING) => waker.wake_by_ref(),
+            Err(_) => {}
+        }
+    }
+
+    fn wake(&self) {
+        if self.state.fetch_or(WAKING, Ordering::AcqRel) == WAITING {
+            let waker = unsafe { (*self.waker.get()).take() };
+            self.state.fetch_and(!WAKING, Ordering::Release);
+            if let Some(waker) = waker {
+                waker.wake();
+            }
+        }
+    }
+}
+
+#[derive(Default)]
+struct JoinState {
+    outcome: Option<Result<(String, u32), JoinError>>,
+    wakers: Vec<Waker>,
+}
+
+struct Shared {
+    queue: Queue,
+    waker: AtomicWaker,
+    closed: AtomicBool,
+    // one-shot, so a plain lock keeps it simple
+    join: Mutex<JoinState>,
+}
+
+// `queue.tail` is only touched by the one EventStream, and `waker.waker` only
+// under the `state` protocol above.
+unsafe impl Send for Shared {}
+unsafe impl Sync for Shared {}
+
+impl Shared {
+    fn send(&self, event: Event) {
+        self.queue.push(event);
+        self.waker.wake();
+    }
+
+    fn settle(&self, outcome: Result<(String, u32), JoinError>) {
+        let wakers = {
+            let mut join = self.join.lock().unwrap();
+            if join.outcome.is_some() {
+                return;
+            }
+            join.outcome = Some(outcome);
+            std::mem::replace(&mut join.wakers, Vec::new())
+        };
+        for waker in wakers {
+            waker.wake();
+        }
+    }
+}
+
+/// Creates the listener half that feeds an `EventStream`. Frames are only
+/// copied into the stream when `frames` is set.
+pub(crate) fn event_channel(frames: bool) -> (EventSender, EventStream) {
+    let shared = Arc::new(Shared {
+        queue: Queue::new(),
+        waker: AtomicWaker::new(),
+        closed: AtomicBool::new(false),
+        join: Mutex::new(JoinState::default()),
+    });
+    (
+        EventSender {
+            shared: shared.clone(),
+            frames,
+        },
+        EventStream { shared },
+    )
+}
+
+pub(crate) struct EventSender {
+    shared: Arc<Shared>,
+    frames: bool,
+}
+
+impl Listener for EventSender {
+    fn error(&self, error: u32, stat_code: u32) {
+        self.shared.settle(Err(JoinError::Failed { error, stat_code }));
+        self.shared.send(Event::Error { error, stat_code });
+    }
+
+    fn joined(&mut self, uid: u32) {
+        self.shared.send(Event::UserJoined { uid });
+    }
+
+    fn left(&mut self, uid: u32) {
+        self.shared.send(Event::UserLeft { uid });
+    }
+
+    fn channel_joined(&mut self, channel: String, uid: u32) {
+        self.shared.settle(Ok((channel.clone(), uid)));
+        self.shared.send(Event::ChannelJoined { channel, uid });
+    }
+
+    fn event(&mut self, event: RecorderEvent) {
+        match event {
+            RecorderEvent::Error { .. }
+            | RecorderEvent::ChannelJoined { .. }
+            | RecorderEvent::UserJoined { .. }
+            | RecorderEvent::UserLeft { .. } => {}
+            _ => self.shared.send(Event::Recorder(event)),
+        }
+    }
+
+    // The stream keeps frames in order with the events around them, and the
+    // pooled copy is the one the stream would have made anyway.
+    fn queued_frames(&self) -> bool {
+        self.frames
+    }
+
+    fn video_frame(&mut self, uid: u32, frame: &VideoFrame) {
+        if self.frames {
+            let frame = frame.retain();
+            self.shared.send(Event::VideoFrame { uid, frame });
+        }
+    }
+
+    fn audio_frame(&mut self, uid: u32, frame: &AudioFrame) {
+        if self.frames {
+            let frame = frame.retain();
+            self.shared.send(Event::AudioFrame { uid, frame });
+        }
+    }
+}
+
+impl Drop for EventSender {
+    fn drop(&mut self) {
+        self.shared.settle(Err(JoinError::Closed));
+        self.shared.closed.store(true, Ordering::Release);
+        self.shared.waker.wake();
+    }
+}
+
+/// Events of one recorder, from [`AgoraSdk::event_stream`](crate::AgoraSdk::event_stream).
+///
+/// Events queue without bound until they are polled and come out in the
+/// order the listener would have seen them. The stream ends once the
+/// recorder is dropped and everything queued has been taken.
+pub struct EventStream {
+    shared: Arc<Shared>,
+}
+
+impl EventStream {
+    /// Next queued event without waiting.
+    pub fn try_recv(&mut self) -> Option<Event> {
+        unsafe { self.shared.queue.pop() }
+    }
+
+    /// Waits for the next event; `None` once the stream has ended.
+    pub fn recv(&mut self) -> Recv<'_> {
+        Recv { stream: self }
+    }
+
+    /// Resolves with the channel and uid once the join succeeds, or with the
+    /// first error reported before that. Independent of the stream: the
+    /// `ChannelJoined` event is still delivered there too.
+    pub fn joined(&self) -> Joined {
+        Joined {
+            shared: self.shared.clone(),
+        }
+    }
+}
+
+impl Stream for EventStream {
+    type Item = Event;
+
+    fn poll_next(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Option<Event>> {
+        let this = self.get_mut();
+        if let Some(event) = this.try_recv() {
+            return Poll::Ready(Some(event));
+        }
+        this.shared.waker.register(cx.waker());
+        // anything sent before the registration would have missed the waker
+        if let Some(event) = this.try_recv() {
+            return Poll::Ready(Some(event));
+        }
+        if this.shared.closed.load(Ordering::Acquire) {
+            return Poll::Ready(this.try_recv());
+        }
+        Poll::Pending
+    }
+}
+
+/// Future returned by [`EventStream::recv`].
+pub struct Recv<'a> {
+    stream: &'a mut EventStream,
+}
+
+impl<'a> Future for Recv<'a> {
+    type Output = Option<Event>;
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Option<Event>> {
+        Pin::new(&mut *self.get_mut().stream).poll_next(cx)
+    }
+}
+
+/// Future returned by [`EventStream::joined`].
+pub struct Joined {
+    shared: Arc<Shared>,
+}
+
+impl Future for Joined {
+    type Output = Result<(String, u32), JoinError>;
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Self::Output> {
+        let mut join = self.shared.join.lock().unwrap();
+        if let Some(ref outcome) = join.outcome {
+            return Poll::Ready(outcome.clone());
+        }
+        if !join.wakers.iter().any(|waker| waker.will_wake(cx.waker())) {
+            join.wakers.push(cx.waker().clone());
+        }
+        Poll::Pending
+    }
+}
@@ -0,0 +1,442 @@
+use std::slice;
+
+use crate::FrameBuffer;
+
+// Mirrors agora::VideoFrameView in src/cpp/agorasdk/FrameView.h.
+#[repr(C)]
+pub(crate) struct RawVideoFrame {
+    pub kind: u32,
+    pub rotation: i32,
+    pub frame_ms: u64,
+    pub frame_num: u32,
+    pub width: u32,
+    pub height: u32,
+    pub y_stride: u32,
+    pub u_stride: u32,
+    pub v_stride: u32,
+    pub buf_size: u32,
+    pub buf: *const u8,
+    pub y: *const u8,
+    pub u: *const u8,
+    pub v: *const u8,
+}
+
+#[derive(PartialEq, PartialOrd, Debug, Clone, Copy)]
+pub enum VideoFrameType {
+    Yuv = 0,
+    H264 = 1,
+    Jpg = 2,
+    H265 = 3,
+    Unknown = 4,
+}
+
+impl From<u32> for VideoFrameType {
+    fn from(orig: u32) -> Self {
+        match orig {
+            0 => return VideoFrameType::Yuv,
+            1 => return VideoFrameType::H264,
+            2 => return VideoFrameType::Jpg,
+            3 => return VideoFrameType::H265,
+            _ => return VideoFrameType::Unknown,
+        };
+    }
+}
+
+#[derive(Debug, Clone, Copy)]
+pub struct YuvPlanes<'a> {
+    pub width: u32,
+    pub height: u32,
+    pub y: &'a [u8],
+    pub u: &'a [u8],
+    pub v: &'a [u8],
+    pub y_stride: u32,
+    pub u_stride: u32,
+    pub v_stride: u32,
+}
+
+#[derive(Debug, Clone, Copy)]
+pub enum VideoFrameData<'a> {
+    Yuv(YuvPlanes<'a>),
+    H264 { frame_num: u32, data: &'a [u8] },
+    H265 { frame_num: u32, data: &'a [u8] },
+    Jpg(&'a [u8]),
+}
+
+/// A video frame as `Listener::video_frame` sees it, only valid for the duration
+/// of the call. By default it borrows the SDK's own buffers and `retain` copies
+/// it; a listener with `queued_frames` gets a view of a pooled copy, which
+/// `retain` shares instead.
+#[derive(Debug, Clone, Copy)]
+pub struct VideoFrame<'a> {
+    pub frame_ms: u64,
+    pub rotation: i32,
+    pub data: VideoFrameData<'a>,
+    pooled: Option<&'a FrameBuffer>,
+}
+
+unsafe fn bytes<'a>(ptr: *const u8, len: usize) -> &'a [u8] {
+    if ptr.is_null() || len == 0 {
+        &[]
+    } else {
+        slice::from_raw_parts(ptr, len)
+    }
+}
+
+impl<'a> VideoFrame<'a> {
+    /// Builds a view over the SDK buffers without copying them.
+    ///
+    /// # Safety
+    /// Every pointer in `raw` must stay valid for `'a`.
+    pub(crate) unsafe fn from_raw(raw: &'a RawVideoFrame) -> Option<VideoFrame<'a>> {
+        let data = match VideoFrameType::from(raw.kind) {
+            VideoFrameType::Yuv => {
+                let chroma_height = ((raw.height + 1) / 2) as usize;
+                VideoFrameData::Yuv(YuvPlanes {
+                    width: raw.width,
+                    height: raw.height,
+                    y: bytes(raw.y, raw.y_stride as usize * raw.height as usize),
+                    u: bytes(raw.u, raw.u_stride as usize * chroma_height),
+                    v: bytes(raw.v, raw.v_stride as usize * chroma_height),
+                    y_stride: raw.y_stride,
+                    u_stride: raw.u_stride,
+                    v_stride: raw.v_stride,
+                })
+            }
+            VideoFrameType::H264 => VideoFrameData::H264 {
+                frame_num: raw.frame_num,
+                data: bytes(raw.buf, raw.buf_size as usize),
+            },
+            VideoFrameType::H265 => VideoFrameData::H265 {
+                frame_num: raw.frame_num,
+                data: bytes(raw.buf, raw.buf_size as usize),
+            },
+            VideoFrameType::Jpg => VideoFrameData::Jpg(bytes(raw.buf, raw.buf_size as usize)),
+            VideoFrameType::Unknown => return None,
+        };
+        Some(VideoFrame {
+            frame_ms: raw.frame_ms,
+            rotation: raw.rotation,
+            data,
+            pooled: None,
+        })
+    }
+
+    pub fn frame_type(&self) -> VideoFrameType {
+        match self.data {
+            VideoFrameData::Yuv(_) => VideoFrameType::Yuv,
+            VideoFrameData::H264 { .. } => VideoFrameType::H264,
+            VideoFrameData::H265 { .. } => VideoFrameType::H265,
+            VideoFrameData::Jpg(_) => VideoFrameType::Jpg,
+        }
+    }
+
+    /// Keeps the frame past the callback, copying it into a pooled buffer
+    /// unless it is already in one.
+    pub fn retain(&self) -> OwnedVideoFrame {
+        if let Some(buffer) = self.pooled {
+            return self.owned(buffer.clone());
+        }
+        let buffer = match self.data {
+            VideoFrameData::Yuv(ref yuv) => FrameBuffer::gather(&[yuv.y, yuv.u, yuv.v]),
+            VideoFrameData::H264 { data, .. }
+            | VideoFrameData::H265 { data, .. }
+            | VideoFrameData::Jpg(data) => FrameBuffer::gather(&[data]),
+        };
+        self.owned(buffer)
+    }
+
+    // `buffer` must hold the payload packed the way `retain` packs it: YUV
+    // planes back to back, anything else as one block.
+    fn owned(&self, buffer: FrameBuffer) -> OwnedVideoFrame {
+        let (mut width, mut height, mut frame_num) = (0, 0, 0);
+        let mut strides = [0; 3];
+        let mut planes = [(0, 0); 3];
+        match self.data {
+            VideoFrameData::Yuv(ref yuv) => {
+                width = yuv.width;
+                height = yuv.height;
+                strides = [yuv.y_stride, yuv.u_stride, yuv.v_stride];
+                let mut offset = 0;
+                for (plane, data) in [yuv.y, yuv.u, yuv.v].iter().enumerate() {
+                    planes[plane] = (offset, data.len());
+                    offset += data.len();
+                }
+            }
+            VideoFrameData::H264 { frame_num: num, .. }
+            | VideoFrameData::H265 { frame_num: num, .. } => frame_num = num,
+            VideoFrameData::Jpg(_) => {}
+        }
+        OwnedVideoFrame {
+            frame_ms: self.frame_ms,
+            rotation: self.rotation,
+            kind: self.frame_type(),
+            frame_num,
+            width,
+            height,
+            strides,
+            planes,
+            buffer,
+        }
+    }
+}
+
+/// A video frame retained by `VideoFrame::retain`. Clones share the pooled buffer.
+#[derive(Clone)]
+pub struct OwnedVideoFrame {
+    frame_ms: u64,
+    rotation: i32,
+    kind: VideoFrameType,
+    frame_num: u32,
+    width: u32,
+    height: u32,
+    strides: [u32; 3],
+    planes: [(usize, usize); 3],
+    buffer: FrameBuffer,
+}
+
+impl OwnedVideoFrame {
+    /// Wraps a frame the C++ side already copied into `buffer`.
+    ///
+    /// # Safety
+    /// The pointers in `raw` must point into `buffer`, packed as `retain` does.
+    pub(crate) unsafe fn from_pooled(
+        raw: &RawVideoFrame,
+        buffer: FrameBuffer,
+    ) -> Option<OwnedVideoFrame> {
+        VideoFrame::from_raw(raw).map(|frame| frame.owned(buffer))
+    }
+
+    pub fn view(&self) -> VideoFrame {
+        let plane = |index: usize| {
+            let (offset, len) = self.planes[index];
+            &self.buffer[offset..offset + len]
+        };
+        let data = match self.kind {
+            VideoFrameType::Yuv => VideoFrameData::Yuv(YuvPlanes {
+                width: self.width,
+                height: self.height,
+                y: plane(0),
+                u: plane(1),
+                v: plane(2),
+                y_stride: self.strides[0],
+                u_stride: self.strides[1],
+                v_stride: self.strides[2],
+            }),
+            VideoFrameType::H264 => VideoFrameData::H264 {
+                frame_num: self.frame_num,
+                data: &self.buffer,
+            },
+            VideoFrameType::H265 => VideoFrameData::H265 {
+                frame_num: self.frame_num,
+                data: &self.buffer,
+            },
+            _ => VideoFrameData::Jpg(&self.buffer),
+        };
+        VideoFrame {
+            frame_ms: self.frame_ms,
+            rotation: self.rotation,
+            data,
+            pooled: Some(&self.buffer),
+        }
+    }
+}
+
+// Mirrors agora::AudioFrameView in src/cpp/agorasdk/FrameView.h.
+#[repr(C)]
+pub(crate) struct RawAudioFrame {
+    pub kind: u32,
+    pub channels: u32,
+    pub sample_bits: u32,
+    pub sample_rate: u32,
+    pub samples: u32,
+    pub bitrate: u32,
+    pub frame_ms: u64,
+    pub buf_size: u32,
+    pub buf: *const u8,
+}
+
+#[derive(PartialEq, PartialOrd, Debug, Clone, Copy)]
+pub enum AudioFrameType {
+    Pcm = 0,
+    Aac = 1,
+    Unknown = 2,
+}
+
+impl From<u32> for AudioFrameType {
+    fn from(orig: u32) -> Self {
+        match orig {
+            0 => return AudioFrameType::Pcm,
+            1 => return AudioFrameType::Aac,
+            _ => return AudioFrameType::Unknown,
+        };
+    }
+}
+
+#[derive(Debug, Clone, Copy)]
+pub enum AudioFrameData<'a> {
+    Pcm {
+        sample_bits: u32,
+        sample_rate: u32,
+        samples: u32,
+        data: &'a [u8],
+    },
+    Aac {
+        bitrate: u32,
+        data: &'a [u8],
+    },
+}
+
+/// An audio frame as `Listener::audio_frame` sees it, only valid for the duration
+/// of the call. By default it borrows the SDK's own buffer and `retain` copies
+/// it; a listener with `queued_frames` gets a view of a pooled copy, which
+/// `retain` shares instead.
+#[derive(Debug, Clone, Copy)]
+pub struct AudioFrame<'a> {
+    pub frame_ms: u64,
+    pub channels: u32,
+    pub data: AudioFrameData<'a>,
+    pooled: Option<&'a FrameBuffer>,
+}
+
+impl<'a> AudioFrame<'a> {
+    /// Builds a view over the SDK buffer without copying it.
+    ///
+    /// # Safety
+    /// The buffer pointer in `raw` must stay valid for `'a`.
+    pub(crate) unsafe fn from_raw(raw: &'a RawAudioFrame) -> Option<AudioFrame<'a>> {
+        let buf = bytes(raw.buf, raw.buf_size as usize);
+        let data = match AudioFrameType::from(raw.kind) {
+            AudioFrameType::Pcm => AudioFrameData::Pcm {
+                sample_bits: raw.sample_bits,
+                sample_rate: raw.sample_rate,
+                samples: raw.samples,
+                data: buf,
+            },
+            AudioFrameType::Aac => AudioFrameData::Aac {
+                bitrate: raw.bitrate,
+                data: buf,
+            },
+            AudioFrameType::Unknown => return None,
+        };
+        Some(AudioFrame {
+            frame_ms: raw.frame_ms,
+            channels: raw.channels,
+            data,
+            pooled: None,
+        })
+    }
+
+    pub fn frame_type(&self) -> AudioFrameType {
+        match self.data {
+            AudioFrameData::Pcm { .. } => AudioFrameType::Pcm,
+            AudioFrameData::Aac { .. } => AudioFrameType::Aac,
+        }
+    }
+
+    pub fn bytes(&self) -> &'a [u8] {
+        match self.data {
+            AudioFrameData::Pcm { data, .. } | AudioFrameData::Aac { data, .. } => data,
+        }
+    }
+
+    /// Keeps the frame past the callback, copying it into a pooled buffer
+    /// unless it is already in one.
+    pub fn retain(&self) -> OwnedAudioFrame {
+        let buffer = match self.pooled {
+            Some(buffer) => buffer.clone(),
+            None => FrameBuffer::gather(&[self.bytes()]),
+        };
+        OwnedAudioFrame {
+            frame: AudioFrameMeta::from(self),
+            buffer,
+        }
+    }
+}
+
+#[derive(Debug, Clone, Copy, Default)]
+pub(crate) struct AudioFrameMeta {
+    pub kind: u32,
+    pub frame_ms: u64,
+    pub channels: u32,
+    pub sample_bits: u32,
+    pub sample_rate: u32,
+    pub samples: u32,
+    pub bitrate: u32,
+}
+
+impl<'a> From<&AudioFrame<'a>> for AudioFrameMeta {
+    fn from(frame: &AudioFrame<'a>) -> Self {
+        let mut meta = AudioFrameMeta {
+            kind: frame.frame_type() as u32,
+            frame_ms: frame.frame_ms,
+            channels: frame.channels,
+            ..Default::default()
+        };
+        match frame.data {
+            AudioFrameData::Pcm {
+                sample_bits,
+                sample_rate,
+                samples,
+                ..
+            } => {
+                meta.sample_bits = sample_bits;
+                meta.sample_rate = sample_rate;
+                meta.samples = samples;
+            }
+            AudioFrameData::Aac { bitrate, .. } => meta.bitrate = bitrate,
+        }
+        meta
+    }
+}
+
+impl AudioFrameMeta {
+    pub fn view<'a>(&self, data: &'a [u8]) -> AudioFrame<'a> {
+        let data = match AudioFrameType::from(self.kind) {
+            AudioFrameType::Aac => AudioFrameData::Aac {
+                bitrate: self.bitrate,
+                data,
+            },
+            _ => AudioFrameData::Pcm {
+                sample_bits: self.sample_bits,
+                sample_rate: self.sample_rate,
+                samples: self.samples,
+                data,
+            },
+        };
+        AudioFrame {
+            frame_ms: self.frame_ms,
+            channels: self.channels,
+            data,
+            pooled: None,
+        }
+    }
+}
+
+/// An audio frame retained by `AudioFrame::retain`. Clones share the pooled buffer.
+#[derive(Clone)]
+pub struct OwnedAudioFrame {
+    frame: AudioFrameMeta,
+    buffer: FrameBuffer,
+}
+
+impl OwnedAudioFrame {
+    /// Wraps a frame the C++ side already copied into `buffer`.
+    ///
+    /// # Safety
+    /// The buffer pointer in `raw` must point into `buffer`.
+    pub(crate) unsafe fn from_pooled(
+        raw: &RawAudioFrame,
+        buffer: FrameBuffer,
+    ) -> Option<OwnedAudioFrame> {
+        AudioFrame::from_raw(raw).map(|frame| OwnedAudioFrame {
+            frame: AudioFrameMeta::from(&frame),
+            buffer,
+        })
+    }
+
+    pub fn view(&self) -> AudioFrame {
+        let mut frame = self.frame.view(&self.buffer);
+        frame.pooled = Some(&self.buffer);
+        frame
+    }
+}
@@ -0,0 +1,283 @@
+use std::fmt;
+use std::ops::Deref;
+use std::str;
+
+const HANDLER_EVENT_ERROR: u32 = 0;
+const HANDLER_EVENT_JOIN_CHANNEL_SUCCESS: u32 = 1;
+const HANDLER_EVENT_USER_JOINED: u32 = 2;
+const HANDLER_EVENT_USER_OFFLINE: u32 = 3;
+const HANDLER_EVENT_WARNING: u32 = 7;
+const HANDLER_EVENT_LEAVE_CHANNEL: u32 = 8;
+const HANDLER_EVENT_REMOTE_VIDEO_STREAM_STATE: u32 = 9;
+const HANDLER_EVENT_REMOTE_AUDIO_STREAM_STATE: u32 = 10;
+const HANDLER_EVENT_ACTIVE_SPEAKER: u32 = 11;
+const HANDLER_EVENT_FIRST_REMOTE_VIDEO_DECODED: u32 = 12;
+const HANDLER_EVENT_FIRST_REMOTE_AUDIO_FRAME: u32 = 13;
+const HANDLER_EVENT_RECEIVING_STREAM_STATUS: u32 = 14;
+const HANDLER_EVENT_CONNECTION_LOST: u32 = 15;
+const HANDLER_EVENT_CONNECTION_INTERRUPTED: u32 = 16;
+const HANDLER_EVENT_REJOIN_CHANNEL_SUCCESS: u32 = 17;
+const HANDLER_EVENT_CONNECTION_STATE_CHANGED: u32 = 18;
+const HANDLER_EVENT_LOCAL_USER_REGISTERED: u32 = 19;
+const HANDLER_EVENT_USER_INFO_UPDATED: u32 = 20;
+
+// agora::linuxsdk::MAX_USER_ACCOUNT_LENGTH, the largest member of the payload.
+const MAX_NAME_LENGTH: usize = 256;
+
+// Mirrors the union in agora::HandlerEvent, minus the frame views, which
+// never take this path and are smaller than the account.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub(crate) union RawEventPayload {
+    values: [i32; 3],
+    name: [u8; MAX_NAME_LENGTH],
+    _batch: *mut u32,
+}
+
+// Mirrors agora::HandlerEvent in src/cpp/agorasdk/EventExecutor.h.
+#[repr(C)]
+pub(crate) struct RawHandlerEvent {
+    kind: u32,
+    uid: u32,
+    _buffer: *mut u32,
+    payload: RawEventPayload,
+}
+
+/// A channel name or user account carried inline, so events stay `Copy`.
+#[derive(Clone, Copy)]
+pub struct EventName {
+    len: u16,
+    bytes: [u8; MAX_NAME_LENGTH],
+}
+
+impl EventName {
+    // Up to the first NUL, and only as much of that as is valid UTF-8.
+    fn from_bytes(bytes: &[u8; MAX_NAME_LENGTH]) -> Self {
+        let end = bytes.iter().position(|&b| b == 0).unwrap_or(MAX_NAME_LENGTH);
+        let len = match str::from_utf8(&bytes[..end]) {
+            Ok(_) => end,
+            Err(err) => err.valid_up_to(),
+        };
+        EventName {
+            len: len as u16,
+            bytes: *bytes,
+        }
+    }
+
+    pub fn as_str(&self) -> &str {
+        unsafe { str::from_utf8_unchecked(&self.bytes[..self.len as usize]) }
+    }
+}
+
+impl Deref for EventName {
+    type Target = str;
+
+    fn deref(&self) -> &str {
+        self.as_str()
+    }
+}
+
+impl PartialEq for EventName {
+    fn eq(&self, other: &Self) -> bool {
+        self.as_str() == other.as_str()
+    }
+}
+
+impl fmt::Debug for EventName {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        fmt::Debug::fmt(self.as_str(), f)
+    }
+}
+
+impl fmt::Display for EventName {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.write_str(self.as_str())
+    }
+}
+
+#[derive(PartialEq, PartialOrd, Debug, Clone, Copy)]
+pub enum UserOfflineReason {
+    Quit = 0,
+    Dropped = 1,
+    BecomeAudience = 2,
+    Unknown = 3,
+}
+
+impl From<u32> for UserOfflineReason {
+    fn from(orig: u32) -> Self {
+        match orig {
+            0 => return UserOfflineReason::Quit,
+            1 => return UserOfflineReason::Dropped,
+            2 => return UserOfflineReason::BecomeAudience,
+            _ => return UserOfflineReason::Unknown,
+        };
+    }
+}
+
+#[derive(PartialEq, PartialOrd, Debug, Clone, Copy)]
+pub enum RemoteStreamState {
+    Running = 0,
+    Stopped = 1,
+    Unknown = 2,
+}
+
+impl From<u32> for RemoteStreamState {
+    fn from(orig: u32) -> Self {
+        match orig {
+            0 => return RemoteStreamState::Running,
+            1 => return RemoteStreamState::Stopped,
+            _ => return RemoteStreamState::Unknown,
+        };
+    }
+}
+
+#[derive(PartialEq, PartialOrd, Debug, Clone, Copy)]
+pub enum RemoteStreamReason {
+    Started = 0,
+    Stopped = 1,
+    Unknown = 2,
+}
+
+impl From<u32> for RemoteStreamReason {
+    fn from(orig: u32) -> Self {
+        match orig {
+            0 => return RemoteStreamReason::Started,
+            1 => return RemoteStreamReason::Stopped,
+            _ => return RemoteStreamReason::Unknown,
+        };
+    }
+}
+
+#[derive(PartialEq, PartialOrd, Debug, Clone, Copy)]
+pub enum ConnectionState {
+    Disconnected = 1,
+    Connecting = 2,
+    Connected = 3,
+    Reconnecting = 4,
+    Failed = 5,
+    Unknown = 6,
+}
+
+impl From<u32> for ConnectionState {
+    fn from(orig: u32) -> Self {
+        match orig {
+            1 => return ConnectionState::Disconnected,
+            2 => return ConnectionState::Connecting,
+            3 => return ConnectionState::Connected,
+            4 => return ConnectionState::Reconnecting,
+            5 => return ConnectionState::Failed,
+            _ => return ConnectionState::Unknown,
+        };
+    }
+}
+
+#[derive(PartialEq, PartialOrd, Debug, Clone, Copy)]
+pub enum ConnectionChangedReason {
+    Connecting = 0,
+    JoinSuccess = 1,
+    Interrupted = 2,
+    BannedByServer = 3,
+    JoinFailed = 4,
+    LeaveChannel = 5,
+    Unknown = 6,
+}
+
+impl From<u32> for ConnectionChangedReason {
+    fn from(orig: u32) -> Self {
+        match orig {
+            0 => return ConnectionChangedReason::Connecting,
+            1 => return ConnectionChangedReason::JoinSuccess,
+            2 => return ConnectionChangedReason::Interrupted,
+            3 => return ConnectionChangedReason::BannedByServer,
+            4 => return ConnectionChangedReason::JoinFailed,
+            5 => return ConnectionChangedReason::LeaveChannel,
+            _ => return ConnectionChangedReason::Unknown,
+        };
+    }
+}
+
+/// Every `IRecordingEngineEventHandler` callback except frames, which go to
+/// `Listener::video_frame`/`audio_frame`, and volume and stats, which are
+/// batched into `Listener::stats_batch`. Fixed size and `Copy`; nothing in
+/// it is allocated.
+#[derive(PartialEq, Debug, Clone, Copy)]
+pub enum RecorderEvent {
+    Error { error: u32, stat_code: u32 },
+    Warning { warning: i32 },
+    ChannelJoined { channel: EventName, uid: u32 },
+    ChannelRejoined { channel: EventName, uid: u32 },
+    /// `code` is the SDK's LEAVE_PATH_CODE bit set.
+    ChannelLeft { code: u32 },
+    UserJoined { uid: u32 },
+    UserLeft { uid: u32, reason: UserOfflineReason },
+    RemoteVideoStreamState { uid: u32, state: RemoteStreamState, reason: RemoteStreamReason },
+    RemoteAudioStreamState { uid: u32, state: RemoteStreamState, reason: RemoteStreamReason },
+    ActiveSpeaker { uid: u32 },
+    FirstRemoteVideoDecoded { uid: u32, width: u32, height: u32, elapsed_ms: u32 },
+    FirstRemoteAudioFrame { uid: u32, elapsed_ms: u32 },
+    ReceivingStreamStatus { audio: bool, video: bool },
+    ConnectionLost,
+    ConnectionInterrupted,
+    ConnectionStateChanged { state: ConnectionState, reason: ConnectionChangedReason },
+    LocalUserRegistered { uid: u32, account: EventName },
+    UserInfoUpdated { uid: u32, account: EventName },
+}
+
+impl RecorderEvent {
+    /// `None` for the kinds that are not delivered as a `RecorderEvent`.
+    pub(crate) fn from_raw(raw: &RawHandlerEvent) -> Option<RecorderEvent> {
+        let uid = raw.uid;
+        let values = unsafe { raw.payload.values };
+        let name = || EventName::from_bytes(unsafe { &raw.payload.name });
+        let event = match raw.kind {
+            HANDLER_EVENT_ERROR => RecorderEvent::Error {
+                error: values[0] as u32,
+                stat_code: values[1] as u32,
+            },
+            HANDLER_EVENT_WARNING => RecorderEvent::Warning { warning: values[0] },
+            HANDLER_EVENT_JOIN_CHANNEL_SUCCESS => RecorderEvent::ChannelJoined { channel: name(), uid },
+            HANDLER_EVENT_REJOIN_CHANNEL_SUCCESS => RecorderEvent::ChannelRejoined { channel: name(), uid },
+            HANDLER_EVENT_LEAVE_CHANNEL => RecorderEvent::ChannelLeft { code: values[0] as u32 },
+            HANDLER_EVENT_USER_JOINED => RecorderEvent::UserJoined { uid },
+            HANDLER_EVENT_USER_OFFLINE => RecorderEvent::UserLeft {
+                uid,
+                reason: UserOfflineReason::from(values[0] as u32),
+            },
+            HANDLER_EVENT_REMOTE_VIDEO_STREAM_STATE => RecorderEvent::RemoteVideoStreamState {
+                uid,
+                state: RemoteStreamState::from(values[0] as u32),
+                reason: RemoteStreamReason::from(values[1] as u32),
+            },
+            HANDLER_EVENT_REMOTE_AUDIO_STREAM_STATE => RecorderEvent::RemoteAudioStreamState {
+                uid,
+                state: RemoteStreamState::from(values[0] as u32),
+                reason: RemoteStreamReason::from(values[1] as u32),
+            },
+            HANDLER_EVENT_ACTIVE_SPEAKER => RecorderEvent::ActiveSpeaker { uid },
+            HANDLER_EVENT_FIRST_REMOTE_VIDEO_DECODED => RecorderEvent::FirstRemoteVideoDecoded {
+                uid,
+                width: values[0] as u32,
+                height: values[1] as u32,
+                elapsed_ms: values[2] as u32,
+            },
+            HANDLER_EVENT_FIRST_REMOTE_AUDIO_FRAME => RecorderEvent::FirstRemoteAudioFrame {
+                uid,
+                elapsed_ms: values[2] as u32,
+            },
+            HANDLER_EVENT_RECEIVING_STREAM_STATUS => RecorderEvent::ReceivingStreamStatus {
+                audio: values[0] != 0,
+                video: values[1] != 0,
+            },
+            HANDLER_EVENT_CONNECTION_LOST => RecorderEvent::ConnectionLost,
+            HANDLER_EVENT_CONNECTION_INTERRUPTED => RecorderEvent::ConnectionInterrupted,
+            HANDLER_EVENT_CONNECTION_STATE_CHANGED => RecorderEvent::ConnectionStateChanged {
+                state: ConnectionState::from(values[0] as u32),
+                reason: ConnectionChangedReason::from(values[1] as u32),
+            },
+            HANDLER_EVENT_LOCAL_USER_REGISTERED => RecorderEvent::LocalUserRegistered { uid, account: name() },
+            HANDLER_EVENT_USER_INFO_UPDATED => RecorderEvent::UserInfoUpdated { uid, account: name() },
+            _ => return None,
+        };
+        Some(event)
+    }
+}
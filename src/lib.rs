@@ -3,11 +3,38 @@ use cpp::cpp;
 use cpp::cpp_class;
 use std::env;
 use std::ffi::{CStr, CString};
+use std::ops::Deref;
 use std::os::raw::c_char;
+use std::time::Duration;
+use std::{mem, ptr, slice};
+
+mod events;
+mod frame;
+mod handler;
+mod spsc;
+mod stats;
+pub use events::{Event, EventStream, JoinError, Joined, Recv};
+pub use frame::{
+    AudioFrame, AudioFrameData, AudioFrameType, OwnedAudioFrame, OwnedVideoFrame, VideoFrame,
+    VideoFrameData, VideoFrameType, YuvPlanes,
+};
+use frame::{RawAudioFrame, RawVideoFrame};
+use handler::RawHandlerEvent;
+pub use handler::{
+    ConnectionChangedReason, ConnectionState, EventName, RecorderEvent, RemoteStreamReason,
+    RemoteStreamState, UserOfflineReason,
+};
+pub use spsc::{audio_frame_channel, AudioFrameConsumer, AudioFrameProducer, QueuedAudioFrame};
+use stats::RawStatsBatch;
+pub use stats::{RecordingColumns, RemoteAudioColumns, RemoteVideoColumns, StatsBatch, VolumeColumns};
 
 cpp! {{
     #include <iostream>
     #include "src/cpp/agorasdk/AgoraSdk.h"
+    #include "src/cpp/agorasdk/StubRecordingEngine.h"
+    #include "src/cpp/agorasdk/RecorderManager.h"
+    #include "src/cpp/agorasdk/AllocCounters.h"
+    #include "src/cpp/agorasdk/MembershipBench.h"
     using std::string;
 }}
 
@@ -95,6 +122,112 @@ impl From<u32> for ChannelProfile {
     }
 }
 
+#[derive(PartialEq, PartialOrd, Debug)]
+pub enum VideoFormat {
+    Default = 0,
+    EncodedFrame = 1,
+    YuvFrame = 2,
+    JpgFrame = 3,
+    JpgFile = 4,
+    JpgVideoFile = 5,
+    Unknown = 6,
+}
+
+impl VideoFormat {
+    fn value(&self) -> u32 {
+        match *self {
+            VideoFormat::Default => 0,
+            VideoFormat::EncodedFrame => 1,
+            VideoFormat::YuvFrame => 2,
+            VideoFormat::JpgFrame => 3,
+            VideoFormat::JpgFile => 4,
+            VideoFormat::JpgVideoFile => 5,
+            VideoFormat::Unknown => 6,
+        }
+    }
+}
+
+impl From<u32> for VideoFormat {
+    fn from(orig: u32) -> Self {
+        match orig {
+            0 => return VideoFormat::Default,
+            1 => return VideoFormat::EncodedFrame,
+            2 => return VideoFormat::YuvFrame,
+            3 => return VideoFormat::JpgFrame,
+            4 => return VideoFormat::JpgFile,
+            5 => return VideoFormat::JpgVideoFile,
+            _ => return VideoFormat::Unknown,
+        };
+    }
+}
+
+#[derive(PartialEq, PartialOrd, Debug, Clone, Copy)]
+pub enum LayoutMode {
+    Default = 0,
+    BestFit = 1,
+    VerticalPresentation = 2,
+    /// Vertical presentation with the dominant speaker in the large tile.
+    ActiveSpeaker = 3,
+    Unknown = 4,
+}
+
+impl LayoutMode {
+    fn value(&self) -> u32 {
+        match *self {
+            LayoutMode::Default => 0,
+            LayoutMode::BestFit => 1,
+            LayoutMode::VerticalPresentation => 2,
+            LayoutMode::ActiveSpeaker => 3,
+            LayoutMode::Unknown => 4,
+        }
+    }
+}
+
+impl From<u32> for LayoutMode {
+    fn from(orig: u32) -> Self {
+        match orig {
+            0 => return LayoutMode::Default,
+            1 => return LayoutMode::BestFit,
+            2 => return LayoutMode::VerticalPresentation,
+            3 => return LayoutMode::ActiveSpeaker,
+            _ => return LayoutMode::Unknown,
+        };
+    }
+}
+
+#[derive(PartialEq, PartialOrd, Debug)]
+pub enum AudioFormat {
+    Default = 0,
+    AacFrame = 1,
+    PcmFrame = 2,
+    MixedPcmFrame = 3,
+    Unknown = 4,
+}
+
+impl AudioFormat {
+    fn value(&self) -> u32 {
+        match *self {
+            AudioFormat::Default => 0,
+            AudioFormat::AacFrame => 1,
+            AudioFormat::PcmFrame => 2,
+            AudioFormat::MixedPcmFrame => 3,
+            AudioFormat::Unknown => 4,
+        }
+    }
+}
+
+impl From<u32> for AudioFormat {
+    fn from(orig: u32) -> Self {
+        match orig {
+            0 => return AudioFormat::Default,
+            1 => return AudioFormat::AacFrame,
+            2 => return AudioFormat::PcmFrame,
+            3 => return AudioFormat::MixedPcmFrame,
+            _ => return AudioFormat::Unknown,
+        };
+    }
+}
+
 cpp_class!(pub unsafe struct Config as "agora::recording::RecordingConfig");
 impl Config {
     pub fn new() -> Self {
@@ -262,6 +395,42 @@ impl Config {
         (vec[0], vec[1], vec[2], vec[3])
     }
 
+    pub fn set_decode_video(&self, format: VideoFormat) {
+        let format = format.value();
+        unsafe {
+            cpp!([  self as "agora::recording::RecordingConfig*",
+                    format as "agora::linuxsdk::VIDEO_FORMAT_TYPE"] {
+                self->decodeVideo = format;
+            })
+        }
+    }
+
+    pub fn decode_video(&self) -> VideoFormat {
+        unsafe {
+            cpp!([self as "agora::recording::RecordingConfig*"] -> u32 as "agora::linuxsdk::VIDEO_FORMAT_TYPE" {
+                return self->decodeVideo;
+            })
+        }.into()
+    }
+
+    pub fn set_decode_audio(&self, format: AudioFormat) {
+        let format = format.value();
+        unsafe {
+            cpp!([  self as "agora::recording::RecordingConfig*",
+                    format as "agora::linuxsdk::AUDIO_FORMAT_TYPE"] {
+                self->decodeAudio = format;
+            })
+        }
+    }
+
+    pub fn decode_audio(&self) -> AudioFormat {
+        unsafe {
+            cpp!([self as "agora::recording::RecordingConfig*"] -> u32 as "agora::linuxsdk::AUDIO_FORMAT_TYPE" {
+                return self->decodeAudio;
+            })
+        }.into()
+    }
+
     pub fn set_audio_indication_interval(&self, interval: u32) {
         unsafe {
             cpp!([  self as "agora::recording::RecordingConfig*",
@@ -271,6 +440,40 @@ impl Config {
         }
     }
 
+    /// Comma separated uids (or accounts) to receive video from when auto
+    /// subscribe is off.
+    pub fn set_subscribe_video_uids(&self, uids: &str) {
+        let uids = CString::new(uids).unwrap().into_raw();
+        unsafe {
+            cpp!([  self as "agora::recording::RecordingConfig*",
+                    uids as "const char *"] {
+                self->subscribeVideoUids = uids;
+            })
+        }
+    }
+
+    pub fn set_subscribe_audio_uids(&self, uids: &str) {
+        let uids = CString::new(uids).unwrap().into_raw();
+        unsafe {
+            cpp!([  self as "agora::recording::RecordingConfig*",
+                    uids as "const char *"] {
+                self->subscribeAudioUids = uids;
+            })
+        }
+    }
+
+    /// With auto subscribe off, only the uids in the subscribe lists (and
+    /// those added later through `IAgoraSdk::add_subscribed_uids`) are
+    /// received.
+    pub fn set_auto_subscribe(&self, auto_subscribe: bool) {
+        unsafe {
+            cpp!([  self as "agora::recording::RecordingConfig*",
+                    auto_subscribe as "bool"] {
+                self->autoSubscribe = auto_subscribe;
+            })
+        }
+    }
+
     pub fn audio_indication_interval(&self) -> u32 {
         unsafe {
             cpp!([self as "agora::recording::RecordingConfig*"] -> u32 as "int" {
@@ -493,353 +696,2239 @@ impl Layout {
     }
 }
 
-pub trait CallbackTrait {
-    fn on_error(&mut self, error: u32, stat_code: u32);
-    fn on_user_joined(&mut self, uid: u32);
-    fn on_user_left(&mut self, uid: u32);
-    fn on_channel_join_success(&mut self, channel: &str, uid: u32);
+/// A refcounted slab from the shared C++ frame pool. Cloning shares the slab and
+/// the last handle to drop returns it to the pool.
+#[derive(Debug)]
+pub struct FrameBuffer {
+    raw: *mut u32,
+    data: *const u8,
+    len: usize,
 }
 
-cpp! {{
-    struct CallbackPtr { void *a, *b; };
-    class AgoraSdkEvents :  virtual public agora::recording::IRecordingEngineEventHandler {
-        public:
-        CallbackPtr callback;
-        protected:
-        virtual void onError(int error, agora::linuxsdk::STAT_CODE_TYPE stat_code) {
-            //sdk->stoppedOnError();
-            rust!(OnErrorImpl [callback : &mut dyn CallbackTrait as "CallbackPtr", error: u32 as "int", stat_code : u32 as "int"] {
-                callback.on_error(error, stat_code)
-            });
-        }
-        virtual void onWarning(int warn) {
-            (void)warn;
-        }
-        virtual void onJoinChannelSuccess(const char * channelId, agora::linuxsdk::uid_t uid) {
-            rust!(OnJoinChannelSuccessImpl [callback : &mut dyn CallbackTrait as "CallbackPtr", channelId: *const i8 as "const char*", uid : u32 as "int"] {
-                let channelId = unsafe {CStr::from_ptr(channelId)};
-                callback.on_channel_join_success(channelId.to_str().unwrap_or(""), uid)
-            });
-        }
-        virtual void onLeaveChannel(agora::linuxsdk::LEAVE_PATH_CODE code) {
-            (void)code;
-        }
-        virtual void onUserJoined(agora::linuxsdk::uid_t uid, agora::linuxsdk::UserJoinInfos &infos) {
-            (void)infos;
-            rust!(OnUserJoinedImpl [callback : &mut dyn CallbackTrait as "CallbackPtr", uid: u32 as "int"] {
-                callback.on_user_joined(uid)
-            });
-        }
-        virtual void onRemoteVideoStreamStateChanged(agora::linuxsdk::uid_t uid, agora::linuxsdk::RemoteStreamState state, agora::linuxsdk::RemoteStreamStateChangedReason reason) {
-            (void)uid;
-            (void)state;
-            (void)reason;
-        }
-        virtual void onRemoteAudioStreamStateChanged(agora::linuxsdk::uid_t uid, agora::linuxsdk::RemoteStreamState state, agora::linuxsdk::RemoteStreamStateChangedReason reason) {
-            (void)uid;
-            (void)state;
-            (void)reason;
-        }
-        virtual void onUserOffline(agora::linuxsdk::uid_t uid, agora::linuxsdk::USER_OFFLINE_REASON_TYPE reason) {
-            (void)reason;
-            rust!(OnUserOfflineImpl [callback : &mut dyn CallbackTrait as "CallbackPtr", uid: u32 as "int"] {
-                callback.on_user_left(uid)
-            });
-        }
-        virtual void audioFrameReceived(unsigned int uid, const agora::linuxsdk::AudioFrame *frame) const {
-            (void)uid;
-            (void)frame;
-        }
-        virtual void videoFrameReceived(unsigned int uid, const agora::linuxsdk::VideoFrame *frame) const {
-            (void)uid;
-            (void)frame;
-        }
-        virtual void onActiveSpeaker(uid_t uid) {
-            (void)uid;
-        }
-        virtual void onAudioVolumeIndication(const agora::linuxsdk::AudioVolumeInfo* speakers, unsigned int speakerNum) {
-            (void)speakers;
-            (void)speakerNum;
-        }
-        virtual void onFirstRemoteVideoDecoded(uid_t uid, int width, int height, int elapsed) {
-            (void)uid;
-            (void)width;
-            (void)height;
-            (void)elapsed;
-        }
-        virtual void onFirstRemoteAudioFrame(uid_t uid, int elapsed) {
-            (void)uid;
-            (void)elapsed;
-        }
-        virtual void onReceivingStreamStatusChanged(bool receivingAudio, bool receivingVideo) {
-            (void)receivingAudio;
-            (void)receivingVideo;
-        }
-        virtual void onConnectionLost() {}
-        virtual void onConnectionInterrupted() {}
-        virtual void onRejoinChannelSuccess(const char* channelId, uid_t uid) {
-            (void)channelId;
-            (void)uid;
-        }
-        virtual void onConnectionStateChanged(agora::linuxsdk::ConnectionStateType state, agora::linuxsdk::ConnectionChangedReasonType reason){
-            (void)state;
-            (void)reason;
-        }
-        virtual void onRecordingStats(const agora::linuxsdk::RecordingStats& stats){
-            (void)stats;
-        }
-        virtual void onRemoteVideoStats(uid_t uid, const agora::linuxsdk::RemoteVideoStats& stats){
-            (void)uid;
-            (void)stats;
+unsafe impl Send for FrameBuffer {}
+unsafe impl Sync for FrameBuffer {}
+
+impl FrameBuffer {
+    /// Copies `parts` back to back into one pooled slab.
+    pub fn gather(parts: &[&[u8]]) -> Self {
+        let len: usize = parts.iter().map(|part| part.len()).sum();
+        let buffer = unsafe {
+            FrameBuffer::from_raw(cpp!([len as "size_t"] -> *mut u32 as "agora::FrameBuffer*" {
+                return agora::FramePool::shared()->acquire(len);
+            }))
+        };
+        let mut offset = 0;
+        for part in parts {
+            unsafe {
+                ptr::copy_nonoverlapping(part.as_ptr(), buffer.data.add(offset) as *mut u8, part.len())
+            };
+            offset += part.len();
         }
-        virtual void onRemoteAudioStats(uid_t uid, const agora::linuxsdk::RemoteAudioStats& stats){
-            (void)uid;
-            (void)stats;
+        buffer
+    }
+
+    /// Takes over one reference to a C++ `agora::FrameBuffer`.
+    pub(crate) unsafe fn from_raw(raw: *mut u32) -> Self {
+        let data = cpp!([raw as "agora::FrameBuffer*"] -> *mut u8 as "unsigned char*" {
+            return raw->data();
+        });
+        let len = cpp!([raw as "agora::FrameBuffer*"] -> usize as "size_t" {
+            return raw->size();
+        });
+        FrameBuffer { raw, data, len }
+    }
+
+    /// A handle to `len` bytes at `offset` sharing this buffer's slab.
+    pub(crate) fn slice(&self, offset: usize, len: usize) -> Self {
+        assert!(offset + len <= self.len);
+        let mut buffer = self.clone();
+        buffer.data = unsafe { buffer.data.add(offset) };
+        buffer.len = len;
+        buffer
+    }
+
+    pub fn as_slice(&self) -> &[u8] {
+        if self.len == 0 {
+            return &[];
         }
-        virtual void onLocalUserRegistered(uid_t uid, const char* userAccount){
-            (void)uid;
-            (void)userAccount;
+        unsafe { slice::from_raw_parts(self.data, self.len) }
+    }
+}
+
+impl Deref for FrameBuffer {
+    type Target = [u8];
+
+    fn deref(&self) -> &[u8] {
+        self.as_slice()
+    }
+}
+
+impl Clone for FrameBuffer {
+    fn clone(&self) -> Self {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::FrameBuffer*"] {
+                raw->retain();
+            })
         }
-        virtual void onUserInfoUpdated(uid_t uid, const agora::linuxsdk::UserInfo& info){
-            (void)uid;
-            (void)info;
+        FrameBuffer {
+            raw,
+            data: self.data,
+            len: self.len,
         }
-    };
-}}
-
-pub trait RawPtr {
-    fn raw_ptr(&self) -> *mut u32;
+    }
 }
 
-pub trait Emitter: RawPtr {
-    fn set_callback(&mut self, callback: Box<dyn Listener>);
+impl Drop for FrameBuffer {
+    fn drop(&mut self) {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::FrameBuffer*"] {
+                raw->release();
+            })
+        }
+    }
 }
 
-pub struct AgoraSdkEvents {
-    rawptr: *mut u32,
-    listener: Option<Box<dyn Listener>>,
+#[derive(PartialEq, Debug, Default, Clone, Copy)]
+pub struct FramePoolStats {
+    pub hits: u64,
+    pub misses: u64,
+    pub in_use: u64,
+    pub high_water: u64,
+    pub in_use_bytes: u64,
+    pub high_water_bytes: u64,
+    pub cached_bytes: u64,
 }
 
-pub trait Listener {
-    fn error(&self, error: u32, stat_code: u32);
-    fn joined(&mut self, uid: u32);
-    fn left(&mut self, uid: u32);
-    fn channel_joined(&mut self, channel: String, uid: u32);
+/// Listener dispatch counters. `depth` is what has been posted but not yet
+/// delivered; a growing depth means listeners are falling behind.
+// Mirrors agora::EventExecutorStats.
+#[repr(C)]
+#[derive(PartialEq, Debug, Default, Clone, Copy)]
+pub struct EventExecutorStats {
+    pub workers: u64,
+    pub posted: u64,
+    pub delivered: u64,
+    pub depth: u64,
+    pub high_water: u64,
+    pub steals: u64,
 }
 
-impl CallbackTrait for AgoraSdkEvents {
-    fn on_error(&mut self, error: u32, stat_code: u32) {
-        if self.listener.is_some() {
-            self.listener.as_mut().unwrap().error(error, stat_code);
-        }
+/// Counters of the executor shared by recorders not created by a
+/// `RecorderManager`.
+pub fn event_executor_stats() -> EventExecutorStats {
+    let mut stats = EventExecutorStats::default();
+    let stats_ptr = &mut stats as *mut EventExecutorStats;
+    unsafe {
+        cpp!([stats_ptr as "agora::EventExecutorStats*"] {
+            *stats_ptr = agora::EventExecutor::shared()->stats();
+        })
     }
+    stats
+}
 
-    fn on_user_joined(&mut self, uid: u32) {
-        if self.listener.is_some() {
-            self.listener.as_mut().unwrap().joined(uid);
-        }
+pub fn frame_pool_stats() -> FramePoolStats {
+    let mut values = [0u64; 7];
+    let values_ptr = values.as_mut_ptr();
+    unsafe {
+        cpp!([values_ptr as "uint64_t*"] {
+            agora::FramePoolStats stats = agora::FramePool::shared()->stats();
+            values_ptr[0] = stats.m_hits;
+            values_ptr[1] = stats.m_misses;
+            values_ptr[2] = stats.m_inUse;
+            values_ptr[3] = stats.m_highWater;
+            values_ptr[4] = stats.m_inUseBytes;
+            values_ptr[5] = stats.m_highWaterBytes;
+            values_ptr[6] = stats.m_cachedBytes;
+        })
     }
+    FramePoolStats {
+        hits: values[0],
+        misses: values[1],
+        in_use: values[2],
+        high_water: values[3],
+        in_use_bytes: values[4],
+        high_water_bytes: values[5],
+        cached_bytes: values[6],
+    }
+}
 
-    fn on_user_left(&mut self, uid: u32) {
-        if self.listener.is_some() {
-            self.listener.as_mut().unwrap().left(uid);
-        }
+pub fn set_frame_pool_max_cached(count: usize) {
+    unsafe {
+        cpp!([count as "size_t"] {
+            agora::FramePool::shared()->setMaxCachedPerClass(count);
+        })
     }
+}
 
-    fn on_channel_join_success(&mut self, channel: &str, uid: u32) {
-        if self.listener.is_some() {
-            self.listener
-                .as_mut()
-                .unwrap()
-                .channel_joined(channel.to_string(), uid);
-        }
+pub fn frame_pool_trim() {
+    unsafe {
+        cpp!([] {
+            agora::FramePool::shared()->trim();
+        })
     }
 }
 
-impl AgoraSdkEvents {
-    pub fn new() -> Self {
-        let rawptr = unsafe {
-            cpp!([] -> *mut u32  as "agora::recording::IRecordingEngineEventHandler*" {
-                return new AgoraSdkEvents();
-            })
-        };
+#[derive(PartialEq, Debug, Clone, Copy)]
+pub enum OverflowPolicy {
+    DropOldest,
+    DropNewest,
+    KeyframesOnly,
+    Block(Duration),
+}
 
-        AgoraSdkEvents {
-            rawptr,
-            listener: None,
+impl OverflowPolicy {
+    fn value(&self) -> u32 {
+        match *self {
+            OverflowPolicy::DropOldest => 0,
+            OverflowPolicy::DropNewest => 1,
+            OverflowPolicy::KeyframesOnly => 2,
+            OverflowPolicy::Block(_) => 3,
         }
     }
 }
 
-impl RawPtr for AgoraSdkEvents {
-    fn raw_ptr(&self) -> *mut u32 {
-        return self.rawptr;
-    }
+fn duration_ms(duration: Duration) -> u32 {
+    let ms = duration.as_secs() * 1000 + u64::from(duration.subsec_millis());
+    ms.min(u64::from(u32::MAX)) as u32
 }
 
-impl Emitter for AgoraSdkEvents {
-    fn set_callback(&mut self, callback: Box<dyn Listener>) {
-        if self.listener.is_some() {
-            return;
-        }
-        self.listener = Some(callback);
+pub enum MediaFrame {
+    Video(OwnedVideoFrame),
+    Audio(OwnedAudioFrame),
+}
 
-        let inst_ptr: &dyn CallbackTrait = self as &dyn CallbackTrait;
-        let rawptr = self.rawptr;
-        unsafe {
-            cpp!([  rawptr as "AgoraSdkEvents*",
-                    inst_ptr as "CallbackPtr"] {
-                rawptr->callback = inst_ptr;
-            })
-        }
-    }
+pub struct QueuedFrame {
+    pub uid: u32,
+    pub keyframe: bool,
+    pub media: MediaFrame,
 }
 
-pub struct AgoraSdk {
-    sdk: *mut u32,
-    events: AgoraSdkEvents,
+/// A frame from the media retention window. Frames of one dump share a
+/// single pooled buffer.
+pub struct RetainedFrame {
+    pub uid: u32,
+    pub keyframe: bool,
+    pub media: MediaFrame,
 }
 
-unsafe impl Send for AgoraSdk {}
+#[derive(PartialEq, Debug, Default, Clone, Copy)]
+pub struct FrameQueueStats {
+    pub pushed: u64,
+    pub popped: u64,
+    pub dropped: u64,
+    pub len: u64,
+}
 
-pub trait IAgoraSdk: RawPtr + Send {
-    fn set_keep_last_frame(&self, keep: bool);
-    fn create_channel(
-        &self,
-        app_id: &str,
-        channel_key: &str,
-        name: &str,
-        uid: u32,
-        config: &Config,
-    ) -> bool;
-    fn update_mix_mode_setting(&self, width: u32, height: u32, is_video_mix: bool);
-    fn leave_channel(&self) -> bool;
-    fn set_video_mixing_layout(&self, layout: &Layout) -> u32;
-    fn release(&self) -> bool;
-    fn set_listener(&mut self, listener: Box<dyn Listener>);
+/// Bounded queue fed by the SDK frame callbacks once attached with
+/// `IAgoraSdk::attach_frame_queue`. The callbacks copy each frame into a pooled
+/// buffer and never wait on the consumer unless the policy is `Block`.
+/// Clones share the same queue, so several workers can drain it.
+pub struct FrameQueue {
+    raw: *mut u32,
 }
 
-impl AgoraSdk {
-    pub fn new() -> Self {
-        let sdk = unsafe {
-            cpp!([] -> *mut u32  as "agora::AgoraSdk*" {
-                return new agora::AgoraSdk();
+unsafe impl Send for FrameQueue {}
+unsafe impl Sync for FrameQueue {}
+
+impl FrameQueue {
+    /// `capacity` is rounded up to a power of two.
+    pub fn new(capacity: usize, policy: OverflowPolicy) -> Self {
+        let kind = policy.value();
+        let timeout_ms = match policy {
+            OverflowPolicy::Block(timeout) => duration_ms(timeout),
+            _ => 0,
+        };
+        let raw = unsafe {
+            cpp!([capacity as "size_t", kind as "uint32_t", timeout_ms as "uint32_t"] -> *mut u32 as "agora::FrameQueue*" {
+                return new agora::FrameQueue(capacity, static_cast<agora::FRAME_QUEUE_POLICY>(kind), timeout_ms);
             })
         };
-
-        AgoraSdk {
-            sdk,
-            events: AgoraSdkEvents::new(),
-        }
+        FrameQueue { raw }
     }
-}
 
-impl RawPtr for AgoraSdk {
-    fn raw_ptr(&self) -> *mut u32 {
-        return self.sdk;
+    pub fn try_recv(&self) -> Option<QueuedFrame> {
+        self.recv_timeout(Duration::from_millis(0))
+    }
+
+    /// Waits up to `timeout` for a frame. Returns `None` on timeout or once the
+    /// queue is closed and empty.
+    pub fn recv_timeout(&self, timeout: Duration) -> Option<QueuedFrame> {
+        let raw = self.raw;
+        let timeout_ms = duration_ms(timeout);
+        let mut uid = 0u32;
+        let mut kind = 0u32;
+        let mut keyframe = false;
+        let mut video: RawVideoFrame = unsafe { mem::zeroed() };
+        let mut audio: RawAudioFrame = unsafe { mem::zeroed() };
+        let mut buffer: *mut u32 = ptr::null_mut();
+        let uid_ptr = &mut uid as *mut u32;
+        let kind_ptr = &mut kind as *mut u32;
+        let keyframe_ptr = &mut keyframe as *mut bool;
+        let video_ptr = &mut video as *mut RawVideoFrame;
+        let audio_ptr = &mut audio as *mut RawAudioFrame;
+        let buffer_ptr = &mut buffer as *mut *mut u32;
+        let popped = unsafe {
+            cpp!([  raw as "agora::FrameQueue*",
+                    timeout_ms as "uint32_t",
+                    uid_ptr as "uint32_t*",
+                    kind_ptr as "uint32_t*",
+                    keyframe_ptr as "bool*",
+                    video_ptr as "agora::VideoFrameView*",
+                    audio_ptr as "agora::AudioFrameView*",
+                    buffer_ptr as "agora::FrameBuffer**"] -> bool as "bool" {
+                agora::QueuedFrame frame;
+                if (!raw->pop(frame, timeout_ms))
+                    return false;
+                *uid_ptr = frame.m_uid;
+                *kind_ptr = frame.m_type;
+                *keyframe_ptr = frame.m_keyframe;
+                *video_ptr = frame.m_video;
+                *audio_ptr = frame.m_audio;
+                *buffer_ptr = frame.m_buffer;
+                return true;
+            })
+        };
+        if !popped {
+            return None;
+        }
+        let buffer = unsafe { FrameBuffer::from_raw(buffer) };
+        let media = if kind == 0 {
+            MediaFrame::Video(unsafe { OwnedVideoFrame::from_pooled(&video, buffer) }?)
+        } else {
+            MediaFrame::Audio(unsafe { OwnedAudioFrame::from_pooled(&audio, buffer) }?)
+        };
+        Some(QueuedFrame {
+            uid,
+            keyframe,
+            media,
+        })
+    }
+
+    /// Stops accepting frames and wakes any blocked `recv_timeout`.
+    pub fn close(&self) {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::FrameQueue*"] {
+                raw->close();
+            })
+        }
+    }
+
+    pub fn capacity(&self) -> usize {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::FrameQueue*"] -> usize as "size_t" {
+                return raw->capacity();
+            })
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::FrameQueue*"] -> usize as "size_t" {
+                return raw->size();
+            })
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn stats(&self) -> FrameQueueStats {
+        let raw = self.raw;
+        let mut values = [0u64; 4];
+        let values_ptr = values.as_mut_ptr();
+        unsafe {
+            cpp!([raw as "agora::FrameQueue*", values_ptr as "uint64_t*"] {
+                agora::FrameQueueStats stats = raw->stats();
+                values_ptr[0] = stats.m_pushed;
+                values_ptr[1] = stats.m_popped;
+                values_ptr[2] = stats.m_dropped;
+                values_ptr[3] = stats.m_size;
+            })
+        }
+        FrameQueueStats {
+            pushed: values[0],
+            popped: values[1],
+            dropped: values[2],
+            len: values[3],
+        }
+    }
+
+    pub fn dropped_for(&self, uid: u32) -> u64 {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::FrameQueue*", uid as "uint32_t"] -> u64 as "uint64_t" {
+                return raw->droppedFor(uid);
+            })
+        }
+    }
+
+    /// Drop counts for every uid that has lost at least one frame.
+    pub fn dropped_by_uid(&self) -> Vec<(u32, u64)> {
+        let raw = self.raw;
+        let max = 1024usize;
+        let mut uids = vec![0u32; max];
+        let mut counts = vec![0u64; max];
+        let (uids_ptr, counts_ptr) = (uids.as_mut_ptr(), counts.as_mut_ptr());
+        let len = unsafe {
+            cpp!([  raw as "agora::FrameQueue*",
+                    uids_ptr as "uint32_t*",
+                    counts_ptr as "uint64_t*",
+                    max as "size_t"] -> usize as "size_t" {
+                return raw->droppedByUid(uids_ptr, counts_ptr, max);
+            })
+        };
+        uids.into_iter().zip(counts).take(len).collect()
+    }
+}
+
+impl Clone for FrameQueue {
+    fn clone(&self) -> Self {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::FrameQueue*"] {
+                raw->retain();
+            })
+        }
+        FrameQueue { raw }
+    }
+}
+
+impl Drop for FrameQueue {
+    fn drop(&mut self) {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::FrameQueue*"] {
+                raw->release();
+            })
+        }
+    }
+}
+
+pub trait CallbackTrait {
+    fn on_event(&mut self, event: RecorderEvent);
+    fn on_video_frame(&mut self, uid: u32, frame: &VideoFrame);
+    fn on_audio_frame(&mut self, uid: u32, frame: &AudioFrame);
+    fn on_stats_batch(&mut self, batch: &StatsBatch);
+}
+
+cpp! {{
+    struct CallbackPtr { void *a, *b; };
+
+    using agora::VideoFrameView;
+    using agora::AudioFrameView;
+    using agora::fillVideoFrameView;
+    using agora::fillAudioFrameView;
+
+    class AgoraSdkEvents;
+    //the sdk whose listener this thread is running, if any
+    static thread_local const AgoraSdkEvents *t_listener = nullptr;
+
+    //Listener callbacks run on the sdk's EventExecutor rather than the SDK
+    //thread; the C++ side (peers, media accounting, frame queue) still sees
+    //everything inline. Frames are the exception: they are lent to the
+    //listener inline unless it asked for queued copies.
+    class AgoraSdkEvents :  virtual public agora::recording::IRecordingEngineEventHandler, public agora::EventSink {
+        public:
+        CallbackPtr callback = {nullptr, nullptr};
+        agora::AgoraSdk *sdk = nullptr;
+        bool queueFrames = false;
+
+        void attach(CallbackPtr listener, bool queued) {
+            std::lock_guard<std::mutex> lock(m_listenerMutex);
+            callback = listener;
+            queueFrames = queued;
+            m_attached = true;
+        }
+        //Once this returns the listener is never called again; events still
+        //queued are dropped as they come up.
+        void detach() {
+            m_attached = false;
+            if (t_listener == this) {
+                callback = {nullptr, nullptr};
+                return;
+            }
+            std::lock_guard<std::mutex> lock(m_listenerMutex);
+            callback = {nullptr, nullptr};
+        }
+        //A listener running inline on the SDK thread holds the lock the
+        //executor needs, so it must not wait for the queue either.
+        void waitIdle() {
+            if (t_listener != this)
+                agora::EventSink::waitIdle();
+        }
+        protected:
+        bool listening() const {
+            return m_attached;
+        }
+        static agora::HandlerEvent makeEvent(agora::HANDLER_EVENT_TYPE type, uint32_t uid) {
+            agora::HandlerEvent event;
+            memset(&event, 0, sizeof(event));
+            event.m_type = type;
+            event.m_uid = uid;
+            return event;
+        }
+        static void copyString(char *dst, size_t size, const char *src) {
+            strncpy(dst, src ? src : "", size - 1);
+            dst[size - 1] = 0;
+        }
+        void post(agora::HandlerEvent &event) const {
+            if (!listening())
+                return;
+            agora::EventExecutor *executor = sdk ? sdk->getEventExecutor() : agora::EventExecutor::shared();
+            executor->post(const_cast<AgoraSdkEvents*>(this), event);
+        }
+        agora::FramePool* framePool() const {
+            return sdk ? sdk->getFramePool() : agora::FramePool::shared();
+        }
+        void postBatch(agora::StatsBatch *batch) const {
+            if (!batch)
+                return;
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_STATS_BATCH, 0);
+            event.m_batch = batch;
+            post(event);
+        }
+        public:
+        void flushStats() {
+            if (sdk)
+                postBatch(sdk->getStatsBatcher()->flush());
+        }
+        protected:
+        virtual void deliver(const agora::HandlerEvent &event) {
+            std::lock_guard<std::mutex> lock(m_listenerMutex);
+            if (!callback.a)
+                return;
+            const AgoraSdkEvents *outer = t_listener;
+            t_listener = this;
+            deliverLocked(event);
+            t_listener = outer;
+        }
+        void deliverLocked(const agora::HandlerEvent &event) {
+            uint32_t uid = event.m_uid;
+            switch (event.m_type) {
+            case agora::HANDLER_EVENT_AUDIO_FRAME: {
+                //the listener's retain() shares the pooled copy
+                const AudioFrameView *viewPtr = &event.m_audio;
+                agora::FrameBuffer *buffer = event.m_buffer;
+                buffer->retain();
+                rust!(OnQueuedAudioFrameImpl [callback : &mut dyn CallbackTrait as "CallbackPtr", uid: u32 as "uint32_t", viewPtr: *const RawAudioFrame as "const AudioFrameView*", buffer: *mut u32 as "agora::FrameBuffer*"] {
+                    let buffer = unsafe { FrameBuffer::from_raw(buffer) };
+                    if let Some(frame) = unsafe { OwnedAudioFrame::from_pooled(&*viewPtr, buffer) } {
+                        callback.on_audio_frame(uid, &frame.view())
+                    }
+                });
+                break;
+            }
+            case agora::HANDLER_EVENT_VIDEO_FRAME: {
+                const VideoFrameView *viewPtr = &event.m_video;
+                agora::FrameBuffer *buffer = event.m_buffer;
+                buffer->retain();
+                rust!(OnQueuedVideoFrameImpl [callback : &mut dyn CallbackTrait as "CallbackPtr", uid: u32 as "uint32_t", viewPtr: *const RawVideoFrame as "const VideoFrameView*", buffer: *mut u32 as "agora::FrameBuffer*"] {
+                    let buffer = unsafe { FrameBuffer::from_raw(buffer) };
+                    if let Some(frame) = unsafe { OwnedVideoFrame::from_pooled(&*viewPtr, buffer) } {
+                        callback.on_video_frame(uid, &frame.view())
+                    }
+                });
+                break;
+            }
+            case agora::HANDLER_EVENT_STATS_BATCH: {
+                const agora::StatsBatchView *batchPtr = &event.m_batch->view();
+                rust!(OnStatsBatchImpl [callback : &mut dyn CallbackTrait as "CallbackPtr", batchPtr: *const RawStatsBatch as "const agora::StatsBatchView*"] {
+                    callback.on_stats_batch(&StatsBatch::from_raw(unsafe { &*batchPtr }))
+                });
+                break;
+            }
+            default: {
+                const agora::HandlerEvent *eventPtr = &event;
+                rust!(OnEventImpl [callback : &mut dyn CallbackTrait as "CallbackPtr", eventPtr: *const RawHandlerEvent as "const agora::HandlerEvent*"] {
+                    if let Some(event) = RecorderEvent::from_raw(unsafe { &*eventPtr }) {
+                        callback.on_event(event)
+                    }
+                });
+                break;
+            }
+            }
+        }
+        //Lends a frame to the listener while the SDK still owns its buffers.
+        //Returns false when it has to be copied and queued instead: the
+        //listener asked for that, is busy on another thread, or has events
+        //queued that must reach it first.
+        bool deliverInline(uint32_t uid, const AudioFrameView *audio, const VideoFrameView *video) const {
+            if (queueFrames || t_listener == this)
+                return false;
+            std::unique_lock<std::mutex> lock(m_listenerMutex, std::try_to_lock);
+            if (!lock.owns_lock() || pending() > 0)
+                return false;
+            if (!callback.a)
+                return true;
+            AgoraSdkEvents *self = const_cast<AgoraSdkEvents*>(this);
+            const AgoraSdkEvents *outer = t_listener;
+            t_listener = this;
+            if (audio)
+                self->audioFrameInline(uid, audio);
+            else
+                self->videoFrameInline(uid, video);
+            t_listener = outer;
+            return true;
+        }
+        void audioFrameInline(uint32_t uid, const AudioFrameView *viewPtr) {
+            rust!(OnAudioFrameImpl [callback : &mut dyn CallbackTrait as "CallbackPtr", uid: u32 as "uint32_t", viewPtr: *const RawAudioFrame as "const AudioFrameView*"] {
+                if let Some(frame) = unsafe { AudioFrame::from_raw(&*viewPtr) } {
+                    callback.on_audio_frame(uid, &frame)
+                }
+            });
+        }
+        void videoFrameInline(uint32_t uid, const VideoFrameView *viewPtr) {
+            rust!(OnVideoFrameImpl [callback : &mut dyn CallbackTrait as "CallbackPtr", uid: u32 as "uint32_t", viewPtr: *const RawVideoFrame as "const VideoFrameView*"] {
+                if let Some(frame) = unsafe { VideoFrame::from_raw(&*viewPtr) } {
+                    callback.on_video_frame(uid, &frame)
+                }
+            });
+        }
+        virtual void onError(int error, agora::linuxsdk::STAT_CODE_TYPE stat_code) {
+            //sdk->stoppedOnError();
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_ERROR, 0);
+            event.m_error.m_code = error;
+            event.m_error.m_statCode = stat_code;
+            post(event);
+        }
+        virtual void onWarning(int warn) {
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_WARNING, 0);
+            event.m_error.m_code = warn;
+            post(event);
+        }
+        virtual void onJoinChannelSuccess(const char * channelId, agora::linuxsdk::uid_t uid) {
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_JOIN_CHANNEL_SUCCESS, uid);
+            copyString(event.m_channel, sizeof(event.m_channel), channelId);
+            post(event);
+        }
+        virtual void onLeaveChannel(agora::linuxsdk::LEAVE_PATH_CODE code) {
+            flushStats();
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_LEAVE_CHANNEL, 0);
+            event.m_leave.m_code = code;
+            post(event);
+        }
+        virtual void onUserJoined(agora::linuxsdk::uid_t uid, agora::linuxsdk::UserJoinInfos &infos) {
+            (void)infos;
+            if (sdk)
+                sdk->addPeer(uid);
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_USER_JOINED, uid);
+            post(event);
+        }
+        virtual void onRemoteVideoStreamStateChanged(agora::linuxsdk::uid_t uid, agora::linuxsdk::RemoteStreamState state, agora::linuxsdk::RemoteStreamStateChangedReason reason) {
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_REMOTE_VIDEO_STREAM_STATE, uid);
+            event.m_state.m_state = state;
+            event.m_state.m_reason = reason;
+            post(event);
+        }
+        virtual void onRemoteAudioStreamStateChanged(agora::linuxsdk::uid_t uid, agora::linuxsdk::RemoteStreamState state, agora::linuxsdk::RemoteStreamStateChangedReason reason) {
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_REMOTE_AUDIO_STREAM_STATE, uid);
+            event.m_state.m_state = state;
+            event.m_state.m_reason = reason;
+            post(event);
+        }
+        virtual void onUserOffline(agora::linuxsdk::uid_t uid, agora::linuxsdk::USER_OFFLINE_REASON_TYPE reason) {
+            if (sdk)
+                sdk->removePeer(uid);
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_USER_OFFLINE, uid);
+            event.m_offline.m_reason = reason;
+            post(event);
+        }
+        virtual void audioFrameReceived(unsigned int uid, const agora::linuxsdk::AudioFrame *frame) const {
+            AudioFrameView view;
+            if (!frame || !fillAudioFrameView(frame, view))
+                return;
+            if (sdk)
+                sdk->audioFrameReceived(uid, view);
+            if (!listening() || deliverInline(uid, &view, NULL))
+                return;
+            //the SDK reuses its buffers once we return
+            agora::HandlerEvent event;
+            event.m_type = agora::HANDLER_EVENT_AUDIO_FRAME;
+            event.m_uid = uid;
+            event.m_buffer = agora::copyAudioFrameView(framePool(), view, event.m_audio);
+            post(event);
+        }
+        virtual void videoFrameReceived(unsigned int uid, const agora::linuxsdk::VideoFrame *frame) const {
+            VideoFrameView view;
+            if (!frame || !fillVideoFrameView(frame, view))
+                return;
+            if (sdk)
+                sdk->videoFrameReceived(uid, view);
+            if (!listening() || deliverInline(uid, NULL, &view))
+                return;
+            agora::HandlerEvent event;
+            event.m_type = agora::HANDLER_EVENT_VIDEO_FRAME;
+            event.m_uid = uid;
+            event.m_buffer = agora::copyVideoFrameView(framePool(), view, event.m_video);
+            post(event);
+        }
+        virtual void onActiveSpeaker(uid_t uid) {
+            if (sdk)
+                sdk->activeSpeaker(uid);
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_ACTIVE_SPEAKER, uid);
+            post(event);
+        }
+        virtual void onAudioVolumeIndication(const agora::linuxsdk::AudioVolumeInfo* speakers, unsigned int speakerNum) {
+            if (sdk)
+                sdk->audioVolumeIndication(speakers, speakerNum);
+            if (sdk && listening())
+                postBatch(sdk->getStatsBatcher()->addVolume(speakers, speakerNum));
+        }
+        virtual void onFirstRemoteVideoDecoded(uid_t uid, int width, int height, int elapsed) {
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_FIRST_REMOTE_VIDEO_DECODED, uid);
+            event.m_firstFrame.m_width = width;
+            event.m_firstFrame.m_height = height;
+            event.m_firstFrame.m_elapsed = elapsed;
+            post(event);
+        }
+        virtual void onFirstRemoteAudioFrame(uid_t uid, int elapsed) {
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_FIRST_REMOTE_AUDIO_FRAME, uid);
+            event.m_firstFrame.m_elapsed = elapsed;
+            post(event);
+        }
+        virtual void onReceivingStreamStatusChanged(bool receivingAudio, bool receivingVideo) {
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_RECEIVING_STREAM_STATUS, 0);
+            event.m_receiving.m_audio = receivingAudio;
+            event.m_receiving.m_video = receivingVideo;
+            post(event);
+        }
+        virtual void onConnectionLost() {
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_CONNECTION_LOST, 0);
+            post(event);
+        }
+        virtual void onConnectionInterrupted() {
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_CONNECTION_INTERRUPTED, 0);
+            post(event);
+        }
+        virtual void onRejoinChannelSuccess(const char* channelId, uid_t uid) {
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_REJOIN_CHANNEL_SUCCESS, uid);
+            copyString(event.m_channel, sizeof(event.m_channel), channelId);
+            post(event);
+        }
+        virtual void onConnectionStateChanged(agora::linuxsdk::ConnectionStateType state, agora::linuxsdk::ConnectionChangedReasonType reason){
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_CONNECTION_STATE_CHANGED, 0);
+            event.m_state.m_state = state;
+            event.m_state.m_reason = reason;
+            post(event);
+        }
+        virtual void onRecordingStats(const agora::linuxsdk::RecordingStats& stats){
+            if (sdk && listening())
+                postBatch(sdk->getStatsBatcher()->addRecordingStats(stats));
+        }
+        virtual void onRemoteVideoStats(uid_t uid, const agora::linuxsdk::RemoteVideoStats& stats){
+            if (sdk && listening())
+                postBatch(sdk->getStatsBatcher()->addRemoteVideoStats(uid, stats));
+        }
+        virtual void onRemoteAudioStats(uid_t uid, const agora::linuxsdk::RemoteAudioStats& stats){
+            if (sdk && listening())
+                postBatch(sdk->getStatsBatcher()->addRemoteAudioStats(uid, stats));
+        }
+        virtual void onLocalUserRegistered(uid_t uid, const char* userAccount){
+            if (sdk)
+                sdk->userInfoUpdated(uid, userAccount);
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_LOCAL_USER_REGISTERED, uid);
+            copyString(event.m_account, sizeof(event.m_account), userAccount);
+            post(event);
+        }
+        virtual void onUserInfoUpdated(uid_t uid, const agora::linuxsdk::UserInfo& info){
+            if (sdk)
+                sdk->userInfoUpdated(uid, info.userAccount);
+            agora::HandlerEvent event = makeEvent(agora::HANDLER_EVENT_USER_INFO_UPDATED, uid);
+            copyString(event.m_account, sizeof(event.m_account), info.userAccount);
+            post(event);
+        }
+
+        private:
+        //held while the listener runs, so it is never called from two threads at once
+        mutable std::mutex m_listenerMutex;
+        std::atomic<bool> m_attached{false};
+    };
+}}
+
+pub trait RawPtr {
+    fn raw_ptr(&self) -> *mut u32;
+}
+
+pub trait Emitter: RawPtr {
+    fn set_callback(&mut self, callback: Box<dyn Listener>);
+}
+
+pub struct AgoraSdkEvents {
+    rawptr: *mut u32,
+    listener: Option<Box<dyn Listener>>,
+}
+
+pub trait Listener {
+    fn error(&self, error: u32, stat_code: u32);
+    fn joined(&mut self, uid: u32);
+    fn left(&mut self, uid: u32);
+    fn channel_joined(&mut self, channel: String, uid: u32);
+    /// Frames are lent inline on the SDK thread by default, which is held up
+    /// until `video_frame` or `audio_frame` returns. Returning true here has
+    /// them copied into pooled buffers and delivered on the event executor
+    /// instead, in order with the other callbacks; `retain` then shares the
+    /// copy rather than making another.
+    fn queued_frames(&self) -> bool {
+        false
+    }
+    fn video_frame(&mut self, _uid: u32, _frame: &VideoFrame) {}
+    fn audio_frame(&mut self, _uid: u32, _frame: &AudioFrame) {}
+    /// Volume indications and remote/recording stats, batched as configured
+    /// by `IAgoraSdk::set_stats_batching`.
+    fn stats_batch(&mut self, _batch: &StatsBatch) {}
+    /// Every handler callback other than frames and batched stats, including
+    /// the ones above, which are still called first.
+    fn event(&mut self, _event: RecorderEvent) {}
+}
+
+impl CallbackTrait for AgoraSdkEvents {
+    fn on_event(&mut self, event: RecorderEvent) {
+        if let Some(listener) = self.listener.as_mut() {
+            match event {
+                RecorderEvent::Error { error, stat_code } => listener.error(error, stat_code),
+                RecorderEvent::ChannelJoined { channel, uid } => {
+                    listener.channel_joined(channel.to_string(), uid)
+                }
+                RecorderEvent::UserJoined { uid } => listener.joined(uid),
+                RecorderEvent::UserLeft { uid, .. } => listener.left(uid),
+                _ => {}
+            }
+            listener.event(event);
+        }
+    }
+
+    fn on_video_frame(&mut self, uid: u32, frame: &VideoFrame) {
+        if self.listener.is_some() {
+            self.listener.as_mut().unwrap().video_frame(uid, frame);
+        }
+    }
+
+    fn on_audio_frame(&mut self, uid: u32, frame: &AudioFrame) {
+        if self.listener.is_some() {
+            self.listener.as_mut().unwrap().audio_frame(uid, frame);
+        }
+    }
+
+    fn on_stats_batch(&mut self, batch: &StatsBatch) {
+        if self.listener.is_some() {
+            self.listener.as_mut().unwrap().stats_batch(batch);
+        }
+    }
+}
+
+impl AgoraSdkEvents {
+    pub fn new() -> Self {
+        let rawptr = unsafe {
+            cpp!([] -> *mut u32  as "agora::recording::IRecordingEngineEventHandler*" {
+                return new AgoraSdkEvents();
+            })
+        };
+
+        AgoraSdkEvents {
+            rawptr,
+            listener: None,
+        }
+    }
+}
+
+impl RawPtr for AgoraSdkEvents {
+    fn raw_ptr(&self) -> *mut u32 {
+        return self.rawptr;
+    }
+}
+
+impl Emitter for AgoraSdkEvents {
+    fn set_callback(&mut self, callback: Box<dyn Listener>) {
+        if self.listener.is_some() {
+            return;
+        }
+        self.listener = Some(callback);
+
+        let queued = self.listener.as_ref().map_or(false, |listener| listener.queued_frames());
+        let inst_ptr: &dyn CallbackTrait = self as &dyn CallbackTrait;
+        let rawptr = self.rawptr;
+        unsafe {
+            cpp!([  rawptr as "AgoraSdkEvents*",
+                    inst_ptr as "CallbackPtr",
+                    queued as "bool"] {
+                rawptr->attach(inst_ptr, queued);
+            })
+        }
+    }
+}
+
+/// The subscribed uids as the recorder sees them. `version` goes up with
+/// every change, and `engine_updates` counts the lists sent to the engine.
+#[derive(PartialEq, Debug, Default, Clone)]
+pub struct Subscriptions {
+    pub version: u64,
+    pub video: Vec<u32>,
+    pub audio: Vec<u32>,
+    pub engine_updates: u64,
+}
+
+#[derive(PartialEq, Debug, Default, Clone, Copy)]
+pub struct LayoutPushStats {
+    /// Layout recomputes, after debouncing.
+    pub pushed: u64,
+    pub coalesced: u64,
+    /// Recomputes that changed the layout and were sent to the engine.
+    pub applied: u64,
+    /// Recomputes skipped because the engine already had that layout.
+    pub suppressed: u64,
+    /// Dominant speaker changes in `LayoutMode::ActiveSpeaker`.
+    pub speaker_switches: u64,
+    /// Times stable layout slots closed their holes because the tile size
+    /// changed.
+    pub compactions: u64,
+}
+
+/// Frame accounting for one direction of a uid's media. A gap is a step in
+/// `frame_ms` of more than twice the smoothed frame interval; jitter is the
+/// RFC 3550 estimate over those steps.
+#[repr(C)]
+#[derive(PartialEq, Debug, Default, Clone, Copy)]
+pub struct StreamStats {
+    pub frames: u64,
+    pub bytes: u64,
+    pub last_frame_ms: u64,
+    pub gaps: u64,
+    pub gap_ms: u64,
+    pub max_gap_ms: u64,
+    pub interval_ms: f64,
+    pub jitter_ms: f64,
+}
+
+// Mirrors agora::MediaAccountingEntry.
+#[repr(C)]
+#[derive(PartialEq, Debug, Default, Clone, Copy)]
+pub struct MediaStats {
+    pub uid: u32,
+    pub channels: u32,
+    pub audio: StreamStats,
+    pub video: StreamStats,
+}
+
+/// Speaking time of one uid. Time between volume indications is credited to
+/// everyone at or above the talk threshold in the later one.
+// Mirrors agora::TalkUserStats.
+#[repr(C)]
+#[derive(PartialEq, Debug, Default, Clone, Copy)]
+pub struct TalkerStats {
+    pub uid: u32,
+    /// Indications the uid was speaking in.
+    pub indications: u32,
+    pub speaking_ms: u64,
+    /// Speaking while someone else was too.
+    pub overlap_ms: u64,
+    /// Time in the channel, from the join or the first indication.
+    pub present_ms: u64,
+}
+
+impl TalkerStats {
+    /// Share of the uid's time in the channel spent not speaking.
+    pub fn silence_ratio(&self) -> f64 {
+        if self.present_ms == 0 {
+            return 0.0;
+        }
+        1.0 - (self.speaking_ms.min(self.present_ms) as f64 / self.present_ms as f64)
+    }
+}
+
+// Mirrors agora::TalkChannelStats.
+#[repr(C)]
+#[derive(PartialEq, Debug, Default, Clone, Copy)]
+pub struct TalkChannelStats {
+    /// Time covered by volume indications.
+    pub elapsed_ms: u64,
+    /// At least one uid speaking.
+    pub speech_ms: u64,
+    /// Two or more uids speaking.
+    pub overlap_ms: u64,
+    /// Nobody speaking.
+    pub silence_ms: u64,
+    /// Steady clock time, in ms, the snapshot was taken at.
+    pub snapshot_ms: u64,
+    pub users: u32,
+    /// Updates lost to uids that arrived after the table filled up.
+    pub dropped: u32,
+}
+
+/// The last talk snapshot published by the volume indications, see
+/// [`IAgoraSdk::set_talk_stats_interval`].
+#[derive(PartialEq, Debug, Default, Clone)]
+pub struct TalkStats {
+    pub channel: TalkChannelStats,
+    /// In the order the uids were first seen.
+    pub talkers: Vec<TalkerStats>,
+}
+
+impl TalkStats {
+    /// The uid's share of all speaking time; overlapping speech counts for
+    /// each speaker.
+    pub fn talk_ratio(&self, uid: u32) -> f64 {
+        let total: u64 = self.talkers.iter().map(|t| t.speaking_ms).sum();
+        match self.talkers.iter().find(|t| t.uid == uid) {
+            Some(t) if total > 0 => t.speaking_ms as f64 / total as f64,
+            _ => 0.0,
+        }
+    }
+
+    /// Share of the channel's time nobody was speaking.
+    pub fn silence_ratio(&self) -> f64 {
+        if self.channel.elapsed_ms == 0 {
+            return 0.0;
+        }
+        self.channel.silence_ms as f64 / self.channel.elapsed_ms as f64
+    }
+
+    /// Share of the channel's time two or more uids spoke at once.
+    pub fn overlap_ratio(&self) -> f64 {
+        if self.channel.elapsed_ms == 0 {
+            return 0.0;
+        }
+        self.channel.overlap_ms as f64 / self.channel.elapsed_ms as f64
+    }
+}
+
+/// Rates and sizes for the in-process fake engine selected with
+/// [`IAgoraSdk::use_fake_engine`]. A rate or interval of 0 turns that event
+/// off. Frames are only produced in the formats the channel's `Config` asks to
+/// decode, and volume indications follow its audio indication interval.
+// Mirrors agora::FakeEngineConfig.
+#[repr(C)]
+#[derive(PartialEq, Debug, Clone, Copy)]
+pub struct FakeEngineConfig {
+    pub users: u32,
+    pub first_uid: u32,
+    pub video_fps: u32,
+    pub video_frame_bytes: u32,
+    pub keyframe_interval: u32,
+    pub video_width: u32,
+    pub video_height: u32,
+    pub audio_frame_ms: u32,
+    pub audio_sample_rate: u32,
+    pub stats_interval_ms: u32,
+    pub churn_interval_ms: u32,
+    pub seed: u32,
+}
+
+impl Default for FakeEngineConfig {
+    fn default() -> Self {
+        FakeEngineConfig {
+            users: 16,
+            first_uid: 1000,
+            video_fps: 15,
+            video_frame_bytes: 4096,
+            keyframe_interval: 30,
+            video_width: 320,
+            video_height: 180,
+            audio_frame_ms: 20,
+            audio_sample_rate: 48000,
+            stats_interval_ms: 2000,
+            churn_interval_ms: 0,
+            seed: 1,
+        }
+    }
+}
+
+pub struct AgoraSdk {
+    sdk: *mut u32,
+    events: AgoraSdkEvents,
+    // the RecorderManager this session belongs to, or null
+    manager: *mut u32,
+}
+
+unsafe impl Send for AgoraSdk {}
+
+pub trait IAgoraSdk: RawPtr + Send {
+    fn set_keep_last_frame(&self, keep: bool);
+    fn create_channel(
+        &self,
+        app_id: &str,
+        channel_key: &str,
+        name: &str,
+        uid: u32,
+        config: &Config,
+    ) -> bool;
+    fn create_channel_with_user_account(
+        &self,
+        app_id: &str,
+        channel_key: &str,
+        name: &str,
+        user_account: &str,
+        config: &Config,
+    ) -> bool;
+    fn user_accounts(&self, uids: &[u32]) -> Vec<Option<String>>;
+    fn uids_by_user_accounts(&self, accounts: &[&str]) -> Vec<Option<u32>>;
+    fn update_mix_mode_setting(&self, width: u32, height: u32, is_video_mix: bool);
+    fn update_layout_setting(&self, mode: LayoutMode, max_resolution_uid: u32, max_resolution_account: &str);
+    fn leave_channel(&self) -> bool;
+    fn set_video_mixing_layout(&self, layout: &Layout) -> u32;
+    fn set_layout_debounce_time(&self, window_ms: u32);
+    fn layout_push_stats(&self) -> LayoutPushStats;
+    fn set_active_speaker_tuning(&self, min_dwell: Duration, hold: Duration, margin: u32);
+    fn set_stable_layout_slots(&self, stable: bool);
+    fn add_subscribed_uids(&self, video: bool, uids: &[u32]) -> bool;
+    fn remove_subscribed_uids(&self, video: bool, uids: &[u32]) -> bool;
+    fn set_subscribe_debounce_time(&self, window_ms: u32);
+    fn subscriptions(&self) -> Subscriptions;
+    fn active_speaker(&self) -> Option<u32>;
+    fn set_talk_threshold(&self, volume: u32);
+    fn set_talk_stats_interval(&self, interval: Duration);
+    fn talk_stats(&self) -> TalkStats;
+    fn attach_frame_queue(&self, queue: &FrameQueue) -> bool;
+    fn media_stats(&self) -> Vec<MediaStats>;
+    fn set_media_keep_time(&self, keep_ms: u32);
+    fn recent_media(&self, uid: u32, window: Duration) -> Vec<RetainedFrame>;
+    fn retained_uids(&self) -> Vec<u32>;
+    fn use_fake_engine(&self, config: &FakeEngineConfig);
+    fn set_stats_batching(&self, capacity: usize, interval: Duration);
+    fn pending_events(&self) -> usize;
+    fn release(&self) -> bool;
+    fn set_listener(&mut self, listener: Box<dyn Listener>);
+    fn event_stream(&mut self, frames: bool) -> Option<EventStream>;
+}
+
+impl AgoraSdk {
+    pub fn new() -> Self {
+        let sdk = unsafe {
+            cpp!([] -> *mut u32  as "agora::AgoraSdk*" {
+                return new agora::AgoraSdk();
+            })
+        };
+
+        AgoraSdk {
+            sdk,
+            events: AgoraSdkEvents::new(),
+            manager: ptr::null_mut(),
+        }
+    }
+}
+
+impl RawPtr for AgoraSdk {
+    fn raw_ptr(&self) -> *mut u32 {
+        return self.sdk;
     }
 }
 
 impl IAgoraSdk for AgoraSdk {
     fn set_listener(&mut self, listener: Box<dyn Listener>) {
         unsafe {
-            let handler = self.events.raw_ptr();
-            let me = self.raw_ptr();
-            cpp!([me as "agora::AgoraSdk*", handler as "agora::recording::IRecordingEngineEventHandler*"] {
-                me->setHandler(handler);
+            let handler = self.events.raw_ptr();
+            let me = self.raw_ptr();
+            cpp!([me as "agora::AgoraSdk*", handler as "agora::recording::IRecordingEngineEventHandler*"] {
+                me->setHandler(handler);
+                AgoraSdkEvents *events = dynamic_cast<AgoraSdkEvents*>(handler);
+                if (events)
+                    events->sdk = me;
+            })
+        };
+        self.events.set_callback(listener);
+    }
+
+    /// Delivers events as an async `Stream` instead of to a `Listener`; the
+    /// two are exclusive, so this is `None` once a listener is set. Frames
+    /// are copied into the stream only when `frames` is set.
+    fn event_stream(&mut self, frames: bool) -> Option<EventStream> {
+        if self.events.listener.is_some() {
+            return None;
+        }
+        let (sender, stream) = events::event_channel(frames);
+        self.set_listener(Box::new(sender));
+        Some(stream)
+    }
+
+    fn set_keep_last_frame(&self, keep: bool) {
+        let me = self.raw_ptr();
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", keep as "bool"] {
+                    return me->setKeepLastFrame(keep);
+                }
+            )
+        }
+    }
+
+    fn create_channel(
+        &self,
+        app_id: &str,
+        channel_key: &str,
+        name: &str,
+        uid: u32,
+        config: &Config,
+    ) -> bool {
+        let me = self.raw_ptr();
+        let app_id = CString::new(app_id).unwrap().into_raw();
+        let name = CString::new(name).unwrap().into_raw();
+        let channel_key = CString::new(channel_key).unwrap().into_raw();
+        unsafe {
+            cpp!([  me as "agora::AgoraSdk*",
+                    app_id as "const char *",
+                    channel_key as "const char *",
+                    name as "const char *",
+                    uid as "int",
+                    config as "agora::recording::RecordingConfig*"
+                    ] -> bool as "bool" {
+                        return me->createChannel(app_id, channel_key, name, uid, *config);
+                    }
+            )
+        }
+    }
+
+    fn create_channel_with_user_account(
+        &self,
+        app_id: &str,
+        channel_key: &str,
+        name: &str,
+        user_account: &str,
+        config: &Config,
+    ) -> bool {
+        let me = self.raw_ptr();
+        let app_id = CString::new(app_id).unwrap().into_raw();
+        let name = CString::new(name).unwrap().into_raw();
+        let channel_key = CString::new(channel_key).unwrap().into_raw();
+        let user_account = CString::new(user_account).unwrap().into_raw();
+        unsafe {
+            cpp!([  me as "agora::AgoraSdk*",
+                    app_id as "const char *",
+                    channel_key as "const char *",
+                    name as "const char *",
+                    user_account as "const char *",
+                    config as "agora::recording::RecordingConfig*"
+                    ] -> bool as "bool" {
+                        return me->createChannelWithUserAccount(app_id, channel_key, name, user_account, *config);
+                    }
+            )
+        }
+    }
+
+    /// Accounts of `uids` in a user account channel, as reported by the SDK.
+    /// Answered from the recorder's own directory without calling into the
+    /// engine; `None` for uids it hasn't reported yet.
+    fn user_accounts(&self, uids: &[u32]) -> Vec<Option<String>> {
+        let me = self.raw_ptr();
+        let count = uids.len();
+        let uids_ptr = uids.as_ptr();
+        let mut lengths = vec![0u32; count];
+        let lengths_ptr = lengths.as_mut_ptr();
+        let mut buf: Vec<u8> = Vec::with_capacity(count * 16);
+        loop {
+            let buf_ptr = buf.as_mut_ptr();
+            let buf_len = buf.capacity();
+            let needed = unsafe {
+                cpp!([me as "agora::AgoraSdk*", uids_ptr as "const uint32_t*", count as "size_t",
+                        buf_ptr as "char*", buf_len as "size_t", lengths_ptr as "uint32_t*"] -> usize as "size_t" {
+                    return me->getUserAccountsByUids(uids_ptr, count, buf_ptr, buf_len, lengths_ptr);
+                })
+            };
+            if needed <= buf.capacity() {
+                unsafe { buf.set_len(needed) };
+                break;
+            }
+            // an account arrived between calls can make it larger again
+            buf.reserve(needed);
+        }
+        let mut offset = 0;
+        lengths
+            .iter()
+            .map(|&length| {
+                if length == 0 {
+                    return None;
+                }
+                let end = offset + length as usize;
+                let account = String::from_utf8_lossy(&buf[offset..end]).into_owned();
+                offset = end;
+                Some(account)
+            })
+            .collect()
+    }
+
+    /// Uids of `accounts`, from the same directory as `user_accounts`.
+    fn uids_by_user_accounts(&self, accounts: &[&str]) -> Vec<Option<u32>> {
+        let me = self.raw_ptr();
+        let count = accounts.len();
+        let pointers: Vec<*const u8> = accounts.iter().map(|account| account.as_ptr()).collect();
+        let lengths: Vec<u32> = accounts.iter().map(|account| account.len() as u32).collect();
+        let pointers_ptr = pointers.as_ptr();
+        let lengths_ptr = lengths.as_ptr();
+        let mut uids = vec![0u32; count];
+        let uids_ptr = uids.as_mut_ptr();
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", pointers_ptr as "const char* const*", lengths_ptr as "const uint32_t*",
+                    count as "size_t", uids_ptr as "uint32_t*"] {
+                me->getUidsByUserAccounts(pointers_ptr, lengths_ptr, count, uids_ptr);
+            })
+        }
+        uids.into_iter()
+            .map(|uid| if uid == 0 { None } else { Some(uid) })
+            .collect()
+    }
+    fn update_mix_mode_setting(&self, width: u32, height: u32, is_video_mix: bool) {
+        let me = self.raw_ptr();
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*",
+                width as "int",
+                height as "int",
+                is_video_mix as "bool"] {
+                    me->updateMixModeSetting(width, height, is_video_mix);
+                }
+
+            )
+        }
+    }
+
+    /// Selects the automatic layout. `max_resolution_uid` (or, for user account
+    /// channels, `max_resolution_account`) is the large tile in vertical
+    /// presentation.
+    fn update_layout_setting(&self, mode: LayoutMode, max_resolution_uid: u32, max_resolution_account: &str) {
+        let me = self.raw_ptr();
+        let mode = mode.value();
+        let account = CString::new(max_resolution_account).unwrap_or_default();
+        let account_ptr = account.as_ptr();
+        unsafe {
+            cpp!([  me as "agora::AgoraSdk*",
+                    mode as "int",
+                    max_resolution_uid as "int",
+                    account_ptr as "const char *"] {
+                me->updateLayoutSetting(mode, max_resolution_uid, account_ptr);
+            })
+        }
+    }
+
+    /// Leaves the channel and waits for the listener to receive everything
+    /// that was queued for it before the engine stopped.
+    fn leave_channel(&self) -> bool {
+        let me = self.raw_ptr();
+        let handler = self.events.raw_ptr();
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", handler as "agora::recording::IRecordingEngineEventHandler*"] -> bool as "bool" {
+                    bool left = me->leaveChannel();
+                    AgoraSdkEvents *events = dynamic_cast<AgoraSdkEvents*>(handler);
+                    if (events) {
+                        events->flushStats();
+                        events->waitIdle();
+                    }
+                    return left;
+                }
+            )
+        }
+    }
+
+    fn set_video_mixing_layout(&self, layout: &Layout) -> u32 {
+        let me = self.raw_ptr();
+        unsafe {
+            cpp!([  me as "agora::AgoraSdk*",
+                    layout as "agora::linuxsdk::VideoMixingLayout*"] -> u32 as "int" {
+                return me->setVideoMixingLayout(*layout);
+            })
+        }
+    }
+
+    fn set_layout_debounce_time(&self, window_ms: u32) {
+        let me = self.raw_ptr();
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", window_ms as "uint32_t"] {
+                me->setLayoutDebounceTime(window_ms);
+            })
+        }
+    }
+
+    fn layout_push_stats(&self) -> LayoutPushStats {
+        let me = self.raw_ptr();
+        let mut values = [0u64; 6];
+        let values_ptr = values.as_mut_ptr();
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", values_ptr as "uint64_t*"] {
+                values_ptr[0] = me->getLayoutPushCount();
+                values_ptr[1] = me->getLayoutCoalescedCount();
+                values_ptr[2] = me->getLayoutAppliedCount();
+                values_ptr[3] = me->getLayoutSuppressedCount();
+                values_ptr[4] = me->getActiveSpeakerSwitches();
+                values_ptr[5] = me->getLayoutCompactionCount();
+            })
+        }
+        LayoutPushStats {
+            pushed: values[0],
+            coalesced: values[1],
+            applied: values[2],
+            suppressed: values[3],
+            speaker_switches: values[4],
+            compactions: values[5],
+        }
+    }
+
+    /// How `LayoutMode::ActiveSpeaker` picks the large tile: a speaker keeps
+    /// it for at least `min_dwell`, and a challenger takes over once it has
+    /// been loudest for `hold` with a smoothed volume (0-255) `margin` above
+    /// the current speaker.
+    fn set_active_speaker_tuning(&self, min_dwell: Duration, hold: Duration, margin: u32) {
+        let me = self.raw_ptr();
+        let dwell_ms = min_dwell.as_millis().min(u32::MAX as u128) as u32;
+        let hold_ms = hold.as_millis().min(u32::MAX as u128) as u32;
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", dwell_ms as "uint32_t", hold_ms as "uint32_t", margin as "uint32_t"] {
+                agora::ActiveSpeakerTuning tuning;
+                tuning.m_dwellMs = dwell_ms;
+                tuning.m_holdMs = hold_ms;
+                tuning.m_margin = margin;
+                me->setActiveSpeakerTuning(tuning);
+            })
+        }
+    }
+
+    /// Subscribes to `uids` on top of the current list, for video or audio.
+    /// Changes made within the subscribe debounce window reach the engine as
+    /// one update.
+    fn add_subscribed_uids(&self, video: bool, uids: &[u32]) -> bool {
+        let me = self.raw_ptr();
+        let uids_ptr = uids.as_ptr();
+        let num = uids.len() as u32;
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", video as "bool", uids_ptr as "const uint32_t*", num as "uint32_t"] -> bool as "bool" {
+                if (video)
+                    return me->addSubscribeVideoUids(uids_ptr, num) == 0;
+                return me->addSubscribeAudioUids(uids_ptr, num) == 0;
+            })
+        }
+    }
+
+    fn remove_subscribed_uids(&self, video: bool, uids: &[u32]) -> bool {
+        let me = self.raw_ptr();
+        let uids_ptr = uids.as_ptr();
+        let num = uids.len() as u32;
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", video as "bool", uids_ptr as "const uint32_t*", num as "uint32_t"] -> bool as "bool" {
+                if (video)
+                    return me->removeSubscribeVideoUids(uids_ptr, num) == 0;
+                return me->removeSubscribeAudioUids(uids_ptr, num) == 0;
+            })
+        }
+    }
+
+    fn set_subscribe_debounce_time(&self, window_ms: u32) {
+        let me = self.raw_ptr();
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", window_ms as "uint32_t"] {
+                me->setSubscribeDebounceTime(window_ms);
+            })
+        }
+    }
+
+    fn subscriptions(&self) -> Subscriptions {
+        let me = self.raw_ptr();
+        let mut subscriptions = Subscriptions::default();
+        for &video in &[true, false] {
+            let mut uids: Vec<u32> = Vec::new();
+            let mut version = 0u64;
+            let version_ptr = &mut version as *mut u64;
+            loop {
+                let uids_ptr = uids.as_mut_ptr();
+                let max = uids.capacity();
+                let count = unsafe {
+                    cpp!([me as "agora::AgoraSdk*", video as "bool", uids_ptr as "uint32_t*", max as "size_t",
+                            version_ptr as "uint64_t*"] -> usize as "size_t" {
+                        return me->getSubscribedUids(video, uids_ptr, max, version_ptr);
+                    })
+                };
+                if count <= max {
+                    unsafe { uids.set_len(count) };
+                    break;
+                }
+                uids.reserve(count);
+            }
+            subscriptions.version += version;
+            if video {
+                subscriptions.video = uids;
+            } else {
+                subscriptions.audio = uids;
+            }
+        }
+        subscriptions.engine_updates = unsafe {
+            cpp!([me as "agora::AgoraSdk*"] -> u64 as "uint64_t" {
+                return me->getSubscribeUpdateCount();
+            })
+        };
+        subscriptions
+    }
+
+    /// Keeps every peer in the tile it joined into when others leave. A
+    /// leaver's tile stays empty until the next peer joins, and the tiles are
+    /// only closed up when the layout would move to a different tile size.
+    fn set_stable_layout_slots(&self, stable: bool) {
+        let me = self.raw_ptr();
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", stable as "bool"] {
+                me->setStableLayoutSlots(stable);
+            })
+        }
+    }
+
+    /// The uid in the large tile of `LayoutMode::ActiveSpeaker`, once someone
+    /// has spoken.
+    fn active_speaker(&self) -> Option<u32> {
+        let me = self.raw_ptr();
+        let uid = unsafe {
+            cpp!([me as "agora::AgoraSdk*"] -> u32 as "uint32_t" {
+                return me->getActiveSpeaker();
+            })
+        };
+        if uid == 0 {
+            None
+        } else {
+            Some(uid)
+        }
+    }
+
+    /// Volume (0-255) at which a uid counts as speaking for [`IAgoraSdk::talk_stats`].
+    fn set_talk_threshold(&self, volume: u32) {
+        let me = self.raw_ptr();
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", volume as "uint32_t"] {
+                me->setTalkThreshold(volume);
+            })
+        }
+    }
+
+    /// How often the volume indications publish the talk snapshot; zero
+    /// publishes on every indication. Defaults to one second.
+    fn set_talk_stats_interval(&self, interval: Duration) {
+        let me = self.raw_ptr();
+        let interval_ms = interval.as_millis().min(u32::MAX as u128) as u32;
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", interval_ms as "uint32_t"] {
+                me->setTalkSnapshotInterval(interval_ms);
+            })
+        }
+    }
+
+    /// Speaking time, overlap and silence per uid this session, as of the last
+    /// published snapshot. Needs an audio indication interval in the `Config`.
+    fn talk_stats(&self) -> TalkStats {
+        let me = self.raw_ptr();
+        let mut stats = TalkStats::default();
+        loop {
+            let talkers_ptr = stats.talkers.as_mut_ptr();
+            let max = stats.talkers.capacity();
+            let channel_ptr: *mut TalkChannelStats = &mut stats.channel;
+            let count = unsafe {
+                cpp!([me as "agora::AgoraSdk*", talkers_ptr as "agora::TalkUserStats*", max as "size_t",
+                        channel_ptr as "agora::TalkChannelStats*"] -> usize as "size_t" {
+                    return me->getTalkStats(talkers_ptr, max, *channel_ptr);
+                })
+            };
+            if count <= max {
+                unsafe { stats.talkers.set_len(count) };
+                return stats;
+            }
+            stats.talkers.reserve(count);
+        }
+    }
+
+    /// Per-uid frame accounting for every uid that has sent media this session.
+    fn media_stats(&self) -> Vec<MediaStats> {
+        let me = self.raw_ptr();
+        let count = unsafe {
+            cpp!([me as "agora::AgoraSdk*"] -> usize as "size_t" {
+                return me->getMediaStatsCount();
             })
         };
-        self.events.set_callback(listener);
+        let mut stats = vec![MediaStats::default(); count];
+        let stats_ptr = stats.as_mut_ptr();
+        let len = unsafe {
+            cpp!([me as "agora::AgoraSdk*", stats_ptr as "agora::MediaAccountingEntry*", count as "size_t"] -> usize as "size_t" {
+                return me->getMediaStats(stats_ptr, count);
+            })
+        };
+        stats.truncate(len);
+        stats
     }
 
-    fn set_keep_last_frame(&self, keep: bool) {
+    /// Keeps the last `keep_ms` of encoded audio and video per uid; 0 turns
+    /// retention off. Defaults to the KEEPMEDIATIME environment variable.
+    fn set_media_keep_time(&self, keep_ms: u32) {
         let me = self.raw_ptr();
         unsafe {
-            cpp!([me as "agora::AgoraSdk*", keep as "bool"] {
-                    return me->setKeepLastFrame(keep);
+            cpp!([me as "agora::AgoraSdk*", keep_ms as "uint32_t"] {
+                me->setMediaKeepTime(keep_ms);
+            })
+        }
+    }
+
+    /// The uid's retained frames covering the last `window`, measured back
+    /// from the newest retained frame. Video starts at a keyframe.
+    fn recent_media(&self, uid: u32, window: Duration) -> Vec<RetainedFrame> {
+        let me = self.raw_ptr();
+        let window_ms = duration_ms(window);
+        let mut buffer: *mut u32 = ptr::null_mut();
+        let buffer_ptr = &mut buffer as *mut *mut u32;
+        let frames = unsafe {
+            cpp!([  me as "agora::AgoraSdk*",
+                    uid as "unsigned int",
+                    window_ms as "uint32_t",
+                    buffer_ptr as "agora::FrameBuffer**"] -> *mut u32 as "std::vector<agora::RetainedFrame>*" {
+                std::vector<agora::RetainedFrame> *frames = new std::vector<agora::RetainedFrame>();
+                *buffer_ptr = me->dumpRecentMedia(uid, window_ms, *frames);
+                return frames;
+            })
+        };
+        let count = unsafe {
+            cpp!([frames as "std::vector<agora::RetainedFrame>*"] -> usize as "size_t" {
+                return frames->size();
+            })
+        };
+        let mut retained = Vec::with_capacity(count);
+        if !buffer.is_null() {
+            let buffer = unsafe { FrameBuffer::from_raw(buffer) };
+            for index in 0..count {
+                let mut kind = 0u32;
+                let mut keyframe = false;
+                let mut range = [0usize; 2];
+                let mut video: RawVideoFrame = unsafe { mem::zeroed() };
+                let mut audio: RawAudioFrame = unsafe { mem::zeroed() };
+                let kind_ptr = &mut kind as *mut u32;
+                let keyframe_ptr = &mut keyframe as *mut bool;
+                let range_ptr = range.as_mut_ptr();
+                let video_ptr = &mut video as *mut RawVideoFrame;
+                let audio_ptr = &mut audio as *mut RawAudioFrame;
+                unsafe {
+                    cpp!([  frames as "std::vector<agora::RetainedFrame>*",
+                            index as "size_t",
+                            kind_ptr as "uint32_t*",
+                            keyframe_ptr as "bool*",
+                            range_ptr as "size_t*",
+                            video_ptr as "agora::VideoFrameView*",
+                            audio_ptr as "agora::AudioFrameView*"] {
+                        const agora::RetainedFrame &frame = (*frames)[index];
+                        *kind_ptr = frame.m_type;
+                        *keyframe_ptr = frame.m_keyframe;
+                        range_ptr[0] = frame.m_offset;
+                        range_ptr[1] = frame.m_size;
+                        *video_ptr = frame.m_video;
+                        *audio_ptr = frame.m_audio;
+                    })
                 }
-            )
+                let payload = buffer.slice(range[0], range[1]);
+                let media = if kind == 0 {
+                    unsafe { OwnedVideoFrame::from_pooled(&video, payload) }.map(MediaFrame::Video)
+                } else {
+                    unsafe { OwnedAudioFrame::from_pooled(&audio, payload) }.map(MediaFrame::Audio)
+                };
+                if let Some(media) = media {
+                    retained.push(RetainedFrame {
+                        uid,
+                        keyframe,
+                        media,
+                    });
+                }
+            }
+        }
+        unsafe {
+            cpp!([frames as "std::vector<agora::RetainedFrame>*"] {
+                delete frames;
+            })
         }
+        retained
     }
 
-    fn create_channel(
-        &self,
-        app_id: &str,
-        channel_key: &str,
-        name: &str,
-        uid: u32,
-        config: &Config,
-    ) -> bool {
+    fn retained_uids(&self) -> Vec<u32> {
         let me = self.raw_ptr();
-        let app_id = CString::new(app_id).unwrap().into_raw();
-        let name = CString::new(name).unwrap().into_raw();
-        let channel_key = CString::new(channel_key).unwrap().into_raw();
+        let uids = unsafe {
+            cpp!([me as "agora::AgoraSdk*"] -> *mut u32 as "std::vector<uint32_t>*" {
+                return new std::vector<uint32_t>(me->getRetainedUids());
+            })
+        };
+        let count = unsafe {
+            cpp!([uids as "std::vector<uint32_t>*"] -> usize as "size_t" {
+                return uids->size();
+            })
+        };
+        let mut retained = vec![0u32; count];
+        let retained_ptr = retained.as_mut_ptr();
         unsafe {
-            cpp!([  me as "agora::AgoraSdk*",
-                    app_id as "const char *",
-                    channel_key as "const char *",
-                    name as "const char *",
-                    uid as "int",
-                    config as "agora::recording::RecordingConfig*"
-                    ] -> bool as "bool" {
-                        return me->createChannel(app_id, channel_key, name, uid, *config);
-                    }
-            )
+            cpp!([uids as "std::vector<uint32_t>*", retained_ptr as "uint32_t*"] {
+                std::copy(uids->begin(), uids->end(), retained_ptr);
+                delete uids;
+            })
         }
+        retained
     }
-    fn update_mix_mode_setting(&self, width: u32, height: u32, is_video_mix: bool) {
+
+    /// Routes every decoded frame into `queue` as well as to the listener.
+    /// Only one queue can be attached per recorder.
+    fn attach_frame_queue(&self, queue: &FrameQueue) -> bool {
         let me = self.raw_ptr();
+        let raw = queue.raw;
         unsafe {
-            cpp!([me as "agora::AgoraSdk*",
-                width as "int",
-                height as "int",
-                is_video_mix as "bool"] {
-                    me->updateMixModeSetting(width, height, is_video_mix);
+            cpp!([me as "agora::AgoraSdk*", raw as "agora::FrameQueue*"] -> bool as "bool" {
+                return me->attachFrameQueue(raw);
+            })
+        }
+    }
+
+    /// Makes the next `create_channel` run against a synthetic channel instead
+    /// of AgoraCoreService, for load testing without a live channel.
+    fn use_fake_engine(&self, config: &FakeEngineConfig) {
+        let me = self.raw_ptr();
+        let config = config as *const FakeEngineConfig;
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", config as "const agora::FakeEngineConfig*"] {
+                me->useFakeEngine(*config);
+            })
+        }
+    }
+
+    /// Volume and stats callbacks reach `Listener::stats_batch` in batches of
+    /// up to `capacity` samples per kind, flushed once a batch is `interval`
+    /// old and on leave. A capacity of 1 delivers every sample on its own.
+    fn set_stats_batching(&self, capacity: usize, interval: Duration) {
+        let me = self.raw_ptr();
+        let interval_ms = interval.as_millis().min(u32::MAX as u128) as u32;
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", capacity as "size_t", interval_ms as "uint32_t"] {
+                me->setStatsBatching(capacity, interval_ms);
+            })
+        }
+    }
+
+    /// Listener callbacks queued but not yet delivered.
+    fn pending_events(&self) -> usize {
+        let handler = self.events.raw_ptr();
+        unsafe {
+            cpp!([handler as "agora::recording::IRecordingEngineEventHandler*"] -> usize as "size_t" {
+                AgoraSdkEvents *events = dynamic_cast<AgoraSdkEvents*>(handler);
+                return events ? events->pending() : 0;
+            })
+        }
+    }
+
+    fn release(&self) -> bool {
+        let me = self.raw_ptr();
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*"] -> bool as "bool" {
+                return me->release();
+            })
+        }
+    }
+}
+
+impl Drop for AgoraSdk {
+    fn drop(&mut self) {
+        let me = self.raw_ptr();
+        let handler = self.events.raw_ptr();
+        let manager = self.manager;
+        unsafe {
+            cpp!([me as "agora::AgoraSdk*", handler as "agora::recording::IRecordingEngineEventHandler*", manager as "agora::RecorderManager*"] {
+                //the engine goes first so nothing new arrives, then the listener
+                //is cut off before anything still queued can reach it
+                me->release();
+                AgoraSdkEvents *events = dynamic_cast<AgoraSdkEvents*>(handler);
+                if (events) {
+                    events->detach();
+                    events->waitIdle();
                 }
+                if (manager)
+                    manager->destroySession(me);
+                else
+                    delete me;
+                delete events;
+            })
+        };
+    }
+}
 
-            )
+/// Resource use of one `RecorderManager` session.
+// Mirrors agora::RecorderSessionStats.
+#[repr(C)]
+#[derive(PartialEq, Debug, Default, Clone, Copy)]
+pub struct SessionStats {
+    pub id: u32,
+    pub running: bool,
+    pub peers: u32,
+    pub media_uids: u32,
+    pub audio_frames: u64,
+    pub audio_bytes: u64,
+    pub video_frames: u64,
+    pub video_bytes: u64,
+    pub layout_pushes: u64,
+    pub retained_bytes: u64,
+    pub queued_frames: u64,
+    pub dropped_frames: u64,
+}
+
+/// Hosts many recorders in one process. Each session is an `AgoraSdk` with its
+/// own listener and engine; sessions share `workers` timer threads, `workers`
+/// listener threads and the frame pool instead of each bringing their own. Clones share the manager,
+/// which lives until it and all of its sessions are dropped.
+pub struct RecorderManager {
+    raw: *mut u32,
+}
+
+unsafe impl Send for RecorderManager {}
+unsafe impl Sync for RecorderManager {}
+
+impl RecorderManager {
+    pub fn new(workers: usize) -> Self {
+        let raw = unsafe {
+            cpp!([workers as "size_t"] -> *mut u32 as "agora::RecorderManager*" {
+                return new agora::RecorderManager(workers);
+            })
+        };
+        RecorderManager { raw }
+    }
+
+    pub fn create_session(&self) -> AgoraSdk {
+        let raw = self.raw;
+        let sdk = unsafe {
+            cpp!([raw as "agora::RecorderManager*"] -> *mut u32 as "agora::AgoraSdk*" {
+                return raw->createSession();
+            })
+        };
+        AgoraSdk {
+            sdk,
+            events: AgoraSdkEvents::new(),
+            manager: raw,
+        }
+    }
+
+    /// The session's id, or `None` if it was not created by this manager.
+    pub fn session_id(&self, session: &AgoraSdk) -> Option<u32> {
+        let raw = self.raw;
+        let sdk = session.raw_ptr();
+        let id = unsafe {
+            cpp!([raw as "agora::RecorderManager*", sdk as "agora::AgoraSdk*"] -> u32 as "uint32_t" {
+                return raw->sessionId(sdk);
+            })
+        };
+        if id == 0 {
+            None
+        } else {
+            Some(id)
+        }
+    }
+
+    /// Leaves the session's channel; the session stays until it is dropped.
+    pub fn stop_session(&self, id: u32) -> bool {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::RecorderManager*", id as "uint32_t"] -> bool as "bool" {
+                return raw->stopSession(id);
+            })
+        }
+    }
+
+    pub fn stop_all(&self) {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::RecorderManager*"] {
+                raw->stopAll();
+            })
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::RecorderManager*"] -> usize as "size_t" {
+                return raw->sessionCount();
+            })
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn session_stats(&self, id: u32) -> Option<SessionStats> {
+        let raw = self.raw;
+        let mut stats = SessionStats::default();
+        let stats_ptr = &mut stats as *mut SessionStats;
+        let found = unsafe {
+            cpp!([raw as "agora::RecorderManager*", id as "uint32_t", stats_ptr as "agora::RecorderSessionStats*"] -> bool as "bool" {
+                return raw->getSessionStats(id, *stats_ptr);
+            })
+        };
+        if found {
+            Some(stats)
+        } else {
+            None
+        }
+    }
+
+    /// Counters of the executor that runs this manager's listener callbacks.
+    pub fn event_stats(&self) -> EventExecutorStats {
+        let raw = self.raw;
+        let mut stats = EventExecutorStats::default();
+        let stats_ptr = &mut stats as *mut EventExecutorStats;
+        unsafe {
+            cpp!([raw as "agora::RecorderManager*", stats_ptr as "agora::EventExecutorStats*"] {
+                *stats_ptr = raw->events()->stats();
+            })
+        }
+        stats
+    }
+
+    pub fn stats(&self) -> Vec<SessionStats> {
+        let raw = self.raw;
+        let all = unsafe {
+            cpp!([raw as "agora::RecorderManager*"] -> *mut u32 as "std::vector<agora::RecorderSessionStats>*" {
+                return new std::vector<agora::RecorderSessionStats>(raw->getStats());
+            })
+        };
+        let count = unsafe {
+            cpp!([all as "std::vector<agora::RecorderSessionStats>*"] -> usize as "size_t" {
+                return all->size();
+            })
+        };
+        let mut stats = vec![SessionStats::default(); count];
+        let stats_ptr = stats.as_mut_ptr();
+        unsafe {
+            cpp!([all as "std::vector<agora::RecorderSessionStats>*", stats_ptr as "agora::RecorderSessionStats*"] {
+                std::copy(all->begin(), all->end(), stats_ptr);
+                delete all;
+            })
+        }
+        stats
+    }
+}
+
+impl Clone for RecorderManager {
+    fn clone(&self) -> Self {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::RecorderManager*"] {
+                raw->retain();
+            })
+        }
+        RecorderManager { raw }
+    }
+}
+
+impl Drop for RecorderManager {
+    fn drop(&mut self) {
+        let raw = self.raw;
+        unsafe {
+            cpp!([raw as "agora::RecorderManager*"] {
+                raw->release();
+            })
+        }
+    }
+}
+
+/// Number of C++ allocations made so far, or `None` unless built with the
+/// `alloc-counters` feature.
+pub fn cpp_alloc_count() -> Option<u64> {
+    let enabled = unsafe {
+        cpp!([] -> bool as "bool" {
+            return agora::allocCountersEnabled();
+        })
+    };
+    if !enabled {
+        return None;
+    }
+    Some(unsafe {
+        cpp!([] -> u64 as "uint64_t" {
+            return agora::allocCount();
+        })
+    })
+}
+
+/// A recorder on a stub engine with `participants` peers, for benchmarking the
+/// layout path without a channel.
+#[doc(hidden)]
+pub struct LayoutBench {
+    sdk: *mut u32,
+    participants: u32,
+}
+
+impl LayoutBench {
+    pub fn new(mode: LayoutMode, participants: u32) -> Self {
+        let mode = mode.value();
+        let sdk = unsafe {
+            cpp!([mode as "int", participants as "uint32_t"] -> *mut u32 as "agora::AgoraSdk*" {
+                agora::AgoraSdk *sdk = new agora::AgoraSdk();
+                sdk->attachEngine(new agora::StubRecordingEngine());
+                sdk->updateMixModeSetting(1280, 720, true);
+                sdk->updateLayoutSetting(mode, 1, "");
+                for (uint32_t uid = 1; uid <= participants; uid++)
+                    sdk->addPeer(uid);
+                return sdk;
+            })
+        };
+        LayoutBench { sdk, participants }
+    }
+
+    /// A recorder with no peers on a fake channel joined with a user account,
+    /// giving `max_resolution_account` the large tile. Peers join with `join`
+    /// and get their accounts with `register`.
+    pub fn with_user_account(mode: LayoutMode, max_resolution_account: &str) -> Self {
+        let mode = mode.value();
+        let account = CString::new(max_resolution_account).unwrap();
+        let account_ptr = account.as_ptr();
+        let sdk = unsafe {
+            cpp!([mode as "int", account_ptr as "const char*"] -> *mut u32 as "agora::AgoraSdk*" {
+                agora::AgoraSdk *sdk = new agora::AgoraSdk();
+                agora::FakeEngineConfig fake;
+                fake.m_users = 0;
+                fake.m_statsIntervalMs = 0;
+                sdk->useFakeEngine(fake);
+                sdk->updateMixModeSetting(1280, 720, true);
+                sdk->updateLayoutSetting(mode, 0, account_ptr);
+                agora::recording::RecordingConfig config;
+                sdk->createChannelWithUserAccount("", "", "bench", "bench", config);
+                return sdk;
+            })
+        };
+        LayoutBench { sdk, participants: 0 }
+    }
+
+    pub fn register(&self, uid: u32, account: &str) {
+        let sdk = self.sdk;
+        let account = CString::new(account).unwrap();
+        let account_ptr = account.as_ptr();
+        unsafe {
+            cpp!([sdk as "agora::AgoraSdk*", uid as "uint32_t", account_ptr as "const char*"] {
+                sdk->userInfoUpdated(uid, account_ptr);
+            })
+        }
+    }
+
+    /// `uid` becomes the active speaker, as if the engine had reported it.
+    pub fn speak(&self, uid: u32) {
+        let sdk = self.sdk;
+        unsafe {
+            cpp!([sdk as "agora::AgoraSdk*", uid as "uint32_t"] {
+                sdk->activeSpeaker(uid);
+            })
+        }
+    }
+
+    /// The regions the engine last accepted.
+    pub fn regions(&self) -> Vec<Region> {
+        let sdk = self.sdk;
+        let count = unsafe {
+            cpp!([sdk as "agora::AgoraSdk*"] -> usize as "size_t" {
+                return sdk->getAppliedRegions(NULL, 0);
+            })
+        };
+        let mut regions = vec![Region::default(); count];
+        let regions_ptr = regions.as_mut_ptr();
+        let len = unsafe {
+            cpp!([sdk as "agora::AgoraSdk*", regions_ptr as "agora::linuxsdk::VideoMixingLayout::Region*",
+                    count as "size_t"] -> usize as "size_t" {
+                return sdk->getAppliedRegions(regions_ptr, count);
+            })
+        };
+        regions.truncate(len);
+        regions
+    }
+
+    /// Recomputes the layout for the current peers. Nothing has changed since
+    /// the last one, so it stops at the diff against the applied layout.
+    pub fn push(&self) -> u32 {
+        let sdk = self.sdk;
+        unsafe {
+            cpp!([sdk as "agora::AgoraSdk*"] -> u32 as "int" {
+                return sdk->setVideoMixLayout();
+            })
+        }
+    }
+
+    /// The newest peer leaves and rejoins, pushing a layout each time.
+    pub fn churn(&self) {
+        let sdk = self.sdk;
+        let uid = self.participants;
+        unsafe {
+            cpp!([sdk as "agora::AgoraSdk*", uid as "uint32_t"] {
+                sdk->removePeer(uid);
+                sdk->addPeer(uid);
+            })
+        }
+    }
+
+    /// Requests within `window_ms` of the first go out as one push; 0 pushes
+    /// each one at once and flushes the one waiting, if any.
+    pub fn set_layout_debounce_time(&self, window_ms: u32) {
+        let sdk = self.sdk;
+        unsafe {
+            cpp!([sdk as "agora::AgoraSdk*", window_ms as "uint32_t"] {
+                sdk->setLayoutDebounceTime(window_ms);
+            })
+        }
+    }
+
+    pub fn set_stable_slots(&self, stable: bool) {
+        let sdk = self.sdk;
+        unsafe {
+            cpp!([sdk as "agora::AgoraSdk*", stable as "bool"] {
+                sdk->setStableLayoutSlots(stable);
+            })
+        }
+    }
+
+    pub fn join(&self, uid: u32) {
+        let sdk = self.sdk;
+        unsafe {
+            cpp!([sdk as "agora::AgoraSdk*", uid as "uint32_t"] {
+                sdk->addPeer(uid);
+            })
+        }
+    }
+
+    pub fn leave(&self, uid: u32) {
+        let sdk = self.sdk;
+        unsafe {
+            cpp!([sdk as "agora::AgoraSdk*", uid as "uint32_t"] {
+                sdk->removePeer(uid);
+            })
+        }
+    }
+
+    /// Layout templates the recorder has cached.
+    pub fn cached_templates(&self) -> usize {
+        let sdk = self.sdk;
+        unsafe {
+            cpp!([sdk as "agora::AgoraSdk*"] -> usize as "size_t" {
+                return sdk->getLayoutTemplateCount();
+            })
         }
     }
 
-    fn leave_channel(&self) -> bool {
-        let me = self.raw_ptr();
+    pub fn stats(&self) -> LayoutPushStats {
+        let sdk = self.sdk;
+        let mut values = [0u64; 5];
+        let values_ptr = values.as_mut_ptr();
         unsafe {
-            cpp!([me as "agora::AgoraSdk*"] -> bool as "bool" {
-                    return me->leaveChannel();
-                }
-            )
+            cpp!([sdk as "agora::AgoraSdk*", values_ptr as "uint64_t*"] {
+                values_ptr[0] = sdk->getLayoutPushCount();
+                values_ptr[1] = sdk->getLayoutCoalescedCount();
+                values_ptr[2] = sdk->getLayoutAppliedCount();
+                values_ptr[3] = sdk->getLayoutSuppressedCount();
+                values_ptr[4] = sdk->getLayoutCompactionCount();
+            })
+        }
+        LayoutPushStats {
+            pushed: values[0],
+            coalesced: values[1],
+            applied: values[2],
+            suppressed: values[3],
+            compactions: values[4],
+            ..LayoutPushStats::default()
         }
     }
+}
 
-    fn set_video_mixing_layout(&self, layout: &Layout) -> u32 {
-        let me = self.raw_ptr();
+impl Drop for LayoutBench {
+    fn drop(&mut self) {
+        let sdk = self.sdk;
         unsafe {
-            cpp!([  me as "agora::AgoraSdk*",
-                    layout as "agora::linuxsdk::VideoMixingLayout*"] -> u32 as "int" {
-                return me->setVideoMixingLayout(*layout);
+            cpp!([sdk as "agora::AgoraSdk*"] {
+                delete sdk;
             })
         }
     }
+}
 
-    fn release(&self) -> bool {
-        let me = self.raw_ptr();
+/// A subscribe list as the recorder reads `Config` subscribe lists: distinct
+/// uids in ascending order, with the entries it had to leave out.
+#[derive(PartialEq, Debug, Default, Clone)]
+pub struct UidList {
+    pub uids: Vec<u32>,
+    pub duplicates: usize,
+    pub malformed: usize,
+    /// Byte range of the first malformed entry in the list.
+    pub first_malformed: Option<std::ops::Range<usize>>,
+}
+
+/// Parses a comma separated uid list the way `create_channel` does, to check
+/// a whitelist before joining with it.
+pub fn parse_uid_list(list: &str) -> UidList {
+    let list_ptr = list.as_ptr();
+    let length = list.len();
+    // every entry takes at least a digit and a comma
+    let mut uids: Vec<u32> = Vec::with_capacity(length / 2 + 1);
+    let uids_ptr = uids.as_mut_ptr();
+    let mut counts = [0usize; 5];
+    let counts_ptr = counts.as_mut_ptr();
+    unsafe {
+        cpp!([list_ptr as "const char*", length as "size_t", uids_ptr as "uint32_t*", counts_ptr as "size_t*"] {
+            std::vector<agora::linuxsdk::uid_t> parsed;
+            agora::ListParseReport report;
+            agora::parseUidList(list_ptr, length, parsed, report);
+            std::copy(parsed.begin(), parsed.end(), uids_ptr);
+            counts_ptr[0] = report.m_entries;
+            counts_ptr[1] = report.m_duplicates;
+            counts_ptr[2] = report.m_malformed;
+            counts_ptr[3] = report.m_firstMalformed.m_offset;
+            counts_ptr[4] = report.m_firstMalformed.m_length;
+        });
+        uids.set_len(counts[0]);
+    }
+    UidList {
+        uids,
+        duplicates: counts[1],
+        malformed: counts[2],
+        first_malformed: if counts[2] > 0 {
+            Some(counts[3]..counts[3] + counts[4])
+        } else {
+            None
+        },
+    }
+}
+
+/// Containers a subscription membership check can go through.
+#[derive(PartialEq, Debug, Clone, Copy)]
+pub enum MembershipSet {
+    /// Sorted uid array with SIMD probing, as subscriptions are kept now.
+    FlatUids = 0,
+    /// `std::unordered_set`, as subscriptions used to be kept.
+    HashedUids = 1,
+    FlatAccounts = 2,
+    /// `std::set<std::string>`.
+    TreeAccounts = 3,
+}
+
+/// A subscription set with `entries` members and a batch of 256 probes,
+/// about half of them hits, for the membership benchmarks.
+pub struct MembershipBench {
+    bench: *mut u32,
+}
+
+impl MembershipBench {
+    pub fn new(set: MembershipSet, entries: usize) -> Self {
+        let set = set as i32;
+        let bench = unsafe {
+            cpp!([set as "int", entries as "size_t"] -> *mut u32 as "agora::MembershipBench*" {
+                return new agora::MembershipBench(set, entries);
+            })
+        };
+        MembershipBench { bench }
+    }
+
+    /// Runs the probes and returns the hits.
+    pub fn probe(&self) -> usize {
+        let bench = self.bench;
         unsafe {
-            cpp!([me as "agora::AgoraSdk*"] -> bool as "bool" {
-                return me->release();
+            cpp!([bench as "agora::MembershipBench*"] -> usize as "size_t" {
+                return bench->probe();
             })
         }
     }
 }
 
-impl Drop for AgoraSdk {
+impl Drop for MembershipBench {
     fn drop(&mut self) {
-        self.leave_channel();
-        let me = self.raw_ptr();
+        let bench = self.bench;
         unsafe {
-            cpp!([me as "agora::AgoraSdk*"] {
-                delete me;
+            cpp!([bench as "agora::MembershipBench*"] {
+                delete bench;
             })
-        };
+        }
     }
 }
 
@@ -875,6 +2964,7 @@ pub fn token() -> Result<String, String> {
 mod tests {
     use super::*;
     use std::cell::RefCell;
+    use std::collections::HashMap;
     use std::fs::{self, File};
     use std::io::prelude::*;
     use std::rc::Rc;
@@ -1013,6 +3103,1074 @@ mod tests {
         sdk.set_keep_last_frame(true);
     }
 
+    #[test]
+    fn recorder_layout_debounce_time() {
+        let sdk = AgoraSdk::new();
+        sdk.set_layout_debounce_time(100);
+        assert!(sdk.layout_push_stats() == LayoutPushStats::default());
+
+        // the window outlasts the burst, so nothing goes out until closing it
+        // flushes the one layout left waiting
+        let bench = LayoutBench::new(LayoutMode::BestFit, 4);
+        let before = bench.stats();
+        bench.set_layout_debounce_time(60_000);
+        let burst = 8;
+        for uid in 10..10 + burst {
+            bench.join(uid);
+        }
+        assert_eq!(bench.stats().pushed, before.pushed);
+        bench.set_layout_debounce_time(0);
+        let after = bench.stats();
+        assert_eq!(after.pushed, before.pushed + 1);
+        assert_eq!(after.coalesced, before.coalesced + burst as u64 - 1);
+        assert_eq!(after.applied, before.applied + 1);
+    }
+
+    struct QuietListener;
+
+    impl Listener for QuietListener {
+        fn error(&self, _error: u32, _stat_code: u32) {}
+        fn joined(&mut self, _uid: u32) {}
+        fn left(&mut self, _uid: u32) {}
+        fn channel_joined(&mut self, _channel: String, _uid: u32) {}
+    }
+
+    // Joins a fake channel of `users` peers (uids 1000 and up) that send no
+    // media, with a user account when `account` is set. The engine's callbacks
+    // only reach the recorder through a listener, so a quiet one is set.
+    fn fake_channel(sdk: &mut AgoraSdk, users: u32, config: &Config, account: Option<&str>) {
+        sdk.set_listener(Box::new(QuietListener));
+        sdk.use_fake_engine(&FakeEngineConfig {
+            users,
+            video_fps: 0,
+            audio_frame_ms: 0,
+            ..FakeEngineConfig::default()
+        });
+        let joined = match account {
+            Some(account) => sdk.create_channel_with_user_account("", "", "fake", account, config),
+            None => sdk.create_channel("", "", "fake", 1, config),
+        };
+        assert!(joined);
+    }
+
+    // Polls until `done` holds; the deadline only catches a hung engine.
+    fn wait_until<F: FnMut() -> bool>(mut done: F) {
+        let deadline = time::Instant::now() + time::Duration::from_secs(10);
+        while !done() {
+            assert!(time::Instant::now() < deadline, "timed out");
+            thread::sleep(time::Duration::from_millis(5));
+        }
+    }
+
+    #[test]
+    fn recorder_no_layout_after_leave() {
+        let mut sdk = AgoraSdk::new();
+        sdk.update_mix_mode_setting(1280, 720, true);
+        let config = Config::new();
+        fake_channel(&mut sdk, 2, &config, None);
+        wait_until(|| sdk.layout_push_stats().pushed >= 2);
+        assert!(sdk.leave_channel());
+        let pushed = sdk.layout_push_stats().pushed;
+        sdk.set_stable_layout_slots(true);
+        sdk.set_stable_layout_slots(false);
+        assert_eq!(sdk.layout_push_stats().pushed, pushed);
+    }
+
+    #[test]
+    fn recorder_active_speaker_layout() {
+        let mut sdk = AgoraSdk::new();
+        sdk.update_mix_mode_setting(1280, 720, true);
+        sdk.update_layout_setting(LayoutMode::ActiveSpeaker, 0, "");
+        let min_dwell = Duration::from_millis(300);
+        sdk.set_active_speaker_tuning(min_dwell, Duration::from_millis(100), 16);
+        let config = Config::new();
+        config.set_audio_indication_interval(20);
+        let started = time::Instant::now();
+        fake_channel(&mut sdk, 4, &config, None);
+        wait_until(|| sdk.layout_push_stats().speaker_switches >= 1);
+        let speaker = sdk.active_speaker();
+        let stats = sdk.layout_push_stats();
+        let elapsed = started.elapsed();
+        assert!(sdk.leave_channel());
+        assert!(speaker.map_or(false, |uid| uid >= 1000 && uid < 1004));
+        // random volumes change the loudest peer every indication, but a
+        // speaker keeps the tile for at least min_dwell
+        let dwells = elapsed.as_millis() / min_dwell.as_millis();
+        assert!(stats.speaker_switches as u128 <= dwells + 1);
+
+        // with a user account, peers whose account is unknown get no tile
+        // until the large tile has a uid, as in vertical presentation
+        let bench = LayoutBench::with_user_account(LayoutMode::ActiveSpeaker, "host");
+        for uid in 1..=3 {
+            bench.join(uid);
+        }
+        bench.register(1, "guest-1");
+        bench.register(2, "guest-2");
+        bench.push();
+        let mut uids: Vec<u32> = bench.regions().iter().map(|r| r.uid()).collect();
+        uids.sort();
+        assert_eq!(uids, vec![1, 2]);
+        bench.speak(3);
+        bench.push();
+        let regions = bench.regions();
+        let mut uids: Vec<u32> = regions.iter().map(|r| r.uid()).collect();
+        uids.sort();
+        assert_eq!(uids, vec![1, 2, 3]);
+        let largest = regions
+            .iter()
+            .max_by(|a, b| {
+                (a.width() * a.height())
+                    .partial_cmp(&(b.width() * b.height()))
+                    .unwrap()
+            })
+            .unwrap();
+        assert_eq!(largest.uid(), 3);
+    }
+
+    #[test]
+    fn recorder_talk_stats() {
+        let mut sdk = AgoraSdk::new();
+        sdk.set_talk_threshold(128);
+        sdk.set_talk_stats_interval(Duration::from_millis(100));
+        let config = Config::new();
+        config.set_audio_indication_interval(20);
+        fake_channel(&mut sdk, 4, &config, None);
+        // random volumes put each uid above the threshold about half the time,
+        // so everyone has spoken and been quiet after a few indications
+        let mut stats = TalkStats::default();
+        wait_until(|| {
+            stats = sdk.talk_stats();
+            stats.talkers.len() == 4
+                && stats.channel.elapsed_ms >= 500
+                && stats
+                    .talkers
+                    .iter()
+                    .all(|t| t.speaking_ms > 0 && t.speaking_ms < t.present_ms)
+        });
+        assert!(sdk.leave_channel());
+        let channel = stats.channel;
+        assert_eq!(channel.speech_ms + channel.silence_ms, channel.elapsed_ms);
+        assert!(channel.overlap_ms <= channel.speech_ms);
+        let ratios: f64 = stats.talkers.iter().map(|t| stats.talk_ratio(t.uid)).sum();
+        assert!((ratios - 1.0).abs() < 1e-9);
+        for talker in &stats.talkers {
+            assert!(talker.uid >= 1000 && talker.uid < 1004);
+            assert!(talker.overlap_ms <= talker.speaking_ms);
+            assert!(talker.speaking_ms <= channel.speech_ms);
+            assert!(talker.silence_ratio() > 0.0 && talker.silence_ratio() < 1.0);
+        }
+    }
+
+    #[test]
+    fn recorder_user_account_directory() {
+        let mut sdk = AgoraSdk::new();
+        fake_channel(&mut sdk, 3, &Config::new(), Some("recorder"));
+        wait_until(|| {
+            sdk.user_accounts(&[1000, 1001, 1002])
+                .iter()
+                .all(Option::is_some)
+        });
+        let accounts = sdk.user_accounts(&[1000, 1002, 7]);
+        let uids = sdk.uids_by_user_accounts(&["user-1001", "nobody"]);
+        assert!(sdk.leave_channel());
+        assert_eq!(
+            accounts,
+            vec![
+                Some("user-1000".to_string()),
+                Some("user-1002".to_string()),
+                None
+            ]
+        );
+        assert_eq!(uids, vec![Some(1001), None]);
+    }
+
+    #[test]
+    fn recorder_subscription_deltas() {
+        let mut sdk = AgoraSdk::new();
+        let config = Config::new();
+        config.set_auto_subscribe(false);
+        config.set_subscribe_video_uids("1000");
+        fake_channel(&mut sdk, 4, &config, None);
+        // a window nothing can outlast holds the changes until closing it
+        // flushes them
+        sdk.set_subscribe_debounce_time(60_000);
+        assert!(sdk.add_subscribed_uids(true, &[1001, 1002]));
+        assert!(sdk.remove_subscribed_uids(true, &[1000]));
+        assert!(sdk.add_subscribed_uids(false, &[1003]));
+        let subscriptions = sdk.subscriptions();
+        sdk.set_subscribe_debounce_time(0);
+        let flushed = sdk.subscriptions();
+        assert!(sdk.leave_channel());
+        assert_eq!(subscriptions.video, vec![1001, 1002]);
+        assert_eq!(subscriptions.audio, vec![1003]);
+        assert_eq!(subscriptions.engine_updates, 0);
+        // one list per media kind for the three changes
+        assert_eq!(flushed.engine_updates, 2);
+        assert_eq!(flushed.version, subscriptions.version);
+    }
+
+    #[test]
+    fn uid_list_parsing() {
+        let list = parse_uid_list("3, 1,2,,x1, 99999999999, 2,0 ");
+        assert_eq!(list.uids, vec![1, 2, 3]);
+        assert_eq!(list.duplicates, 1);
+        assert_eq!(list.malformed, 3);
+        assert_eq!(list.first_malformed, Some(8..10));
+
+        let whitelist: Vec<String> = (1..=50_000u32).rev().map(|uid| uid.to_string()).collect();
+        let list = parse_uid_list(&whitelist.join(","));
+        assert_eq!(list.uids.len(), 50_000);
+        assert_eq!(list.uids[0], 1);
+        assert_eq!(list.malformed, 0);
+    }
+
+    #[test]
+    fn membership_sets_agree() {
+        for &entries in &[10, 1000] {
+            let hits = MembershipBench::new(MembershipSet::HashedUids, entries).probe();
+            assert!(hits > 0 && hits < 256);
+            for &set in &[
+                MembershipSet::FlatUids,
+                MembershipSet::FlatAccounts,
+                MembershipSet::TreeAccounts,
+            ] {
+                assert_eq!(MembershipBench::new(set, entries).probe(), hits);
+            }
+        }
+    }
+
+    const JOIN: u32 = 0;
+    const JOIN_HIDDEN: u32 = 1;
+    const LEAVE: u32 = 2;
+    const SHOW: u32 = 3;
+    const HIDE: u32 = 4;
+    const READ: u32 = 5;
+
+    // Runs [op, uid] steps on a fresh PeerRoster and returns its visible peers.
+    fn roster_visible(steps: &[[u32; 2]]) -> Vec<u32> {
+        let steps_ptr = steps.as_ptr() as *const u32;
+        let count = steps.len();
+        let mut uids = vec![0u32; count];
+        let uids_ptr = uids.as_mut_ptr();
+        let len = unsafe {
+            cpp!([steps_ptr as "const uint32_t*", count as "size_t", uids_ptr as "uint32_t*"] -> usize as "size_t" {
+                agora::PeerRoster roster;
+                for (size_t i = 0; i < count; i++) {
+                    uint32_t uid = steps_ptr[2 * i + 1];
+                    switch (steps_ptr[2 * i]) {
+                        case 0: roster.add(uid, true); break;
+                        case 1: roster.add(uid, false); break;
+                        case 2: roster.remove(uid); break;
+                        case 3: roster.setVisible(uid, true); break;
+                        case 4: roster.setVisible(uid, false); break;
+                        default: roster.visible(); break;
+                    }
+                }
+                const std::vector<agora::linuxsdk::uid_t> &visible = roster.visible();
+                std::copy(visible.begin(), visible.end(), uids_ptr);
+                return visible.size();
+            })
+        };
+        uids.truncate(len);
+        uids
+    }
+
+    #[test]
+    fn peer_roster_join_order() {
+        let joins = [[JOIN, 1], [JOIN, 2], [JOIN_HIDDEN, 3], [JOIN, 4]];
+        assert_eq!(roster_visible(&joins), vec![1, 2, 4]);
+
+        let mut steps = joins.to_vec();
+        steps.extend_from_slice(&[[LEAVE, 2], [LEAVE, 9]]);
+        assert_eq!(roster_visible(&steps), vec![1, 4]);
+
+        // resubscribed peers go back to their join position, not the end
+        steps.extend_from_slice(&[[SHOW, 3], [HIDE, 1], [READ, 0], [SHOW, 1]]);
+        assert_eq!(roster_visible(&steps), vec![1, 3, 4]);
+
+        // a rejoin counts as a new join, before and after a rebuild
+        steps.extend_from_slice(&[[JOIN, 2], [JOIN, 1]]);
+        assert_eq!(roster_visible(&steps), vec![1, 3, 4, 2]);
+        steps.extend_from_slice(&[[READ, 0], [LEAVE, 1], [JOIN, 1], [JOIN_HIDDEN, 5]]);
+        assert_eq!(roster_visible(&steps), vec![3, 4, 2, 1]);
+    }
+
+    #[test]
+    fn layout_unchanged_pushes_suppressed() {
+        let bench = LayoutBench::new(LayoutMode::BestFit, 4);
+        assert_eq!(bench.stats().applied, 4);
+        for _ in 0..3 {
+            assert_eq!(bench.push(), 0);
+        }
+        bench.churn();
+        let stats = bench.stats();
+        assert_eq!(stats.suppressed, 3);
+        assert_eq!(stats.applied, 6);
+    }
+
+    fn regions_by_uid(bench: &LayoutBench) -> HashMap<u32, [f64; 4]> {
+        bench
+            .regions()
+            .iter()
+            .map(|r| (r.uid(), [r.x(), r.y(), r.width(), r.height()]))
+            .collect()
+    }
+
+    #[test]
+    fn layout_stable_slots() {
+        let bench = LayoutBench::new(LayoutMode::BestFit, 9);
+        bench.set_stable_slots(true);
+        let full = regions_by_uid(&bench);
+        assert_eq!(full.len(), 9);
+
+        // 8 of 9 slots still fit the 3x3 grid, so the hole stays for a joiner
+        bench.leave(2);
+        let mut expected = full.clone();
+        let hole = expected.remove(&2).unwrap();
+        assert_eq!(regions_by_uid(&bench), expected);
+
+        bench.join(10);
+        expected.insert(10, hole);
+        assert_eq!(regions_by_uid(&bench), expected);
+
+        for uid in 3..7 {
+            bench.leave(uid);
+        }
+        assert_eq!(bench.stats().compactions, 0);
+        // 4 peers fit a 2x2 grid with larger tiles
+        bench.leave(7);
+        assert_eq!(bench.stats().compactions, 1);
+    }
+
+    #[test]
+    fn layout_cache_bounded() {
+        // uid 1 has the large tile; moving it to the back after every join
+        // gives each count a new slot for it, two new templates per join
+        let bench = LayoutBench::new(LayoutMode::VerticalPresentation, 1);
+        for uid in 2..=80 {
+            bench.join(uid);
+            bench.leave(1);
+            bench.join(1);
+            assert!(bench.cached_templates() <= 64);
+        }
+        assert_eq!(bench.cached_templates(), 64);
+        assert_eq!(bench.regions().len(), 80);
+    }
+
+    #[test]
+    fn layout_past_seventeen_participants() {
+        for &mode in &[LayoutMode::BestFit, LayoutMode::VerticalPresentation] {
+            for &participants in &[18, 64] {
+                let bench = LayoutBench::new(mode, participants);
+                assert_eq!(bench.push(), 0);
+                bench.churn();
+                let regions = bench.regions();
+                let uids: Vec<u32> = regions.iter().map(|r| r.uid()).collect();
+                assert_eq!(uids, (1..=participants).collect::<Vec<u32>>());
+            }
+        }
+        let applied = |mode: LayoutMode, participants: u32| -> Vec<[f64; 4]> {
+            let bench = LayoutBench::new(mode, participants);
+            bench
+                .regions()
+                .iter()
+                .map(|r| [r.x(), r.y(), r.width(), r.height()])
+                .collect()
+        };
+
+        // 5x5 with the short last row centred, and a full 8x8
+        let best_fit = applied(LayoutMode::BestFit, 18);
+        assert_same_regions(&best_fit, &grid_regions(18, 5, 1.0 / 5.0), "best fit 18");
+        let best_fit = applied(LayoutMode::BestFit, 64);
+        assert_same_regions(&best_fit, &grid_regions(64, 8, 1.0 / 8.0), "best fit 64");
+
+        // no large tile: two columns of 9, and four of 16
+        let strip = solved_regions(LayoutMode::VerticalPresentation, 18, -1);
+        assert_same_regions(&strip, &strip_regions(18, 1.0 / 9.0), "presentation 18");
+        let strip = solved_regions(LayoutMode::VerticalPresentation, 64, -1);
+        assert_same_regions(&strip, &strip_regions(64, 1.0 / 16.0), "presentation 64");
+
+        // uid 1 gets everything left of the strip holding the others
+        let mut expected = vec![[0.0, 0.0, 1.0 - 2.0 / 9.0, 1.0]];
+        expected.extend(strip_regions(17, 1.0 / 9.0));
+        let presentation = applied(LayoutMode::VerticalPresentation, 18);
+        assert_same_regions(&presentation, &expected, "presentation 18 with max uid");
+        let mut expected = vec![[0.0, 0.0, 1.0 - 4.0 / 16.0, 1.0]];
+        expected.extend(strip_regions(63, 1.0 / 16.0));
+        let presentation = applied(LayoutMode::VerticalPresentation, 64);
+        assert_same_regions(&presentation, &expected, "presentation 64 with max uid");
+    }
+
+    // `count` square tiles row by row, `columns` to a row, in a block centred
+    // on the canvas; a short last row is centred too.
+    fn grid_regions(count: usize, columns: usize, tile: f64) -> Vec<[f64; 4]> {
+        let rows = (count + columns - 1) / columns;
+        let top = (1.0 - rows as f64 * tile) / 2.0;
+        (0..count)
+            .map(|i| {
+                let (row, column) = (i / columns, i % columns);
+                let in_row = (count - row * columns).min(columns);
+                let left = (columns - in_row) as f64 * tile / 2.0;
+                let (x, y) = (left + column as f64 * tile, top + row as f64 * tile);
+                [x, y, tile, tile]
+            })
+            .collect()
+    }
+
+    // `count` square tiles column by column against the right edge.
+    fn strip_regions(count: usize, tile: f64) -> Vec<[f64; 4]> {
+        let per_column = (1.0 / tile).round() as usize;
+        let columns = (count + per_column - 1) / per_column;
+        let left = 1.0 - columns as f64 * tile;
+        (0..count)
+            .map(|i| {
+                let (column, row) = (i / per_column, i % per_column);
+                [left + column as f64 * tile, row as f64 * tile, tile, tile]
+            })
+            .collect()
+    }
+
+    // Region geometry (x, y, width, height) of the layouts the recorder built
+    // before the solvers, for uids 1..=N. The presentation tables have no
+    // max uid, and the max uid in the middle slot (N / 2).
+    const LEGACY_BEST_FIT: &[&[[f64; 4]]] = &[
+        &[[0.0, 0.0, 1.0, 1.0]],
+        &[[0.0, 0.0, 1.0 / 2.0, 1.0], [1.0 / 2.0, 0.0, 1.0 / 2.0, 1.0]],
+        &[
+            [0.0, 0.0, 1.0 / 2.0, 1.0 / 2.0],
+            [1.0 / 2.0, 0.0, 1.0 / 2.0, 1.0 / 2.0],
+            [0.0, 1.0 / 2.0, 1.0 / 2.0, 1.0 / 2.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 2.0, 1.0 / 2.0],
+            [1.0 / 2.0, 0.0, 1.0 / 2.0, 1.0 / 2.0],
+            [0.0, 1.0 / 2.0, 1.0 / 2.0, 1.0 / 2.0],
+            [1.0 / 2.0, 1.0 / 2.0, 1.0 / 2.0, 1.0 / 2.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [2.0 / 3.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [0.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [2.0 / 3.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [0.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [2.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [2.0 / 3.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [0.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [2.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [0.0, 2.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [2.0 / 3.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [0.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [2.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [0.0, 2.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 2.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [2.0 / 3.0, 0.0, 1.0 / 3.0, 1.0 / 3.0],
+            [0.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [2.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [0.0, 2.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [1.0 / 3.0, 2.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+            [2.0 / 3.0, 2.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+        ],
+        &[
+            [0.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 0.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 4.0],
+            [0.0, 3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 4.0, 3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [1.0 / 2.0, 3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+            [3.0 / 4.0, 3.0 / 4.0, 1.0 / 4.0, 1.0 / 4.0],
+        ],
+        &[
+            [1.0 / 10.0, 0.0, 1.0 / 5.0, 1.0 / 5.0],
+            [3.0 / 10.0, 0.0, 1.0 / 5.0, 1.0 / 5.0],
+            [1.0 / 2.0, 0.0, 1.0 / 5.0, 1.0 / 5.0],
+            [7.0 / 10.0, 0.0, 1.0 / 5.0, 1.0 / 5.0],
+            [1.0 / 10.0, 1.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [3.0 / 10.0, 1.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [1.0 / 2.0, 1.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [7.0 / 10.0, 1.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [1.0 / 10.0, 2.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [3.0 / 10.0, 2.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [1.0 / 2.0, 2.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [7.0 / 10.0, 2.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [1.0 / 10.0, 3.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [3.0 / 10.0, 3.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [1.0 / 2.0, 3.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [7.0 / 10.0, 3.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+            [2.0 / 5.0, 4.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0],
+        ],
+    ];
+    const LEGACY_PRESENTATION: &[&[[f64; 4]]] = &[
+        &[[4.0 / 5.0, 0.0, 1.0 / 5.0, 1.0 / 4.0]],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 5.0, 1.0 / 4.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 5.0, 1.0 / 4.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 5.0, 1.0 / 4.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 5.0, 1.0 / 4.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 5.0, 1.0 / 4.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 5.0, 1.0 / 4.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 5.0, 1.0 / 4.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 5.0, 1.0 / 4.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 5.0, 1.0 / 4.0],
+        ],
+        &[
+            [6.0 / 7.0, 0.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 1.0 / 6.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 1.0 / 3.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 1.0 / 2.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 2.0 / 3.0, 1.0 / 7.0, 1.0 / 6.0],
+        ],
+        &[
+            [6.0 / 7.0, 0.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 1.0 / 6.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 1.0 / 3.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 1.0 / 2.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 2.0 / 3.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 5.0 / 6.0, 1.0 / 7.0, 1.0 / 6.0],
+        ],
+        &[
+            [8.0 / 9.0, 0.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 1.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 1.0 / 4.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 3.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 1.0 / 2.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 5.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 3.0 / 4.0, 1.0 / 9.0, 1.0 / 8.0],
+        ],
+        &[
+            [8.0 / 9.0, 0.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 1.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 1.0 / 4.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 3.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 1.0 / 2.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 5.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 3.0 / 4.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 7.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+    ];
+    const LEGACY_PRESENTATION_MIDDLE: &[&[[f64; 4]]] = &[
+        &[[0.0, 0.0, 4.0 / 5.0, 1.0]],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 5.0, 1.0 / 4.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 5.0, 1.0 / 4.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 5.0, 1.0 / 4.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 5.0, 1.0 / 4.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 5.0, 1.0 / 4.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 5.0, 1.0 / 4.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 5.0, 1.0 / 4.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 5.0, 1.0 / 4.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 5.0, 1.0 / 4.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 5.0, 1.0 / 4.0],
+        ],
+        &[
+            [6.0 / 7.0, 0.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 1.0 / 6.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 1.0 / 3.0, 1.0 / 7.0, 1.0 / 6.0],
+            [0.0, 0.0, 6.0 / 7.0, 1.0],
+            [6.0 / 7.0, 1.0 / 2.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 2.0 / 3.0, 1.0 / 7.0, 1.0 / 6.0],
+        ],
+        &[
+            [6.0 / 7.0, 0.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 1.0 / 6.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 1.0 / 3.0, 1.0 / 7.0, 1.0 / 6.0],
+            [0.0, 0.0, 6.0 / 7.0, 1.0],
+            [6.0 / 7.0, 1.0 / 2.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 2.0 / 3.0, 1.0 / 7.0, 1.0 / 6.0],
+            [6.0 / 7.0, 5.0 / 6.0, 1.0 / 7.0, 1.0 / 6.0],
+        ],
+        &[
+            [8.0 / 9.0, 0.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 1.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 1.0 / 4.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 3.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [0.0, 0.0, 9.0 / 5.0, 1.0],
+            [8.0 / 9.0, 1.0 / 2.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 5.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 3.0 / 4.0, 1.0 / 9.0, 1.0 / 8.0],
+        ],
+        &[
+            [8.0 / 9.0, 0.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 1.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 1.0 / 4.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 3.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [0.0, 0.0, 9.0 / 5.0, 1.0],
+            [8.0 / 9.0, 1.0 / 2.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 5.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 3.0 / 4.0, 1.0 / 9.0, 1.0 / 8.0],
+            [8.0 / 9.0, 7.0 / 8.0, 1.0 / 9.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+        &[
+            [4.0 / 5.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [4.0 / 5.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [0.0, 0.0, 4.0 / 5.0, 1.0],
+            [9.0 / 10.0, 0.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 1.0 / 2.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 5.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 3.0 / 4.0, 1.0 / 10.0, 1.0 / 8.0],
+            [9.0 / 10.0, 7.0 / 8.0, 1.0 / 10.0, 1.0 / 8.0],
+        ],
+    ];
+
+    fn solved_regions(mode: LayoutMode, count: u32, max_slot: i32) -> Vec<[f64; 4]> {
+        let presentation = mode == LayoutMode::VerticalPresentation;
+        let mut regions = vec![Region::default(); count as usize];
+        let regions_ptr = regions.as_mut_ptr();
+        let len = unsafe {
+            cpp!([presentation as "bool", count as "uint32_t", max_slot as "int",
+                    regions_ptr as "agora::linuxsdk::VideoMixingLayout::Region*"] -> usize as "size_t" {
+                agora::LayoutTemplate layout;
+                if (presentation)
+                    agora::solvePresentationLayout(count, max_slot, layout);
+                else
+                    agora::solveBestFitLayout(count, layout);
+                size_t len = std::min<size_t>(count, layout.m_regions.size());
+                std::copy(layout.m_regions.begin(), layout.m_regions.begin() + len, regions_ptr);
+                return len;
+            })
+        };
+        regions.truncate(len);
+        regions
+            .iter()
+            .map(|r| [r.x(), r.y(), r.width(), r.height()])
+            .collect()
+    }
+
+    fn assert_same_regions(solved: &[[f64; 4]], legacy: &[[f64; 4]], case: &str) {
+        assert_eq!(solved.len(), legacy.len(), "{}", case);
+        for (slot, (s, l)) in solved.iter().zip(legacy).enumerate() {
+            for i in 0..4 {
+                assert!(
+                    (s[i] - l[i]).abs() < 1e-6,
+                    "{} slot {}: {:?} != {:?}",
+                    case,
+                    slot,
+                    s,
+                    l
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn layout_solver_matches_legacy() {
+        for count in 1..=17 {
+            let solved = solved_regions(LayoutMode::BestFit, count, -1);
+            let legacy = LEGACY_BEST_FIT[count as usize - 1];
+            assert_same_regions(&solved, legacy, &format!("best fit {}", count));
+        }
+        // with 17 tiles and no max uid the old strip dropped the last one
+        for count in 1..=16 {
+            let solved = solved_regions(LayoutMode::VerticalPresentation, count, -1);
+            let legacy = LEGACY_PRESENTATION[count as usize - 1];
+            assert_same_regions(&solved, legacy, &format!("presentation {}", count));
+        }
+        for count in 1..=17 {
+            let max_slot = count / 2;
+            let solved = solved_regions(LayoutMode::VerticalPresentation, count, max_slot as i32);
+            let mut legacy = LEGACY_PRESENTATION_MIDDLE[count as usize - 1].to_vec();
+            // the old large tile ran 9/5 of the canvas wide next to a strip of
+            // 7 or 8; it now ends where the strip starts
+            if count == 8 || count == 9 {
+                assert_eq!(legacy[max_slot as usize][2], 9.0 / 5.0);
+                legacy[max_slot as usize][2] = 8.0 / 9.0;
+            }
+            assert_same_regions(
+                &solved,
+                &legacy,
+                &format!("presentation {} max {}", count, max_slot),
+            );
+        }
+    }
+
+    #[test]
+    fn layout_solver_regions_disjoint() {
+        let cases = [
+            (LayoutMode::BestFit, -1),
+            (LayoutMode::VerticalPresentation, -1),
+            (LayoutMode::VerticalPresentation, 0),
+        ];
+        for &(mode, max_slot) in &cases {
+            for count in 18..=64 {
+                let regions = solved_regions(mode, count, max_slot);
+                assert_eq!(regions.len(), count as usize);
+                for (i, a) in regions.iter().enumerate() {
+                    assert!(a[2] > 0.0 && a[3] > 0.0, "{} of {}: {:?}", i, count, a);
+                    assert!(a[0] >= 0.0 && a[1] >= 0.0, "{} of {}: {:?}", i, count, a);
+                    assert!(a[0] + a[2] <= 1.0 + 1e-9 && a[1] + a[3] <= 1.0 + 1e-9);
+                    for b in &regions[i + 1..] {
+                        let apart = a[0] + a[2] <= b[0] + 1e-9
+                            || b[0] + b[2] <= a[0] + 1e-9
+                            || a[1] + a[3] <= b[1] + 1e-9
+                            || b[1] + b[3] <= a[1] + 1e-9;
+                        assert!(apart, "{} tiles: {:?} overlaps {:?}", count, a, b);
+                    }
+                }
+            }
+        }
+    }
+
     #[test]
     fn config_mixing_enabled() {
         let config = Config::new();
@@ -1081,6 +4239,423 @@ mod tests {
         assert!(config.mix_resolution().3 == 2000);
     }
 
+    #[test]
+    fn config_set_decode_video() {
+        let config = Config::new();
+        config.set_decode_video(VideoFormat::YuvFrame);
+        assert!(config.decode_video() == VideoFormat::YuvFrame);
+    }
+
+    #[test]
+    fn video_frame_retain() {
+        let y = [1u8; 16];
+        let u = [2u8; 4];
+        let v = [3u8; 4];
+        let raw = RawVideoFrame {
+            kind: 0,
+            rotation: 90,
+            frame_ms: 40,
+            frame_num: 0,
+            width: 4,
+            height: 4,
+            y_stride: 4,
+            u_stride: 2,
+            v_stride: 2,
+            buf_size: 0,
+            buf: std::ptr::null(),
+            y: y.as_ptr(),
+            u: u.as_ptr(),
+            v: v.as_ptr(),
+        };
+        let frame = unsafe { VideoFrame::from_raw(&raw) }.unwrap();
+        assert!(frame.frame_type() == VideoFrameType::Yuv);
+        let owned = frame.retain();
+        match owned.view().data {
+            VideoFrameData::Yuv(planes) => {
+                assert!(planes.y == &y[..]);
+                assert!(planes.u == &u[..]);
+                assert!(planes.v == &v[..]);
+            }
+            _ => panic!("expected a yuv frame"),
+        }
+        assert!(owned.view().rotation == 90);
+    }
+
+    #[test]
+    fn frame_buffer_recycled() {
+        let before = frame_pool_stats();
+        let buffer = FrameBuffer::gather(&[&[1u8, 2], &[3u8]]);
+        assert!(&buffer[..] == &[1u8, 2, 3][..]);
+        let shared = buffer.clone();
+        drop(buffer);
+        assert!(shared.as_slice() == &[1u8, 2, 3][..]);
+        drop(shared);
+        let again = FrameBuffer::gather(&[&[4u8; 16]]);
+        let after = frame_pool_stats();
+        assert!(after.hits > before.hits);
+        assert!(after.high_water >= 1);
+        drop(again);
+    }
+
+    #[test]
+    fn frame_queue_drop_newest() {
+        let queue = FrameQueue::new(2, OverflowPolicy::DropNewest);
+        let raw = queue.raw;
+        for uid in [7u32, 7, 9].iter().cloned() {
+            unsafe {
+                cpp!([raw as "agora::FrameQueue*", uid as "uint32_t"] {
+                    unsigned char pcm[4] = {1, 2, 3, 4};
+                    agora::AudioFrameView view = agora::AudioFrameView();
+                    view.kind = agora::linuxsdk::AUDIO_FRAME_RAW_PCM;
+                    view.buf = pcm;
+                    view.buf_size = sizeof(pcm);
+                    raw->pushAudio(uid, view);
+                })
+            }
+        }
+        let stats = queue.stats();
+        assert!(stats.pushed == 2 && stats.dropped == 1);
+        assert!(queue.dropped_for(9) == 1);
+        assert!(queue.dropped_by_uid() == vec![(9, 1)]);
+
+        let frame = queue.try_recv().expect("queued frame");
+        assert!(frame.uid == 7);
+        match frame.media {
+            MediaFrame::Audio(audio) => assert!(audio.view().bytes() == &[1u8, 2, 3, 4][..]),
+            MediaFrame::Video(_) => panic!("expected audio"),
+        }
+        queue.close();
+        assert!(queue.recv_timeout(Duration::from_millis(10)).is_some());
+        assert!(queue.recv_timeout(Duration::from_millis(10)).is_none());
+    }
+
+    #[test]
+    fn recorder_media_stats_empty() {
+        let sdk = AgoraSdk::new();
+        assert!(sdk.media_stats().is_empty());
+    }
+
+    #[test]
+    fn recorder_recent_media_empty() {
+        let sdk = AgoraSdk::new();
+        sdk.set_media_keep_time(30_000);
+        assert!(sdk.recent_media(1, Duration::from_secs(30)).is_empty());
+        assert!(sdk.retained_uids().is_empty());
+    }
+
+    #[test]
+    fn recorder_fake_engine() {
+        use std::sync::atomic::{AtomicUsize, Ordering};
+        use std::sync::Arc;
+
+        struct CountingListener {
+            joined: Arc<AtomicUsize>,
+            frames: Arc<AtomicUsize>,
+        }
+        impl Listener for CountingListener {
+            fn error(&self, _error: u32, _stat_code: u32) {}
+            fn joined(&mut self, _uid: u32) {
+                self.joined.fetch_add(1, Ordering::Relaxed);
+            }
+            fn left(&mut self, _uid: u32) {}
+            fn channel_joined(&mut self, _channel: String, _uid: u32) {}
+            fn video_frame(&mut self, _uid: u32, _frame: &VideoFrame) {
+                self.frames.fetch_add(1, Ordering::Relaxed);
+            }
+        }
+
+        let joined = Arc::new(AtomicUsize::new(0));
+        let frames = Arc::new(AtomicUsize::new(0));
+        let mut sdk = AgoraSdk::new();
+        sdk.set_listener(Box::new(CountingListener {
+            joined: joined.clone(),
+            frames: frames.clone(),
+        }));
+        sdk.use_fake_engine(&FakeEngineConfig {
+            users: 4,
+            ..FakeEngineConfig::default()
+        });
+        let config = Config::new();
+        config.set_decode_video(VideoFormat::EncodedFrame);
+        assert!(sdk.create_channel("", "", "fake", 1, &config));
+        wait_until(|| {
+            joined.load(Ordering::Relaxed) == 4
+                && frames.load(Ordering::Relaxed) >= 4
+                && sdk.media_stats().len() == 4
+        });
+        assert!(sdk.leave_channel());
+        assert_eq!(sdk.pending_events(), 0);
+        assert_eq!(joined.load(Ordering::Relaxed), 4);
+        assert!(frames.load(Ordering::Relaxed) >= 4);
+        let events = event_executor_stats();
+        assert!(events.workers >= 1);
+        assert!(events.posted >= 8);
+        assert_eq!(sdk.media_stats().len(), 4);
+    }
+
+    #[test]
+    fn recorder_queued_frames() {
+        use std::sync::atomic::{AtomicUsize, Ordering};
+        use std::sync::Arc;
+
+        struct QueuedListener {
+            shared: Arc<AtomicUsize>,
+            copied: Arc<AtomicUsize>,
+        }
+        impl Listener for QueuedListener {
+            fn error(&self, _error: u32, _stat_code: u32) {}
+            fn joined(&mut self, _uid: u32) {}
+            fn left(&mut self, _uid: u32) {}
+            fn channel_joined(&mut self, _channel: String, _uid: u32) {}
+            fn queued_frames(&self) -> bool {
+                true
+            }
+            fn video_frame(&mut self, _uid: u32, frame: &VideoFrame) {
+                let retained = frame.retain();
+                let bytes = |data: VideoFrameData| match data {
+                    VideoFrameData::H264 { data, .. } => data.as_ptr(),
+                    _ => ptr::null(),
+                };
+                let data = bytes(frame.data);
+                let same = !data.is_null() && data == bytes(retained.view().data);
+                let count = if same { &self.shared } else { &self.copied };
+                count.fetch_add(1, Ordering::Relaxed);
+            }
+        }
+
+        let shared = Arc::new(AtomicUsize::new(0));
+        let copied = Arc::new(AtomicUsize::new(0));
+        let mut sdk = AgoraSdk::new();
+        sdk.set_listener(Box::new(QueuedListener {
+            shared: shared.clone(),
+            copied: copied.clone(),
+        }));
+        sdk.use_fake_engine(&FakeEngineConfig {
+            users: 2,
+            ..FakeEngineConfig::default()
+        });
+        let config = Config::new();
+        config.set_decode_video(VideoFormat::EncodedFrame);
+        assert!(sdk.create_channel("", "", "fake", 1, &config));
+        wait_until(|| shared.load(Ordering::Relaxed) >= 4);
+        assert!(sdk.leave_channel());
+        assert_eq!(copied.load(Ordering::Relaxed), 0);
+    }
+
+    #[test]
+    fn recorder_stats_batching() {
+        use std::sync::atomic::{AtomicUsize, Ordering};
+        use std::sync::Arc;
+
+        struct BatchListener {
+            batches: Arc<AtomicUsize>,
+            samples: Arc<AtomicUsize>,
+        }
+        impl Listener for BatchListener {
+            fn error(&self, _error: u32, _stat_code: u32) {}
+            fn joined(&mut self, _uid: u32) {}
+            fn left(&mut self, _uid: u32) {}
+            fn channel_joined(&mut self, _channel: String, _uid: u32) {}
+            fn stats_batch(&mut self, batch: &StatsBatch) {
+                assert!(!batch.is_empty());
+                let video = batch.remote_video();
+                assert_eq!(video.uid.len(), video.width.len());
+                assert!(batch.volumes().uid.len() <= 64);
+                self.batches.fetch_add(1, Ordering::Relaxed);
+                self.samples.fetch_add(batch.len(), Ordering::Relaxed);
+            }
+        }
+
+        let batches = Arc::new(AtomicUsize::new(0));
+        let samples = Arc::new(AtomicUsize::new(0));
+        let mut sdk = AgoraSdk::new();
+        sdk.set_listener(Box::new(BatchListener {
+            batches: batches.clone(),
+            samples: samples.clone(),
+        }));
+        sdk.set_stats_batching(64, Duration::from_millis(200));
+        sdk.use_fake_engine(&FakeEngineConfig {
+            users: 8,
+            video_fps: 0,
+            audio_frame_ms: 0,
+            stats_interval_ms: 50,
+            ..FakeEngineConfig::default()
+        });
+        let config = Config::new();
+        config.set_audio_indication_interval(50);
+        assert!(sdk.create_channel("", "", "fake", 1, &config));
+        wait_until(|| batches.load(Ordering::Relaxed) >= 1);
+        assert!(sdk.leave_channel());
+        let batches = batches.load(Ordering::Relaxed);
+        assert!(batches >= 1);
+        assert!(samples.load(Ordering::Relaxed) >= 8 * batches);
+    }
+
+    #[test]
+    fn recorder_event_stream() {
+        use std::future::Future;
+        use std::sync::Arc;
+        use std::task::{Context, Poll, Wake};
+
+        struct Unpark(thread::Thread);
+        impl Wake for Unpark {
+            fn wake(self: Arc<Self>) {
+                self.0.unpark()
+            }
+        }
+        fn block_on<F: Future>(future: F) -> F::Output {
+            let mut future = Box::pin(future);
+            let waker = Arc::new(Unpark(thread::current())).into();
+            let mut cx = Context::from_waker(&waker);
+            loop {
+                if let Poll::Ready(output) = future.as_mut().poll(&mut cx) {
+                    return output;
+                }
+                thread::park();
+            }
+        }
+
+        let mut sdk = AgoraSdk::new();
+        let mut stream = sdk.event_stream(false).unwrap();
+        assert!(sdk.event_stream(false).is_none());
+        sdk.use_fake_engine(&FakeEngineConfig {
+            users: 3,
+            ..FakeEngineConfig::default()
+        });
+        assert!(sdk.create_channel("", "", "fake", 1, &Config::new()));
+        assert_eq!(block_on(stream.joined()), Ok(("fake".to_string(), 1)));
+        let mut users = 0;
+        while users < 3 {
+            if let Some(Event::UserJoined { .. }) = block_on(stream.recv()) {
+                users += 1;
+            }
+        }
+        assert!(sdk.leave_channel());
+        drop(sdk);
+        while block_on(stream.recv()).is_some() {}
+    }
+
+    #[test]
+    fn recorder_handler_events() {
+        use std::sync::{Arc, Mutex};
+
+        struct EventListener {
+            events: Arc<Mutex<Vec<RecorderEvent>>>,
+        }
+        impl Listener for EventListener {
+            fn error(&self, _error: u32, _stat_code: u32) {}
+            fn joined(&mut self, _uid: u32) {}
+            fn left(&mut self, _uid: u32) {}
+            fn channel_joined(&mut self, _channel: String, _uid: u32) {}
+            fn event(&mut self, event: RecorderEvent) {
+                self.events.lock().unwrap().push(event);
+            }
+        }
+
+        let events = Arc::new(Mutex::new(Vec::new()));
+        let mut sdk = AgoraSdk::new();
+        sdk.set_listener(Box::new(EventListener {
+            events: events.clone(),
+        }));
+        sdk.use_fake_engine(&FakeEngineConfig {
+            users: 4,
+            video_fps: 0,
+            audio_frame_ms: 0,
+            ..FakeEngineConfig::default()
+        });
+        assert!(sdk.create_channel("", "", "fake", 1, &Config::new()));
+        // each peer's first video frame is the last of its join events
+        wait_until(|| {
+            let events = events.lock().unwrap();
+            events
+                .iter()
+                .filter(|e| matches!(e, RecorderEvent::FirstRemoteVideoDecoded { .. }))
+                .count()
+                == 4
+        });
+        assert!(sdk.leave_channel());
+
+        let events = events.lock().unwrap();
+        let count = |f: &dyn Fn(&RecorderEvent) -> bool| events.iter().filter(|e| f(e)).count();
+        match events[0] {
+            RecorderEvent::ChannelJoined { channel, uid } => {
+                assert_eq!(&*channel, "fake");
+                assert_eq!(uid, 1);
+            }
+            other => panic!("unexpected first event {:?}", other),
+        }
+        assert_eq!(count(&|e| matches!(e, RecorderEvent::UserJoined { .. })), 4);
+        assert_eq!(count(&|e| matches!(e, RecorderEvent::FirstRemoteAudioFrame { .. })), 4);
+        assert_eq!(
+            count(&|e| matches!(e, RecorderEvent::FirstRemoteVideoDecoded { width, .. } if *width > 0)),
+            4
+        );
+        assert_eq!(
+            events.last(),
+            Some(&RecorderEvent::ChannelLeft { code: 1 << 4 })
+        );
+    }
+
+    #[test]
+    fn recorder_manager_sessions() {
+        let manager = RecorderManager::new(2);
+        let first = manager.create_session();
+        let second = manager.create_session();
+        assert_eq!(manager.len(), 2);
+        let id = manager.session_id(&first).unwrap();
+        assert!(manager.session_id(&second) != Some(id));
+        assert!(manager.session_id(&AgoraSdk::new()).is_none());
+        let stats = manager.session_stats(id).unwrap();
+        assert_eq!(stats.id, id);
+        assert!(!stats.running);
+        assert!(!manager.stop_session(id));
+        drop(first);
+        assert_eq!(manager.len(), 1);
+        assert!(manager.session_stats(id).is_none());
+        drop(manager);
+        second.set_layout_debounce_time(10);
+    }
+
+    #[test]
+    fn config_set_decode_audio() {
+        let config = Config::new();
+        config.set_decode_audio(AudioFormat::PcmFrame);
+        assert!(config.decode_audio() == AudioFormat::PcmFrame);
+    }
+
+    #[test]
+    fn audio_frame_channel_handoff() {
+        let pcm = [7u8; 320];
+        let raw = RawAudioFrame {
+            kind: 0,
+            channels: 1,
+            sample_bits: 16,
+            sample_rate: 16000,
+            samples: 160,
+            bitrate: 0,
+            frame_ms: 10,
+            buf_size: pcm.len() as u32,
+            buf: pcm.as_ptr(),
+        };
+        let frame = unsafe { AudioFrame::from_raw(&raw) }.unwrap();
+        let (mut producer, mut consumer) = audio_frame_channel(2, 320);
+        assert!(producer.push(1, &frame));
+        assert!(producer.push(2, &frame));
+        assert!(!producer.push(3, &frame));
+        assert!(producer.dropped() == 1);
+
+        let consumer_thread = thread::spawn(move || {
+            let mut uids = Vec::new();
+            while let Some(queued) = consumer.pop() {
+                assert!(queued.frame().bytes() == &pcm[..]);
+                assert!(queued.frame().frame_type() == AudioFrameType::Pcm);
+                uids.push(queued.uid());
+            }
+            uids
+        });
+        assert!(consumer_thread.join().unwrap() == vec![1, 2]);
+    }
+
     #[test]
     fn config_set_audio_indication_interval() {
         let config = Config::new();
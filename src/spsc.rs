@@ -0,0 +1,146 @@
+use std::cell::UnsafeCell;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::sync::Arc;
+
+use crate::frame::{AudioFrame, AudioFrameMeta};
+
+struct Slot {
+    uid: u32,
+    frame: AudioFrameMeta,
+    len: usize,
+    data: Box<[u8]>,
+}
+
+struct Ring {
+    slots: Box<[UnsafeCell<Slot>]>,
+    // next slot the producer writes / the consumer reads; both only ever grow
+    head: AtomicUsize,
+    tail: AtomicUsize,
+    dropped: AtomicU64,
+}
+
+// A slot is only touched by the producer before `head` publishes it and by the
+// consumer before `tail` hands it back, so the two sides never alias.
+unsafe impl Sync for Ring {}
+unsafe impl Send for Ring {}
+
+/// Creates a bounded, lock-free single-producer/single-consumer ring for handing
+/// audio frames from the SDK callback thread to one consumer thread.
+///
+/// All `capacity` slots are allocated up front with room for `max_frame_bytes`,
+/// so `push` only copies into an existing slot and never allocates or locks.
+pub fn audio_frame_channel(
+    capacity: usize,
+    max_frame_bytes: usize,
+) -> (AudioFrameProducer, AudioFrameConsumer) {
+    let capacity = capacity.max(1);
+    let slots = (0..capacity)
+        .map(|_| {
+            UnsafeCell::new(Slot {
+                uid: 0,
+                frame: AudioFrameMeta::default(),
+                len: 0,
+                data: vec![0u8; max_frame_bytes].into_boxed_slice(),
+            })
+        })
+        .collect::<Vec<_>>()
+        .into_boxed_slice();
+    let ring = Arc::new(Ring {
+        slots,
+        head: AtomicUsize::new(0),
+        tail: AtomicUsize::new(0),
+        dropped: AtomicU64::new(0),
+    });
+    (
+        AudioFrameProducer { ring: ring.clone() },
+        AudioFrameConsumer { ring },
+    )
+}
+
+pub struct AudioFrameProducer {
+    ring: Arc<Ring>,
+}
+
+impl AudioFrameProducer {
+    /// Copies `frame` into the next free slot. Returns false and counts the frame
+    /// as dropped when the ring is full or the frame is larger than a slot.
+    pub fn push(&mut self, uid: u32, frame: &AudioFrame) -> bool {
+        let ring = &*self.ring;
+        let head = ring.head.load(Ordering::Relaxed);
+        let tail = ring.tail.load(Ordering::Acquire);
+        let bytes = frame.bytes();
+        if head - tail == ring.slots.len() {
+            ring.dropped.fetch_add(1, Ordering::Relaxed);
+            return false;
+        }
+        let slot = unsafe { &mut *ring.slots[head % ring.slots.len()].get() };
+        if bytes.len() > slot.data.len() {
+            ring.dropped.fetch_add(1, Ordering::Relaxed);
+            return false;
+        }
+        slot.uid = uid;
+        slot.frame = AudioFrameMeta::from(frame);
+        slot.len = bytes.len();
+        slot.data[..bytes.len()].copy_from_slice(bytes);
+        ring.head.store(head + 1, Ordering::Release);
+        true
+    }
+
+    pub fn dropped(&self) -> u64 {
+        self.ring.dropped.load(Ordering::Relaxed)
+    }
+}
+
+pub struct AudioFrameConsumer {
+    ring: Arc<Ring>,
+}
+
+impl AudioFrameConsumer {
+    /// Borrows the oldest queued frame. The slot is returned to the producer when
+    /// the guard is dropped.
+    pub fn pop(&mut self) -> Option<QueuedAudioFrame> {
+        let ring = &*self.ring;
+        let tail = ring.tail.load(Ordering::Relaxed);
+        let head = ring.head.load(Ordering::Acquire);
+        if tail == head {
+            return None;
+        }
+        let slot = unsafe { &*ring.slots[tail % ring.slots.len()].get() };
+        Some(QueuedAudioFrame { ring, tail, slot })
+    }
+
+    pub fn len(&self) -> usize {
+        let head = self.ring.head.load(Ordering::Acquire);
+        head - self.ring.tail.load(Ordering::Relaxed)
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn dropped(&self) -> u64 {
+        self.ring.dropped.load(Ordering::Relaxed)
+    }
+}
+
+pub struct QueuedAudioFrame<'a> {
+    ring: &'a Ring,
+    tail: usize,
+    slot: &'a Slot,
+}
+
+impl<'a> QueuedAudioFrame<'a> {
+    pub fn uid(&self) -> u32 {
+        self.slot.uid
+    }
+
+    pub fn frame(&self) -> AudioFrame {
+        self.slot.frame.view(&self.slot.data[..self.slot.len])
+    }
+}
+
+impl<'a> Drop for QueuedAudioFrame<'a> {
+    fn drop(&mut self) {
+        self.ring.tail.store(self.tail + 1, Ordering::Release);
+    }
+}
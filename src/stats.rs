@@ -0,0 +1,190 @@
+use std::slice;
+
+// Mirrors agora::StatsBatchView.
+#[repr(C)]
+pub(crate) struct RawStatsBatch {
+    first_ms: u64,
+    last_ms: u64,
+
+    volumes: u32,
+    volume_ms: *const u64,
+    volume_uid: *const u32,
+    volume: *const u32,
+
+    video_stats: u32,
+    video_ms: *const u64,
+    video_uid: *const u32,
+    video_delay: *const i32,
+    video_width: *const i32,
+    video_height: *const i32,
+    video_bitrate: *const i32,
+    video_fps: *const i32,
+    video_stream_type: *const i32,
+
+    audio_stats: u32,
+    audio_ms: *const u64,
+    audio_uid: *const u32,
+    audio_quality: *const i32,
+    audio_network_delay: *const i32,
+    audio_jitter_delay: *const i32,
+    audio_loss_rate: *const i32,
+
+    recording_stats: u32,
+    recording_ms: *const u64,
+    recording_duration: *const u32,
+    recording_rx_bytes: *const u32,
+    recording_rx_kbitrate: *const u32,
+    recording_rx_audio_kbitrate: *const u32,
+    recording_rx_video_kbitrate: *const u32,
+    recording_lastmile_delay: *const u32,
+    recording_user_count: *const u32,
+    recording_cpu_app: *const f64,
+    recording_cpu_total: *const f64,
+}
+
+// Every column pointer is valid for `count` rows while the batch is borrowed.
+unsafe fn column<'a, T>(ptr: *const T, count: u32) -> &'a [T] {
+    if count == 0 || ptr.is_null() {
+        &[]
+    } else {
+        slice::from_raw_parts(ptr, count as usize)
+    }
+}
+
+/// `onAudioVolumeIndication` samples, one row per speaker per indication.
+pub struct VolumeColumns<'a> {
+    pub ms: &'a [u64],
+    pub uid: &'a [u32],
+    pub volume: &'a [u32],
+}
+
+/// `onRemoteVideoStats` samples.
+pub struct RemoteVideoColumns<'a> {
+    pub ms: &'a [u64],
+    pub uid: &'a [u32],
+    pub delay: &'a [i32],
+    pub width: &'a [i32],
+    pub height: &'a [i32],
+    pub received_bitrate: &'a [i32],
+    pub decoder_output_fps: &'a [i32],
+    pub stream_type: &'a [i32],
+}
+
+/// `onRemoteAudioStats` samples.
+pub struct RemoteAudioColumns<'a> {
+    pub ms: &'a [u64],
+    pub uid: &'a [u32],
+    pub quality: &'a [i32],
+    pub network_delay: &'a [i32],
+    pub jitter_buffer_delay: &'a [i32],
+    pub loss_rate: &'a [i32],
+}
+
+/// `onRecordingStats` samples.
+pub struct RecordingColumns<'a> {
+    pub ms: &'a [u64],
+    pub duration: &'a [u32],
+    pub rx_bytes: &'a [u32],
+    pub rx_kbitrate: &'a [u32],
+    pub rx_audio_kbitrate: &'a [u32],
+    pub rx_video_kbitrate: &'a [u32],
+    pub lastmile_delay: &'a [u32],
+    pub user_count: &'a [u32],
+    pub cpu_app_usage: &'a [f64],
+    pub cpu_total_usage: &'a [f64],
+}
+
+/// One flush of batched volume and stats callbacks, stored as columns. Row
+/// `i` of every slice in a group is the same sample, and `ms` is the steady
+/// clock time it arrived. Borrowed from the C++ batch, which is reused once
+/// the listener returns.
+pub struct StatsBatch<'a> {
+    raw: &'a RawStatsBatch,
+}
+
+impl<'a> StatsBatch<'a> {
+    pub(crate) fn from_raw(raw: &'a RawStatsBatch) -> Self {
+        StatsBatch { raw }
+    }
+
+    pub fn first_ms(&self) -> u64 {
+        self.raw.first_ms
+    }
+
+    pub fn last_ms(&self) -> u64 {
+        self.raw.last_ms
+    }
+
+    /// Samples of every kind in the batch.
+    pub fn len(&self) -> usize {
+        let raw = self.raw;
+        (raw.volumes + raw.video_stats + raw.audio_stats + raw.recording_stats) as usize
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn volumes(&self) -> VolumeColumns<'a> {
+        let raw = self.raw;
+        let n = raw.volumes;
+        unsafe {
+            VolumeColumns {
+                ms: column(raw.volume_ms, n),
+                uid: column(raw.volume_uid, n),
+                volume: column(raw.volume, n),
+            }
+        }
+    }
+
+    pub fn remote_video(&self) -> RemoteVideoColumns<'a> {
+        let raw = self.raw;
+        let n = raw.video_stats;
+        unsafe {
+            RemoteVideoColumns {
+                ms: column(raw.video_ms, n),
+                uid: column(raw.video_uid, n),
+                delay: column(raw.video_delay, n),
+                width: column(raw.video_width, n),
+                height: column(raw.video_height, n),
+                received_bitrate: column(raw.video_bitrate, n),
+                decoder_output_fps: column(raw.video_fps, n),
+                stream_type: column(raw.video_stream_type, n),
+            }
+        }
+    }
+
+    pub fn remote_audio(&self) -> RemoteAudioColumns<'a> {
+        let raw = self.raw;
+        let n = raw.audio_stats;
+        unsafe {
+            RemoteAudioColumns {
+                ms: column(raw.audio_ms, n),
+                uid: column(raw.audio_uid, n),
+                quality: column(raw.audio_quality, n),
+                network_delay: column(raw.audio_network_delay, n),
+                jitter_buffer_delay: column(raw.audio_jitter_delay, n),
+                loss_rate: column(raw.audio_loss_rate, n),
+            }
+        }
+    }
+
+    pub fn recording(&self) -> RecordingColumns<'a> {
+        let raw = self.raw;
+        let n = raw.recording_stats;
+        unsafe {
+            RecordingColumns {
+                ms: column(raw.recording_ms, n),
+                duration: column(raw.recording_duration, n),
+                rx_bytes: column(raw.recording_rx_bytes, n),
+                rx_kbitrate: column(raw.recording_rx_kbitrate, n),
+                rx_audio_kbitrate: column(raw.recording_rx_audio_kbitrate, n),
+                rx_video_kbitrate: column(raw.recording_rx_video_kbitrate, n),
+                lastmile_delay: column(raw.recording_lastmile_delay, n),
+                user_count: column(raw.recording_user_count, n),
+                cpu_app_usage: column(raw.recording_cpu_app, n),
+                cpu_total_usage: column(raw.recording_cpu_total, n),
+            }
+        }
+    }
+}